@@ -0,0 +1,214 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <cmath>
+#include <iomanip>
+#include <ctime>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+bench::Arguments::Arguments(int argc, char** argv) {
+    for(int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+
+        if(argument.rfind("--", 0) != 0) {
+            this->__positional.push_back(argument);
+
+            continue;
+        }
+
+        auto name = argument.substr(2);
+        auto equals = name.find('=');
+
+        if(equals != std::string::npos) {
+            this->__values[name.substr(0, equals)] = name.substr(equals + 1);
+        } else if(i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+            this->__values[name] = argv[++i];
+        } else {
+            this->__values[name] = "1";
+        }
+    }
+}
+
+bool bench::Arguments::has(const std::string& name) const {
+    return this->__values.find(name) != this->__values.end();
+}
+
+std::string bench::Arguments::get_string(const std::string& name, const std::string& fallback) const {
+    auto it = this->__values.find(name);
+
+    return it == this->__values.end() ? fallback : it->second;
+}
+
+long bench::Arguments::get_int(const std::string& name, long fallback) const {
+    auto it = this->__values.find(name);
+
+    if(it == this->__values.end()) return fallback;
+
+    try {
+        return std::stol(it->second);
+    } catch(const std::exception&) {
+        std::stringstream ss;
+
+        ss << "Argument --" << name << " expects an integer (got " << it->second << ").";
+
+        std::cout << ss.str() << std::endl;
+
+        throw std::runtime_error(ss.str());
+    }
+}
+
+double bench::Arguments::get_float(const std::string& name, double fallback) const {
+    auto it = this->__values.find(name);
+
+    if(it == this->__values.end()) return fallback;
+
+    try {
+        return std::stod(it->second);
+    } catch(const std::exception&) {
+        std::stringstream ss;
+
+        ss << "Argument --" << name << " expects a number (got " << it->second << ").";
+
+        std::cout << ss.str() << std::endl;
+
+        throw std::runtime_error(ss.str());
+    }
+}
+
+bench::Summary bench::summarize(std::vector<double> samples) {
+    Summary summary {};
+
+    summary.count = samples.size();
+
+    if(samples.empty()) return summary;
+
+    std::sort(samples.begin(), samples.end());
+
+    auto percentile = [&samples](double p) {
+        size_t index = (size_t) std::ceil(p * samples.size()) - 1;
+
+        return samples.at(std::min(index, samples.size() - 1));
+    };
+
+    double total = 0.0;
+
+    for(auto sample : samples) {
+        total += sample;
+    }
+
+    summary.mean = total / samples.size();
+    summary.min = samples.front();
+    summary.p50 = percentile(0.50);
+    summary.p90 = percentile(0.90);
+    summary.p95 = percentile(0.95);
+    summary.p99 = percentile(0.99);
+    summary.max = samples.back();
+
+    return summary;
+}
+
+std::string bench::json_string(const std::string& value) {
+    std::stringstream ss;
+
+    ss << '"';
+
+    for(auto c : value) {
+        switch(c) {
+            case '"': ss << "\\\""; break;
+            case '\\': ss << "\\\\"; break;
+            case '\n': ss << "\\n"; break;
+            case '\t': ss << "\\t"; break;
+            default:
+                if((unsigned char) c < 0x20) {
+                    ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int) c << std::dec;
+                } else {
+                    ss << c;
+                }
+        }
+    }
+
+    ss << '"';
+
+    return ss.str();
+}
+
+void bench::write_json(std::ostream& os, const Summary& summary) {
+    os  << "{ \"count\": " << summary.count
+        << ", \"mean\": " << summary.mean
+        << ", \"min\": " << summary.min
+        << ", \"p50\": " << summary.p50
+        << ", \"p90\": " << summary.p90
+        << ", \"p95\": " << summary.p95
+        << ", \"p99\": " << summary.p99
+        << ", \"max\": " << summary.max
+        << " }";
+}
+
+void bench::write_report(const Arguments& arguments, const std::string& report) {
+    auto path = arguments.get_string("out", "");
+
+    if(path.empty()) {
+        std::cout << report << std::endl;
+
+        return;
+    }
+
+    std::ofstream file(path);
+
+    if(!file) {
+        std::stringstream ss;
+
+        ss << "Cannot write report: " << path;
+
+        std::cout << ss.str() << std::endl;
+
+        throw std::runtime_error(ss.str());
+    }
+
+    file << report << std::endl;
+}
+
+size_t bench::peak_rss() {
+    #ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+
+        if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+
+        return counters.PeakWorkingSetSize;
+    #else
+        struct rusage usage;
+
+        if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+
+        #ifdef __APPLE__
+            return usage.ru_maxrss;
+        #else
+            // Linux reports kilobytes.
+            return usage.ru_maxrss * 1024;
+        #endif
+    #endif
+}
+
+double bench::cpu_time() {
+    #ifdef _WIN32
+        FILETIME creation, exit, kernel, user;
+
+        if(!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0.0;
+
+        auto seconds = [](FILETIME time) {
+            return (((unsigned long long) time.dwHighDateTime << 32) | time.dwLowDateTime) / 1.0e7;
+        };
+
+        return seconds(kernel) + seconds(user);
+    #else
+        // Process CPU time (all threads).
+        return (double) std::clock() / CLOCKS_PER_SEC;
+    #endif
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+#include <sstream>
+#include <chrono>
+
+/**
+ * Shared helpers for the benchmark targets.
+ */
+namespace bench {
+    /**
+     * Command line arguments in the `--name value` form.
+     */
+    class Arguments {
+        public:
+            Arguments(int argc, char** argv);
+
+            /**
+             * Was the argument given?
+             */
+            bool has(const std::string& name) const;
+
+            std::string get_string(const std::string& name, const std::string& fallback) const;
+
+            long get_int(const std::string& name, long fallback) const;
+
+            double get_float(const std::string& name, double fallback) const;
+
+            /**
+             * The arguments without a name (in order).
+             */
+            inline const std::vector<std::string>& positional() const { return this->__positional; }
+
+        private:
+            std::map<std::string, std::string> __values;
+
+            std::vector<std::string> __positional;
+    };
+
+    /**
+     * Summary of a list of samples.
+     */
+    struct Summary {
+        size_t count;
+        double mean;
+        double min;
+        double p50;
+        double p90;
+        double p95;
+        double p99;
+        double max;
+    };
+
+    /**
+     * Summarizes the samples (all zeros if empty).
+     */
+    Summary summarize(std::vector<double> samples);
+
+    /**
+     * Escapes a string for JSON.
+     */
+    std::string json_string(const std::string& value);
+
+    /**
+     * Writes a Summary as a JSON object.
+     */
+    void write_json(std::ostream& os, const Summary& summary);
+
+    /**
+     * Writes the JSON report to the `--out` path (or stdout).
+     */
+    void write_report(const Arguments& arguments, const std::string& report);
+
+    /**
+     * Peak resident set size of the process (in bytes, 0 if unknown).
+     */
+    size_t peak_rss();
+
+    /**
+     * CPU time used by all threads of the process (in seconds).
+     */
+    double cpu_time();
+
+    /**
+     * Seconds since an arbitrary point (steady clock).
+     */
+    inline double now() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
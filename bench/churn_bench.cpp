@@ -0,0 +1,155 @@
+#include <vector>
+#include <random>
+#include <sstream>
+#include <iostream>
+
+#include <pepng.h>
+
+#include "bench.hpp"
+
+/**
+ * Spawns and despawns short lived objects (projectiles: Object, Transform, Renderer and Material)
+ * with the default allocation and with the pools, and writes the timings as JSON.
+ *
+ * Usage: pepng_churn_bench [--live 10000] [--spawn 1000] [--frames 600] [--seed 1] [--out report.json]
+ */
+namespace {
+    struct ModeResult {
+        std::vector<double> spawn_ns;
+        std::vector<double> despawn_ns;
+        std::vector<double> frame_ms;
+        double wall;
+    };
+
+    std::shared_ptr<Object> spawn(std::shared_ptr<Model> model, std::shared_ptr<Texture> texture, glm::vec3 position) {
+        auto object = pepng::make_object("Projectile");
+
+        object->attach_component(pepng::make_transform(position, glm::vec3(0.0f), glm::vec3(0.1f)));
+        object->attach_component(pepng::make_renderer(model, pepng::make_material(0, texture)));
+
+        return object;
+    }
+
+    /**
+     * Keeps `live` objects alive and replaces `spawnCount` of them (in random order) every frame.
+     */
+    ModeResult run_mode(bool pooled, size_t live, size_t spawnCount, size_t frames, unsigned int seed) {
+        Pool::set_enabled(pooled);
+
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> unit(-100.0f, 100.0f);
+
+        // Shared by every projectile (only the per-object allocations are measured).
+        auto model = pepng::make_model();
+        auto texture = pepng::make_texture(1);
+
+        std::vector<std::shared_ptr<Object>> objects;
+
+        objects.reserve(live);
+
+        for(size_t i = 0; i < live; i++) {
+            objects.push_back(spawn(model, texture, glm::vec3(unit(random), unit(random), unit(random))));
+        }
+
+        ModeResult result;
+
+        auto start = bench::now();
+
+        for(size_t frame = 0; frame < frames; frame++) {
+            auto frameStart = bench::now();
+
+            std::vector<size_t> slots;
+
+            for(size_t i = 0; i < spawnCount; i++) {
+                slots.push_back(random() % live);
+            }
+
+            auto despawnStart = bench::now();
+
+            for(auto slot : slots) {
+                objects.at(slot) = nullptr;
+            }
+
+            auto spawnStart = bench::now();
+
+            for(auto slot : slots) {
+                if(objects.at(slot) == nullptr) {
+                    objects.at(slot) = spawn(model, texture, glm::vec3(unit(random), unit(random), unit(random)));
+                }
+            }
+
+            auto end = bench::now();
+
+            result.despawn_ns.push_back((spawnStart - despawnStart) * 1.0e9 / spawnCount);
+            result.spawn_ns.push_back((end - spawnStart) * 1.0e9 / spawnCount);
+            result.frame_ms.push_back((end - frameStart) * 1.0e3);
+        }
+
+        result.wall = bench::now() - start;
+
+        return result;
+    }
+
+    void write_mode(std::ostream& os, const std::string& name, const ModeResult& result) {
+        os << "    {\n"
+           << "      \"mode\": " << bench::json_string(name) << ",\n"
+           << "      \"wall_s\": " << result.wall << ",\n"
+           << "      \"spawn_ns_per_object\": ";
+
+        bench::write_json(os, bench::summarize(result.spawn_ns));
+
+        os << ",\n      \"despawn_ns_per_object\": ";
+
+        bench::write_json(os, bench::summarize(result.despawn_ns));
+
+        os << ",\n      \"frame_ms\": ";
+
+        bench::write_json(os, bench::summarize(result.frame_ms));
+
+        os << "\n    }";
+    }
+}
+
+int main(int argc, char** argv) {
+    bench::Arguments arguments(argc, argv);
+
+    size_t live = arguments.get_int("live", 10000);
+    size_t spawnCount = arguments.get_int("spawn", 1000);
+    size_t frames = arguments.get_int("frames", 600);
+    unsigned int seed = arguments.get_int("seed", 1);
+
+    if(live == 0 || spawnCount == 0) {
+        std::cout << "--live and --spawn must be positive." << std::endl;
+
+        return 1;
+    }
+
+    // Default first, so the pools do not start with blocks the default path freed.
+    auto defaultResult = run_mode(false, live, spawnCount, frames, seed);
+    auto pooledResult = run_mode(true, live, spawnCount, frames, seed);
+
+    std::stringstream report;
+
+    report  << "{\n"
+            << "  \"benchmark\": \"churn\",\n"
+            << "  \"live\": " << live << ",\n"
+            << "  \"spawn_per_frame\": " << spawnCount << ",\n"
+            << "  \"frames\": " << frames << ",\n"
+            << "  \"modes\": [\n";
+
+    write_mode(report, "default", defaultResult);
+
+    report << ",\n";
+
+    write_mode(report, "pooled", pooledResult);
+
+    report  << "\n  ],\n"
+            << "  \"pool_reserved_bytes\": " << Pool::reserved_bytes() << ",\n"
+            << "  \"pool_used_bytes\": " << Pool::used_bytes() << ",\n"
+            << "  \"peak_rss_bytes\": " << bench::peak_rss() << "\n"
+            << "}";
+
+    bench::write_report(arguments, report.str());
+
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <thread>
+#include <sstream>
+#include <iostream>
+
+#include <pepng.h>
+
+#include "bench.hpp"
+
+/**
+ * Compares resolving transforms through handles with copying their shared_ptr (in random order),
+ * on one thread and on every hardware thread (where the shared reference counts contend), and writes the timings as JSON.
+ *
+ * Usage: pepng_handle_bench [--objects 100000] [--passes 50] [--seed 1] [--out report.json]
+ */
+namespace {
+    struct ModeResult {
+        std::vector<double> resolve_ns;
+        double checksum;
+    };
+
+    /**
+     * Runs `passes` passes of `resolve` over the order on `threads` threads.
+     */
+    template <typename F>
+    ModeResult run_mode(const std::vector<size_t>& order, size_t passes, size_t threads, F resolve) {
+        ModeResult result;
+
+        result.checksum = 0.0;
+
+        for(size_t pass = 0; pass < passes; pass++) {
+            std::vector<double> sums(threads, 0.0);
+            std::vector<std::thread> workers;
+
+            auto start = bench::now();
+
+            for(size_t thread = 0; thread < threads; thread++) {
+                workers.emplace_back([&order, &sums, &resolve, thread]() {
+                    double sum = 0.0;
+
+                    for(auto i : order) {
+                        sum += resolve(i);
+                    }
+
+                    sums.at(thread) = sum;
+                });
+            }
+
+            for(auto& worker : workers) {
+                worker.join();
+            }
+
+            auto end = bench::now();
+
+            for(auto sum : sums) {
+                result.checksum += sum;
+            }
+
+            result.resolve_ns.push_back((end - start) * 1.0e9 / order.size());
+        }
+
+        return result;
+    }
+
+    void write_mode(std::ostream& os, const std::string& name, size_t threads, const ModeResult& result) {
+        os << "    {\n"
+           << "      \"mode\": " << bench::json_string(name) << ",\n"
+           << "      \"threads\": " << threads << ",\n"
+           << "      \"checksum\": " << result.checksum << ",\n"
+           << "      \"resolve_ns\": ";
+
+        bench::write_json(os, bench::summarize(result.resolve_ns));
+
+        os << "\n    }";
+    }
+}
+
+int main(int argc, char** argv) {
+    bench::Arguments arguments(argc, argv);
+
+    size_t objectCount = arguments.get_int("objects", 100000);
+    size_t passes = arguments.get_int("passes", 50);
+    unsigned int seed = arguments.get_int("seed", 1);
+
+    if(objectCount == 0 || passes == 0) {
+        std::cout << "--objects and --passes must be positive." << std::endl;
+
+        return 1;
+    }
+
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> unit(-100.0f, 100.0f);
+
+    std::vector<std::shared_ptr<Object>> objects;
+    std::vector<std::shared_ptr<Transform>> pointers;
+    std::vector<Handle<Transform>> handles;
+
+    for(size_t i = 0; i < objectCount; i++) {
+        auto object = pepng::make_object("Object");
+
+        object->attach_component(pepng::make_transform(glm::vec3(unit(random), unit(random), unit(random))));
+
+        objects.push_back(object);
+        pointers.push_back(object->get_component<Transform>());
+        handles.push_back(object->get_handle<Transform>());
+    }
+
+    std::vector<size_t> order(objectCount);
+
+    for(size_t i = 0; i < objectCount; i++) {
+        order.at(i) = i;
+    }
+
+    std::shuffle(order.begin(), order.end(), random);
+
+    auto copyPointer = [&pointers](size_t i) {
+        auto transform = pointers.at(i);
+
+        return (double) transform->position.x;
+    };
+
+    auto resolveHandle = [&handles](size_t i) {
+        auto transform = handles.at(i).get();
+
+        return (double) transform->position.x;
+    };
+
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::stringstream report;
+
+    report  << "{\n"
+            << "  \"benchmark\": \"handle\",\n"
+            << "  \"objects\": " << objectCount << ",\n"
+            << "  \"passes\": " << passes << ",\n"
+            << "  \"modes\": [\n";
+
+    write_mode(report, "shared_ptr", 1, run_mode(order, passes, 1, copyPointer));
+
+    report << ",\n";
+
+    write_mode(report, "handle", 1, run_mode(order, passes, 1, resolveHandle));
+
+    report << ",\n";
+
+    write_mode(report, "shared_ptr", threads, run_mode(order, passes, threads, copyPointer));
+
+    report << ",\n";
+
+    write_mode(report, "handle", threads, run_mode(order, passes, threads, resolveHandle));
+
+    report  << "\n  ],\n"
+            << "  \"peak_rss_bytes\": " << bench::peak_rss() << "\n"
+            << "}";
+
+    bench::write_report(arguments, report.str());
+
+    return 0;
+}
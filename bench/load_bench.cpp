@@ -0,0 +1,448 @@
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <iterator>
+
+#include <pepng.h>
+
+#include "bench.hpp"
+
+/**
+ * Times the asset loaders on generated assets of increasing size (and on corpus files) and writes the results as JSON.
+ *
+ * Usage: pepng_load_bench [--triangles 1000,10000,100000] [--objects 8] [--texture-sizes 256,1024,2048]
+ *                         [--repeat 5] [--dir generated/] [--out report.json] [corpus files (.obj, .dae, images)...]
+ */
+namespace {
+    /**
+     * Result of one timed load.
+     */
+    struct Sample {
+        double wall;
+        double cpu;
+        size_t vertices;
+        pepng::extra::ColladaTimings collada;
+    };
+
+    /**
+     * Parses a comma separated list of integers.
+     */
+    std::vector<long> parse_list(const std::string& list) {
+        std::vector<long> values;
+        std::stringstream ss(list);
+        std::string value;
+
+        while(std::getline(ss, value, ',')) {
+            if(!value.empty()) {
+                values.push_back(std::stol(value));
+            }
+        }
+
+        return values;
+    }
+
+    std::ofstream open_output(const std::filesystem::path& path) {
+        std::ofstream file(path);
+
+        if(!file) {
+            std::stringstream ss;
+
+            ss << "Cannot write asset: " << path.string();
+
+            std::cout << ss.str() << std::endl;
+
+            throw std::runtime_error(ss.str());
+        }
+
+        return file;
+    }
+
+    /**
+     * Side of the grid with at least `triangles` triangles (two per cell).
+     */
+    size_t grid_side(size_t triangles) {
+        size_t side = 1;
+
+        while(side * side * 2 < triangles) {
+            side++;
+        }
+
+        return side;
+    }
+
+    /**
+     * Writes `objects` grids of `triangles` triangles as OBJ.
+     *
+     * @return The number of rendered vertices.
+     */
+    size_t write_obj(const std::filesystem::path& path, size_t objects, size_t triangles) {
+        auto file = open_output(path);
+        size_t side = grid_side(triangles);
+        size_t base = 1;
+
+        for(size_t object = 0; object < objects; object++) {
+            file << "o Grid" << object << "\n";
+
+            for(size_t y = 0; y <= side; y++) {
+                for(size_t x = 0; x <= side; x++) {
+                    file << "v " << x << " " << object << " " << y << "\n";
+                }
+            }
+
+            for(size_t y = 0; y <= side; y++) {
+                for(size_t x = 0; x <= side; x++) {
+                    file << "vt " << (float) x / side << " " << (float) y / side << "\n";
+                }
+            }
+
+            file << "vn 0 1 0\n";
+
+            auto corner = [base, side](size_t x, size_t y) {
+                auto index = base + y * (side + 1) + x;
+
+                std::stringstream ss;
+
+                ss << index << "/" << index << "/1";
+
+                return ss.str();
+            };
+
+            for(size_t y = 0; y < side; y++) {
+                for(size_t x = 0; x < side; x++) {
+                    file << "f " << corner(x, y) << " " << corner(x, y + 1) << " " << corner(x + 1, y + 1) << "\n";
+                    file << "f " << corner(x, y) << " " << corner(x + 1, y + 1) << " " << corner(x + 1, y) << "\n";
+                }
+            }
+
+            base += (side + 1) * (side + 1);
+        }
+
+        // OBJ normals are global, so every object refers to the first one.
+        return objects * side * side * 6;
+    }
+
+    /**
+     * Writes an uncompressed 32 bit TGA (decoded by stb_image like the other formats).
+     */
+    void write_tga(const std::filesystem::path& path, size_t size) {
+        auto file = open_output(path);
+
+        unsigned char header[18] = {};
+
+        header[2] = 2;
+        header[12] = size & 0xFF;
+        header[13] = (size >> 8) & 0xFF;
+        header[14] = size & 0xFF;
+        header[15] = (size >> 8) & 0xFF;
+        header[16] = 32;
+        header[17] = 8;
+
+        file.write((const char*) header, sizeof(header));
+
+        std::vector<unsigned char> row(size * 4);
+
+        for(size_t y = 0; y < size; y++) {
+            for(size_t x = 0; x < size; x++) {
+                row[x * 4 + 0] = x & 0xFF;
+                row[x * 4 + 1] = y & 0xFF;
+                row[x * 4 + 2] = (x ^ y) & 0xFF;
+                row[x * 4 + 3] = 0xFF;
+            }
+
+            file.write((const char*) row.data(), row.size());
+        }
+    }
+
+    /**
+     * Writes `objects` textured grids of `triangles` triangles as COLLADA (in the subset read by collada_load).
+     *
+     * @return The number of rendered vertices.
+     */
+    size_t write_dae(const std::filesystem::path& path, size_t objects, size_t triangles, const std::string& texture) {
+        auto file = open_output(path);
+        size_t side = grid_side(triangles);
+        size_t points = (side + 1) * (side + 1);
+
+        file << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+             << "<COLLADA xmlns=\"http://www.collada.org/2005/11/COLLADASchema\" version=\"1.4.1\">\n"
+             << "  <library_images><image id=\"Texture\" name=\"Texture\"><init_from>" << texture << "</init_from></image></library_images>\n"
+             << "  <library_effects><effect id=\"Effect\"><profile_COMMON>"
+             << "<newparam sid=\"Surface\"><surface type=\"2D\"><init_from>Texture</init_from></surface></newparam>"
+             << "</profile_COMMON></effect></library_effects>\n"
+             << "  <library_materials><material id=\"Material\" name=\"Material\"><instance_effect url=\"#Effect\"/></material></library_materials>\n"
+             << "  <library_geometries>\n";
+
+        for(size_t object = 0; object < objects; object++) {
+            auto source = [&file, object](const std::string& name, size_t count, size_t stride, auto value) {
+                file << "      <source id=\"Grid" << object << "-" << name << "\"><float_array count=\"" << count * stride << "\">";
+
+                for(size_t i = 0; i < count; i++) {
+                    file << value(i);
+                }
+
+                file << "</float_array><technique_common><accessor count=\"" << count << "\" stride=\"" << stride << "\"/></technique_common></source>\n";
+            };
+
+            file << "    <geometry id=\"Grid" << object << "\" name=\"Grid" << object << "\"><mesh>\n";
+
+            source("positions", points, 3, [side, object](size_t i) {
+                std::stringstream ss;
+
+                ss << i % (side + 1) << " " << object << " " << i / (side + 1) << " ";
+
+                return ss.str();
+            });
+
+            source("normals", 1, 3, [](size_t i) { return std::string("0 1 0 "); });
+
+            source("uvs", points, 2, [side](size_t i) {
+                std::stringstream ss;
+
+                ss << (float) (i % (side + 1)) / side << " " << (float) (i / (side + 1)) / side << " ";
+
+                return ss.str();
+            });
+
+            file << "      <vertices id=\"Grid" << object << "-vertices\"><input semantic=\"POSITION\" source=\"#Grid" << object << "-positions\"/></vertices>\n"
+                 << "      <triangles material=\"Material\" count=\"" << side * side * 2 << "\">"
+                 << "<input semantic=\"VERTEX\" source=\"#Grid" << object << "-vertices\" offset=\"0\"/>"
+                 << "<input semantic=\"NORMAL\" source=\"#Grid" << object << "-normals\" offset=\"1\"/>"
+                 << "<input semantic=\"TEXCOORD\" source=\"#Grid" << object << "-uvs\" offset=\"2\"/><p>";
+
+            auto corner = [&file, side](size_t x, size_t y) {
+                auto index = y * (side + 1) + x;
+
+                file << index << " 0 " << index << " ";
+            };
+
+            for(size_t y = 0; y < side; y++) {
+                for(size_t x = 0; x < side; x++) {
+                    corner(x, y); corner(x, y + 1); corner(x + 1, y + 1);
+                    corner(x, y); corner(x + 1, y + 1); corner(x + 1, y);
+                }
+            }
+
+            file << "</p></triangles>\n    </mesh></geometry>\n";
+        }
+
+        file << "  </library_geometries>\n"
+             << "  <library_visual_scenes><visual_scene id=\"Scene\" name=\"Scene\">\n";
+
+        for(size_t object = 0; object < objects; object++) {
+            file << "    <node id=\"Node" << object << "\" name=\"Node" << object << "\">"
+                 << "<translate sid=\"location\">0 0 " << object * (side + 1) << "</translate>"
+                 << "<instance_geometry url=\"#Grid" << object << "\"><bind_material><technique_common>"
+                 << "<instance_material symbol=\"Material\" target=\"#Material\"/>"
+                 << "</technique_common></bind_material></instance_geometry></node>\n";
+        }
+
+        file << "  </visual_scene></library_visual_scenes>\n"
+             << "  <scene><instance_visual_scene url=\"#Scene\"/></scene>\n"
+             << "</COLLADA>\n";
+
+        return objects * side * side * 6;
+    }
+
+    size_t count_vertices(std::shared_ptr<Object> object) {
+        size_t vertices = 0;
+
+        object->for_each([&vertices](std::shared_ptr<Object> child) {
+            if(auto renderer = child->get_component<Renderer>()) {
+                vertices += renderer->model->count();
+            }
+        });
+
+        return vertices;
+    }
+
+    /**
+     * Loads the asset once (on this thread).
+     */
+    Sample load(const std::filesystem::path& path) {
+        Sample sample {};
+
+        auto extension = path.extension().string();
+        auto cpuStart = bench::cpu_time();
+        auto start = bench::now();
+
+        if(extension == ".obj") {
+            pepng::extra::obj_load_model(path, [&sample](std::shared_ptr<Model> model) {
+                sample.vertices += model->count();
+            });
+        } else if(extension == ".dae") {
+            std::vector<std::shared_ptr<Object>> scenes;
+
+            pepng::extra::collada_load(path, [&scenes](std::shared_ptr<Object> scene) {
+                scenes.push_back(scene);
+            }, pepng::make_transform(), sample.collada);
+
+            sample.wall = bench::now() - start;
+
+            for(auto scene : scenes) {
+                sample.vertices += count_vertices(scene);
+            }
+        } else {
+            pepng::make_texture(path);
+        }
+
+        if(sample.wall == 0.0) {
+            sample.wall = bench::now() - start;
+        }
+
+        sample.cpu = bench::cpu_time() - cpuStart;
+
+        return sample;
+    }
+
+    void write_phases(std::ostream& os, const std::vector<Sample>& samples) {
+        const char* names[] = { "parse", "textures", "effects", "materials", "cameras", "geometries", "scenes" };
+        double pepng::extra::ColladaTimings::* phases[] = {
+            &pepng::extra::ColladaTimings::parse,
+            &pepng::extra::ColladaTimings::textures,
+            &pepng::extra::ColladaTimings::effects,
+            &pepng::extra::ColladaTimings::materials,
+            &pepng::extra::ColladaTimings::cameras,
+            &pepng::extra::ColladaTimings::geometries,
+            &pepng::extra::ColladaTimings::scenes
+        };
+
+        os << "{";
+
+        for(size_t i = 0; i < std::size(phases); i++) {
+            std::vector<double> milliseconds;
+
+            for(auto& sample : samples) {
+                milliseconds.push_back(sample.collada.*phases[i] * 1000.0);
+            }
+
+            os << (i == 0 ? " " : ", ") << bench::json_string(names[i]) << ": ";
+
+            bench::write_json(os, bench::summarize(milliseconds));
+        }
+
+        os << " }";
+    }
+
+    /**
+     * Loads the asset `repeat` times and writes its JSON entry.
+     */
+    void run_case(std::ostream& os, const std::string& kind, const std::filesystem::path& path, size_t repeat) {
+        std::vector<Sample> samples;
+
+        // Warms the file cache so the first sample does not measure the disk.
+        load(path);
+
+        for(size_t i = 0; i < repeat; i++) {
+            samples.push_back(load(path));
+        }
+
+        std::vector<double> wall;
+        double totalWall = 0.0;
+        double totalCpu = 0.0;
+
+        for(auto& sample : samples) {
+            wall.push_back(sample.wall * 1000.0);
+
+            totalWall += sample.wall;
+            totalCpu += sample.cpu;
+        }
+
+        auto summary = bench::summarize(wall);
+        auto bytes = std::filesystem::file_size(path);
+        auto vertices = samples.empty() ? 0 : samples.front().vertices;
+        double seconds = summary.p50 / 1000.0;
+
+        os  << "    { \"kind\": " << bench::json_string(kind)
+            << ", \"path\": " << bench::json_string(path.filename().string())
+            << ", \"bytes\": " << bytes
+            << ", \"vertices\": " << vertices
+            << ", \"wall_ms\": ";
+
+        bench::write_json(os, summary);
+
+        os  << ", \"mb_per_s\": " << (seconds > 0.0 ? bytes / 1.0e6 / seconds : 0.0)
+            << ", \"vertices_per_s\": " << (seconds > 0.0 ? vertices / seconds : 0.0)
+            << ", \"thread_utilization\": " << (totalWall > 0.0 ? totalCpu / totalWall : 0.0)
+            << ", \"peak_rss_bytes\": " << bench::peak_rss();
+
+        if(kind == "collada") {
+            os << ", \"phases_ms\": ";
+
+            write_phases(os, samples);
+        }
+
+        os << " }";
+    }
+}
+
+int main(int argc, char** argv) {
+    bench::Arguments arguments(argc, argv);
+
+    auto triangles = parse_list(arguments.get_string("triangles", "1000,10000,100000"));
+    auto textureSizes = parse_list(arguments.get_string("texture-sizes", "256,1024,2048"));
+    size_t objects = arguments.get_int("objects", 8);
+    size_t repeat = arguments.get_int("repeat", 5);
+
+    std::filesystem::path directory = arguments.get_string("dir", (std::filesystem::temp_directory_path() / "pepng_load_bench").string());
+
+    std::filesystem::create_directories(directory);
+
+    std::vector<std::pair<std::string, std::filesystem::path>> cases;
+
+    for(auto size : textureSizes) {
+        auto path = directory / ("texture_" + std::to_string(size) + ".tga");
+
+        write_tga(path, size);
+
+        cases.push_back({ "texture", path });
+    }
+
+    // The COLLADA files share one texture, so their textures phase stays comparable across sizes.
+    write_tga(directory / "collada_texture.tga", 256);
+
+    for(auto count : triangles) {
+        auto obj = directory / ("grid_" + std::to_string(count) + ".obj");
+        auto dae = directory / ("grid_" + std::to_string(count) + ".dae");
+
+        write_obj(obj, objects, count);
+        write_dae(dae, objects, count, "collada_texture.tga");
+
+        cases.push_back({ "obj", obj });
+        cases.push_back({ "collada", dae });
+    }
+
+    for(auto& file : arguments.positional()) {
+        std::filesystem::path path = file;
+
+        auto extension = path.extension().string();
+
+        cases.push_back({ extension == ".obj" ? "obj" : extension == ".dae" ? "collada" : "texture", path });
+    }
+
+    std::stringstream report;
+
+    report  << "{\n"
+            << "  \"benchmark\": \"load\",\n"
+            << "  \"repeat\": " << repeat << ",\n"
+            << "  \"objects\": " << objects << ",\n"
+            << "  \"cases\": [\n";
+
+    for(size_t i = 0; i < cases.size(); i++) {
+        std::cerr << "Loading " << cases.at(i).second.string() << std::endl;
+
+        run_case(report, cases.at(i).first, cases.at(i).second, repeat);
+
+        report << (i + 1 < cases.size() ? ",\n" : "\n");
+    }
+
+    report  << "  ],\n"
+            << "  \"peak_rss_bytes\": " << bench::peak_rss() << "\n"
+            << "}";
+
+    bench::write_report(arguments, report.str());
+
+    return 0;
+}
@@ -0,0 +1,374 @@
+#include <vector>
+#include <array>
+#include <sstream>
+#include <iostream>
+
+#include <pepng.h>
+
+#include "bench.hpp"
+#include "scene.hpp"
+
+/**
+ * Renders a synthetic scene headless for a fixed number of frames and writes the timings as JSON.
+ *
+ * Usage: pepng_bench [--objects 1000] [--depth 1] [--meshes 4] [--clone] [--point-lights 2] [--spotlights 2]
+ *                    [--shadows] [--light-lists] [--no-light-culling] [--light-range 0] [--clustered] [--deferred]
+ *                    [--animate] [--static] [--shadow-budget 0] [--shadow-atlas 0] [--shadow-arrays] [--parallel] [--pipelined] [--read-frame] [--frames 300] [--warmup 30] [--width 1280] [--height 720]
+ *                    [--seed 1] [--out report.json]
+ */
+namespace {
+    /**
+     * Number of frames a GPU timer query is kept before being read (avoids stalling on the result).
+     */
+    const size_t QUERY_LATENCY = 4;
+
+    enum Phase {
+        UPDATE,
+        CAPTURE,
+        SHADOWS,
+        OBJECTS,
+        READBACK,
+        PRESENT,
+        PHASE_COUNT
+    };
+
+    const char* PHASE_NAMES[PHASE_COUNT] = { "update", "capture", "shadows", "objects", "readback", "present" };
+
+    unsigned long WARMUP = 0;
+    unsigned long FRAMES = 0;
+    bool RENDER_SHADOWS = false;
+    bool READ_FRAME = false;
+
+    /**
+     * The number of measured frames read back, and the checksum of the last one.
+     */
+    unsigned long FRAMES_READ = 0;
+    unsigned long FRAME_CHECKSUM = 0;
+    std::vector<unsigned char> PIXELS;
+
+    std::vector<double> FRAME_MS;
+    std::array<std::vector<double>, PHASE_COUNT> PHASE_MS;
+    std::vector<double> GPU_MS;
+    std::vector<double> GL_CALLS;
+    std::vector<double> DRAW_CALLS;
+    std::vector<double> SKIPPED_BINDS;
+
+    bool GPU_TIMER = false;
+    std::array<GLuint, QUERY_LATENCY> QUERIES;
+    std::array<bool, QUERY_LATENCY> QUERY_MEASURED;
+
+    /**
+     * Reads the query of the given ring slot (blocks if the result is not available yet).
+     */
+    void read_query(size_t slot) {
+        if(!QUERY_MEASURED.at(slot)) return;
+
+        GLuint64 elapsed = 0;
+
+        glGetQueryObjectui64v(QUERIES.at(slot), GL_QUERY_RESULT, &elapsed);
+
+        GPU_MS.push_back(elapsed / 1.0e6);
+
+        QUERY_MEASURED.at(slot) = false;
+    }
+
+    /**
+     * Reads the frame back (from the render thread when pipelined, a frame or more behind).
+     */
+    void read_frame(bool measured) {
+        if(!pepng::read_frame(PIXELS) || !measured) return;
+
+        FRAMES_READ++;
+        FRAME_CHECKSUM = 0;
+
+        for(auto value : PIXELS) {
+            FRAME_CHECKSUM = FRAME_CHECKSUM * 31 + value;
+        }
+    }
+
+    /**
+     * The frame of the pipelined mode: the render thread draws the snapshot, so only the update side is timed
+     * (the GPU timer and the command stats belong to the render thread).
+     */
+    void bench_pipelined_frame() {
+        bool measured = pepng::frame_index() >= WARMUP;
+
+        std::array<double, PHASE_COUNT> phases {};
+
+        auto timed = [&phases](Phase phase, auto function) {
+            auto start = bench::now();
+
+            function();
+
+            phases.at(phase) = (bench::now() - start) * 1000.0;
+        };
+
+        timed(UPDATE, pepng::extra::update_objects);
+        timed(CAPTURE, pepng::extra::capture_frame);
+
+        if(READ_FRAME) {
+            timed(READBACK, [measured]() { read_frame(measured); });
+        }
+
+        timed(PRESENT, []() {
+            pepng::extra::submit_frame();
+            pepng::extra::update_glfw();
+        });
+
+        if(!measured) return;
+
+        double total = 0.0;
+
+        for(size_t phase = 0; phase < PHASE_COUNT; phase++) {
+            PHASE_MS.at(phase).push_back(phases.at(phase));
+
+            total += phases.at(phase);
+        }
+
+        FRAME_MS.push_back(total);
+    }
+
+    void bench_frame() {
+        auto frame = pepng::frame_index();
+        bool measured = frame >= WARMUP;
+        size_t slot = frame % QUERY_LATENCY;
+
+        std::array<double, PHASE_COUNT> phases {};
+
+        auto timed = [&phases](Phase phase, auto function) {
+            auto start = bench::now();
+
+            function();
+
+            phases.at(phase) = (bench::now() - start) * 1000.0;
+        };
+
+        CommandBuffer::reset_stats();
+
+        if(GPU_TIMER) {
+            read_query(slot);
+
+            glBeginQuery(GL_TIME_ELAPSED, QUERIES.at(slot));
+        }
+
+        timed(UPDATE, pepng::extra::update_objects);
+        timed(CAPTURE, pepng::extra::capture_frame);
+
+        if(RENDER_SHADOWS) {
+            timed(SHADOWS, []() { pepng::extra::render_shadows(); });
+        }
+
+        timed(OBJECTS, []() { pepng::extra::render_objects(); });
+
+        if(GPU_TIMER) {
+            glEndQuery(GL_TIME_ELAPSED);
+
+            QUERY_MEASURED.at(slot) = measured;
+        }
+
+        auto stats = CommandBuffer::stats();
+
+        if(READ_FRAME) {
+            timed(READBACK, [measured]() { read_frame(measured); });
+        }
+
+        timed(PRESENT, pepng::extra::update_glfw);
+
+        if(!measured) return;
+
+        double total = 0.0;
+
+        for(size_t phase = 0; phase < PHASE_COUNT; phase++) {
+            PHASE_MS.at(phase).push_back(phases.at(phase));
+
+            total += phases.at(phase);
+        }
+
+        FRAME_MS.push_back(total);
+        GL_CALLS.push_back(stats.gl_calls);
+        DRAW_CALLS.push_back(stats.draw_calls);
+        SKIPPED_BINDS.push_back(stats.skipped_binds);
+
+        // The context is destroyed when pepng::update returns, so the last queries are read now.
+        if(GPU_TIMER && pepng::frame_index() >= WARMUP + FRAMES) {
+            for(size_t i = 1; i <= QUERY_LATENCY; i++) {
+                read_query((slot + i) % QUERY_LATENCY);
+            }
+
+            glDeleteQueries(QUERY_LATENCY, QUERIES.data());
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    bench::Arguments arguments(argc, argv);
+
+    bench::SceneConfig config;
+
+    config.objects = arguments.get_int("objects", 1000);
+    config.depth = arguments.get_int("depth", 1);
+    config.meshes = arguments.get_int("meshes", 4);
+    config.clone = arguments.has("clone");
+    config.point_lights = arguments.get_int("point-lights", 2);
+    config.spotlights = arguments.get_int("spotlights", 2);
+    config.shadows = arguments.has("shadows");
+    config.light_lists = arguments.has("light-lists");
+    config.light_culling = !arguments.has("no-light-culling");
+    config.light_range = arguments.get_float("light-range", 0.0);
+    config.clustered = arguments.has("clustered");
+    config.deferred = arguments.has("deferred");
+    config.animate = arguments.has("animate");
+    config.static_objects = arguments.has("static");
+    config.seed = arguments.get_int("seed", 1);
+
+    WARMUP = arguments.get_int("warmup", 30);
+    FRAMES = arguments.get_int("frames", 300);
+    RENDER_SHADOWS = config.shadows;
+    READ_FRAME = arguments.has("read-frame");
+
+    auto pipelined = arguments.has("pipelined");
+
+    auto maxLights = config.deferred ? bench::MAX_DEFERRED_LIGHTS
+        : config.clustered ? bench::MAX_CLUSTERED_LIGHTS
+        : config.light_lists ? bench::MAX_LISTED_LIGHTS
+        : bench::MAX_LIGHTS;
+
+    // Only the lights without shadows are clustered (and the clusters take texture units from the shadow maps).
+    if(config.clustered && config.shadows) {
+        std::cout << "--clustered and --shadows cannot be combined." << std::endl;
+
+        throw std::runtime_error("--clustered and --shadows cannot be combined.");
+    }
+
+    if(config.point_lights > maxLights || config.spotlights > maxLights) {
+        std::stringstream ss;
+
+        ss << "At most " << maxLights << " lights of each type are supported.";
+
+        std::cout << ss.str() << std::endl;
+
+        throw std::runtime_error(ss.str());
+    }
+
+    auto shadowAtlas = arguments.get_int("shadow-atlas", 0);
+    auto shadowArrays = arguments.has("shadow-arrays");
+
+    // The scene shaders sample the spotlights either from the atlas or from their array.
+    if(shadowAtlas > 0 && shadowArrays) {
+        std::cout << "--shadow-atlas and --shadow-arrays cannot be combined." << std::endl;
+
+        throw std::runtime_error("--shadow-atlas and --shadow-arrays cannot be combined.");
+    }
+
+    // The G-buffer takes 3 texture units before the shadow maps (and the atlas 1).
+    auto maxShadowLights = bench::MAX_SHADOW_LIGHTS - (config.deferred ? 3 : 0) - (shadowAtlas > 0 ? 1 : 0);
+
+    // The arrays take 2 texture units whatever the number of lights.
+    if(config.shadows && !shadowArrays && config.point_lights + config.spotlights > maxShadowLights) {
+        std::stringstream ss;
+
+        ss << "At most " << maxShadowLights << " lights with shadows are supported.";
+
+        std::cout << ss.str() << std::endl;
+
+        throw std::runtime_error(ss.str());
+    }
+
+    auto width = arguments.get_int("width", 1280);
+    auto height = arguments.get_int("height", 720);
+
+    pepng::init_headless(width, height);
+
+    pepng::set_parallel_update(arguments.has("parallel"));
+
+    pepng::set_pipelined(pipelined);
+
+    pepng::set_light_culling(config.light_culling);
+
+    auto shadowBudget = arguments.get_int("shadow-budget", 0);
+
+    if(shadowBudget > 0) pepng::set_shadow_budget(shadowBudget);
+
+    // Before the scene, so the spotlights render into the atlas.
+    if(shadowAtlas > 0) pepng::set_shadow_atlas(shadowAtlas);
+
+    pepng::set_shadow_arrays(shadowArrays);
+
+    // Before the scene, so the clusters get the first light texture units.
+    pepng::set_clustered_lighting(config.clustered);
+
+    auto shaders = bench::make_scene_shaders(config.light_lists, config.clustered, config.deferred, shadowArrays);
+
+    bench::build_scene(config, shaders);
+
+    GPU_TIMER = !pipelined && (GLEW_ARB_timer_query || GLEW_VERSION_3_3);
+
+    if(GPU_TIMER) {
+        glGenQueries(QUERY_LATENCY, QUERIES.data());
+
+        QUERY_MEASURED.fill(false);
+    }
+
+    pepng::set_frame_limit(WARMUP + FRAMES);
+
+    auto start = bench::now();
+
+    pepng::update(pipelined ? bench_pipelined_frame : bench_frame);
+
+    auto elapsed = bench::now() - start;
+
+    std::stringstream report;
+
+    report  << "{\n"
+            << "  \"benchmark\": \"render\",\n"
+            << "  \"scene\": " << bench::scene_json(config) << ",\n"
+            << "  \"width\": " << width << ",\n"
+            << "  \"height\": " << height << ",\n"
+            << "  \"parallel\": " << (arguments.has("parallel") ? "true" : "false") << ",\n"
+            << "  \"pipelined\": " << (pipelined ? "true" : "false") << ",\n"
+            << "  \"shadow_budget\": " << shadowBudget << ",\n"
+            << "  \"shadow_atlas\": " << shadowAtlas << ",\n"
+            << "  \"shadow_arrays\": " << (shadowArrays ? "true" : "false") << ",\n"
+            << "  \"warmup\": " << WARMUP << ",\n"
+            << "  \"frames\": " << FRAME_MS.size() << ",\n"
+            << "  \"total_s\": " << elapsed << ",\n"
+            << "  \"frames_read\": " << FRAMES_READ << ",\n"
+            << "  \"frame_checksum\": " << FRAME_CHECKSUM << ",\n"
+            << "  \"cpu_frame_ms\": ";
+
+    bench::write_json(report, bench::summarize(FRAME_MS));
+
+    report << ",\n  \"phases_ms\": {";
+
+    for(size_t phase = 0; phase < PHASE_COUNT; phase++) {
+        report << (phase == 0 ? "\n" : ",\n") << "    " << bench::json_string(PHASE_NAMES[phase]) << ": ";
+
+        bench::write_json(report, bench::summarize(PHASE_MS.at(phase)));
+    }
+
+    report << "\n  },\n  \"gpu_frame_ms\": ";
+
+    if(GPU_TIMER) {
+        bench::write_json(report, bench::summarize(GPU_MS));
+    } else {
+        report << "null";
+    }
+
+    report << ",\n  \"gl_calls\": ";
+
+    bench::write_json(report, bench::summarize(GL_CALLS));
+
+    report << ",\n  \"draw_calls\": ";
+
+    bench::write_json(report, bench::summarize(DRAW_CALLS));
+
+    report << ",\n  \"skipped_binds\": ";
+
+    bench::write_json(report, bench::summarize(SKIPPED_BINDS));
+
+    report << "\n}";
+
+    bench::write_report(arguments, report.str());
+
+    return 0;
+}
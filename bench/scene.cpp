@@ -0,0 +1,884 @@
+#include "scene.hpp"
+
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <algorithm>
+
+#include <glm/gtc/constants.hpp>
+
+namespace {
+    const char* OBJECT_VERTEX = R"(#version 330 core
+layout (location = 0) in vec3 a_position;
+layout (location = 1) in vec3 a_normal;
+layout (location = 2) in vec2 a_uv;
+
+uniform mat4 u_projection;
+uniform mat4 u_view;
+uniform mat4 u_world;
+
+out vec3 v_position;
+out vec3 v_normal;
+out vec2 v_uv;
+
+void main() {
+    vec4 world = u_world * vec4(a_position, 1.0);
+
+    v_position = world.xyz;
+    v_normal = mat3(u_world) * a_normal;
+    v_uv = a_uv;
+
+    gl_Position = u_projection * u_view * world;
+}
+)";
+
+    // Compiled with LIGHT_LISTS, only the lights listed for the draw are shaded (see Renderer::assign_lights).
+    // Compiled with CLUSTERED, the lights of the fragment cluster are also shaded (see LightClusters).
+    // Compiled with SHADOW_ARRAYS, the shadow maps are the layers of the light index (see pepng::set_shadow_arrays).
+    const char* OBJECT_FRAGMENT = R"(#version 330 core
+#ifdef LIGHT_LISTS
+#define MAX_LIGHTS 64
+#define MAX_LIST 4
+#else
+#define MAX_LIGHTS 8
+#endif
+
+struct PointLight {
+    bool is_active;
+    vec3 position;
+    float range;
+    vec3 color;
+    float intensity;
+    float shadows;
+};
+
+struct SpotLight {
+    bool is_active;
+    vec3 position;
+    vec3 direction;
+    float range;
+    vec3 color;
+    float angle;
+    float intensity;
+    float shadows;
+    mat4 matrix;
+};
+
+uniform PointLight u_pointlights[MAX_LIGHTS];
+uniform SpotLight u_spotlights[MAX_LIGHTS];
+#ifdef LIGHT_LISTS
+uniform int u_point_count;
+uniform int u_point_list[MAX_LIST];
+uniform samplerCube u_point_list_shadows[MAX_LIST];
+uniform int u_spot_count;
+uniform int u_spot_list[MAX_LIST];
+uniform sampler2D u_spot_list_shadows[MAX_LIST];
+#else
+uniform samplerCube u_point_shadows[MAX_LIGHTS];
+uniform sampler2D u_spot_shadows[MAX_LIGHTS];
+#endif
+#ifdef SHADOW_ARRAYS
+uniform samplerCubeArray u_point_shadow_array;
+uniform sampler2DArray u_spot_shadow_array;
+
+// The light functions take the layer instead of the sampler.
+#define SHADOW_MAP(sampler, layer) layer
+#define POINT_SHADOW int
+#define SPOT_SHADOW int
+#define POINT_DEPTH(shadow, direction) texture(u_point_shadow_array, vec4(direction, float(shadow))).r
+#define SPOT_DEPTH(shadow, uv) texture(u_spot_shadow_array, vec3(uv, float(shadow))).r
+#else
+#define SHADOW_MAP(sampler, layer) sampler
+#define POINT_SHADOW samplerCube
+#define SPOT_SHADOW sampler2D
+#define POINT_DEPTH(shadow, direction) texture(shadow, direction).r
+#define SPOT_DEPTH(shadow, uv) texture(shadow, uv).r
+#endif
+#ifdef CLUSTERED
+uniform samplerBuffer u_cluster_lights;
+uniform usamplerBuffer u_cluster_grid;
+uniform usamplerBuffer u_cluster_indices;
+uniform vec3 u_cluster_dimension;
+uniform vec3 u_cluster_depth;
+uniform mat4 u_projection;
+uniform mat4 u_view;
+#endif
+uniform sampler2D u_texture;
+uniform vec3 u_camera_pos;
+uniform float u_receive_shadow;
+uniform float u_display_texture;
+
+in vec3 v_position;
+in vec3 v_normal;
+in vec2 v_uv;
+
+out vec4 o_color;
+
+vec3 point_light(PointLight light, POINT_SHADOW shadowMap, vec3 normal) {
+    if(!light.is_active) return vec3(0.0);
+
+    vec3 toLight = light.position - v_position;
+    float distance = length(toLight);
+
+    if(distance > light.range) return vec3(0.0);
+
+    float shadow = 0.0;
+
+    if(light.shadows > 0.5 && u_receive_shadow > 0.5) {
+        float closest = POINT_DEPTH(shadowMap, -toLight) * light.range;
+
+        shadow = distance - 0.05 > closest ? 1.0 : 0.0;
+    }
+
+    float diffuse = max(dot(normal, toLight / distance), 0.0);
+    float attenuation = 1.0 - distance / light.range;
+
+    return light.color * light.intensity * diffuse * attenuation * (1.0 - shadow);
+}
+
+vec3 spot_light(SpotLight light, SPOT_SHADOW shadowMap, vec3 normal) {
+    if(!light.is_active) return vec3(0.0);
+
+    vec3 toLight = light.position - v_position;
+    float distance = length(toLight);
+
+    if(distance > light.range || acos(dot(-toLight / distance, normalize(light.direction))) > light.angle) return vec3(0.0);
+
+    float shadow = 0.0;
+
+    if(light.shadows > 0.5 && u_receive_shadow > 0.5) {
+        vec4 projected = light.matrix * vec4(v_position, 1.0);
+
+        projected = projected / projected.w * 0.5 + 0.5;
+
+        shadow = projected.z - 0.005 > SPOT_DEPTH(shadowMap, projected.xy) ? 1.0 : 0.0;
+    }
+
+    float diffuse = max(dot(normal, toLight / distance), 0.0);
+
+    return light.color * light.intensity * diffuse * (1.0 - shadow);
+}
+
+#ifdef CLUSTERED
+vec3 cluster_lights(vec3 normal) {
+    vec4 view = u_view * vec4(v_position, 1.0);
+    vec4 clip = u_projection * view;
+
+    float near = u_cluster_depth.x;
+    float far = u_cluster_depth.y;
+    float depth = -view.z;
+    float slice = u_cluster_depth.z > 0.5 ? (depth - near) / (far - near) : log(depth / near) / log(far / near);
+
+    ivec3 dimension = ivec3(u_cluster_dimension);
+    ivec3 cluster = clamp(ivec3(vec3(clip.xy / clip.w * 0.5 + 0.5, slice) * u_cluster_dimension), ivec3(0), dimension - 1);
+
+    uvec2 cell = texelFetch(u_cluster_grid, cluster.x + dimension.x * (cluster.y + dimension.y * cluster.z)).xy;
+
+    vec3 light = vec3(0.0);
+
+    for(uint i = 0u; i < cell.y; i++) {
+        int index = int(texelFetch(u_cluster_indices, int(cell.x + i)).r) * 3;
+
+        vec4 position = texelFetch(u_cluster_lights, index);
+        vec4 color = texelFetch(u_cluster_lights, index + 1);
+        vec4 direction = texelFetch(u_cluster_lights, index + 2);
+
+        vec3 toLight = position.xyz - v_position;
+        float distance = length(toLight);
+
+        // Point lights have a cosine of -2, so the cone test always passes.
+        if(distance > position.w || dot(-toLight / distance, direction.xyz) < direction.w) continue;
+
+        float diffuse = max(dot(normal, toLight / distance), 0.0);
+        float attenuation = color.w > 0.5 ? 1.0 : 1.0 - distance / position.w;
+
+        light += color.rgb * diffuse * attenuation;
+    }
+
+    return light;
+}
+#endif
+
+void main() {
+    vec3 normal = normalize(v_normal);
+    vec3 albedo = u_display_texture > 0.5 ? texture(u_texture, v_uv).rgb : vec3(0.8);
+    vec3 light = vec3(0.1);
+
+    // Sampler arrays are indexed with constants (GLSL 330).
+    #ifdef LIGHT_LISTS
+    #define POINT(i) if(i < u_point_count) light += point_light(u_pointlights[u_point_list[i]], SHADOW_MAP(u_point_list_shadows[i], u_point_list[i]), normal);
+    #define SPOT(i) if(i < u_spot_count) light += spot_light(u_spotlights[u_spot_list[i]], SHADOW_MAP(u_spot_list_shadows[i], u_spot_list[i]), normal);
+
+    POINT(0) POINT(1) POINT(2) POINT(3)
+    SPOT(0) SPOT(1) SPOT(2) SPOT(3)
+    #else
+    #define POINT(i) light += point_light(u_pointlights[i], SHADOW_MAP(u_point_shadows[i], i), normal);
+    #define SPOT(i) light += spot_light(u_spotlights[i], SHADOW_MAP(u_spot_shadows[i], i), normal);
+
+    POINT(0) POINT(1) POINT(2) POINT(3) POINT(4) POINT(5) POINT(6) POINT(7)
+    SPOT(0) SPOT(1) SPOT(2) SPOT(3) SPOT(4) SPOT(5) SPOT(6) SPOT(7)
+    #endif
+
+    #ifdef CLUSTERED
+    light += cluster_lights(normal);
+    #endif
+
+    o_color = vec4(albedo * light, 1.0);
+}
+)";
+
+    const char* POINT_SHADOW_VERTEX = R"(#version 330 core
+layout (location = 0) in vec3 a_position;
+
+uniform mat4 u_world;
+
+void main() {
+    gl_Position = u_world * vec4(a_position, 1.0);
+}
+)";
+
+    const char* POINT_SHADOW_GEOMETRY = R"(#version 330 core
+layout (triangles) in;
+layout (triangle_strip, max_vertices = 18) out;
+
+uniform mat4 u_shadow_matrices[6];
+uniform int u_cull_faces;
+uniform int u_shadow_layer;
+
+out vec4 g_position;
+
+void main() {
+    for(int face = 0; face < 6; face++) {
+        if((u_cull_faces & (1 << face)) != 0) continue;
+
+        gl_Layer = u_shadow_layer + face;
+
+        for(int i = 0; i < 3; i++) {
+            g_position = gl_in[i].gl_Position;
+            gl_Position = u_shadow_matrices[face] * g_position;
+
+            EmitVertex();
+        }
+
+        EndPrimitive();
+    }
+}
+)";
+
+    const char* POINT_SHADOW_FRAGMENT = R"(#version 330 core
+in vec4 g_position;
+
+uniform vec3 u_light_pos;
+uniform float u_far;
+
+void main() {
+    gl_FragDepth = length(g_position.xyz - u_light_pos) / u_far;
+}
+)";
+
+    const char* SPOT_SHADOW_VERTEX = R"(#version 330 core
+layout (location = 0) in vec3 a_position;
+
+uniform mat4 u_matrix;
+uniform mat4 u_world;
+
+void main() {
+    gl_Position = u_matrix * u_world * vec4(a_position, 1.0);
+}
+)";
+
+    const char* SPOT_SHADOW_FRAGMENT = R"(#version 330 core
+void main() {}
+)";
+
+    // Deferred shading (see DeferredShading): the geometry pass writes the albedo and the octahedral normal.
+    const char* GEOMETRY_FRAGMENT = R"(#version 330 core
+uniform sampler2D u_texture;
+uniform float u_display_texture;
+
+in vec3 v_position;
+in vec3 v_normal;
+in vec2 v_uv;
+
+layout (location = 0) out vec4 o_albedo;
+layout (location = 1) out vec2 o_normal;
+
+vec2 octahedral(vec3 normal) {
+    normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+
+    vec2 signs = vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+
+    return normal.z >= 0.0 ? normal.xy : (1.0 - abs(normal.yx)) * signs;
+}
+
+void main() {
+    o_albedo = vec4(u_display_texture > 0.5 ? texture(u_texture, v_uv).rgb : vec3(0.8), 1.0);
+    o_normal = octahedral(normalize(v_normal));
+}
+)";
+
+    const char* VOLUME_VERTEX = R"(#version 330 core
+layout (location = 0) in vec3 a_position;
+
+uniform mat4 u_projection;
+uniform mat4 u_view;
+uniform mat4 u_world;
+
+void main() {
+    gl_Position = u_projection * u_view * u_world * vec4(a_position, 1.0);
+}
+)";
+
+    const char* FULLSCREEN_VERTEX = R"(#version 330 core
+layout (location = 0) in vec3 a_position;
+
+void main() {
+    gl_Position = vec4(a_position, 1.0);
+}
+)";
+
+    // Prepended to the lighting fragment shaders (after the #version line).
+    const char* GBUFFER_FUNCTIONS = R"(
+uniform sampler2D u_gbuffer_albedo;
+uniform sampler2D u_gbuffer_normal;
+uniform sampler2D u_gbuffer_depth;
+uniform vec3 u_gbuffer_texel;
+uniform mat4 u_screen_to_world;
+
+out vec4 o_color;
+
+vec3 decode_normal(vec2 encoded) {
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+
+    if(normal.z < 0.0) {
+        normal.xy = (1.0 - abs(normal.yx)) * vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+    }
+
+    return normalize(normal);
+}
+
+// Reads the G-buffer pixel (false for the background).
+bool read_gbuffer(out vec3 albedo, out vec3 normal, out vec3 position) {
+    vec2 uv = gl_FragCoord.xy * u_gbuffer_texel.xy;
+    float depth = texture(u_gbuffer_depth, uv).r;
+
+    if(depth >= 1.0) return false;
+
+    vec4 world = u_screen_to_world * vec4(gl_FragCoord.xy, depth, 1.0);
+
+    albedo = texture(u_gbuffer_albedo, uv).rgb;
+    normal = decode_normal(texture(u_gbuffer_normal, uv).rg);
+    position = world.xyz / world.w;
+
+    return true;
+}
+)";
+
+    const char* AMBIENT_FRAGMENT = R"(#version 330 core
+void main() {
+    vec3 albedo;
+    vec3 normal;
+    vec3 position;
+
+    if(!read_gbuffer(albedo, normal, position)) discard;
+
+    o_color = vec4(albedo * 0.1, 1.0);
+}
+)";
+
+    const char* POINT_VOLUME_FRAGMENT = R"(#version 330 core
+uniform vec3 u_light_position;
+uniform vec3 u_light_color;
+uniform float u_light_intensity;
+uniform float u_light_range;
+uniform float u_light_shadows;
+#ifdef SHADOW_ARRAYS
+uniform samplerCubeArray u_light_shadow;
+uniform int u_light_layer;
+#define SHADOW_DEPTH(direction) texture(u_light_shadow, vec4(direction, float(u_light_layer))).r
+#else
+uniform samplerCube u_light_shadow;
+#define SHADOW_DEPTH(direction) texture(u_light_shadow, direction).r
+#endif
+
+void main() {
+    vec3 albedo;
+    vec3 normal;
+    vec3 position;
+
+    if(!read_gbuffer(albedo, normal, position)) discard;
+
+    vec3 toLight = u_light_position - position;
+    float distance = length(toLight);
+
+    if(distance > u_light_range) discard;
+
+    float shadow = 0.0;
+
+    if(u_light_shadows > 0.5) {
+        float closest = SHADOW_DEPTH(-toLight) * u_light_range;
+
+        shadow = distance - 0.05 > closest ? 1.0 : 0.0;
+    }
+
+    float diffuse = max(dot(normal, toLight / distance), 0.0);
+    float attenuation = 1.0 - distance / u_light_range;
+
+    o_color = vec4(albedo * u_light_color * u_light_intensity * diffuse * attenuation * (1.0 - shadow), 1.0);
+}
+)";
+
+    const char* SPOT_VOLUME_FRAGMENT = R"(#version 330 core
+uniform vec3 u_light_position;
+uniform vec3 u_light_direction;
+uniform vec3 u_light_color;
+uniform float u_light_intensity;
+uniform float u_light_range;
+uniform float u_light_cos_angle;
+uniform float u_light_shadows;
+uniform mat4 u_light_matrix;
+#ifdef SHADOW_ARRAYS
+uniform sampler2DArray u_light_shadow;
+uniform int u_light_layer;
+#define SHADOW_DEPTH(uv) texture(u_light_shadow, vec3(uv, float(u_light_layer))).r
+#else
+uniform sampler2D u_light_shadow;
+#define SHADOW_DEPTH(uv) texture(u_light_shadow, uv).r
+#endif
+
+void main() {
+    vec3 albedo;
+    vec3 normal;
+    vec3 position;
+
+    if(!read_gbuffer(albedo, normal, position)) discard;
+
+    vec3 toLight = u_light_position - position;
+    float distance = length(toLight);
+
+    if(distance > u_light_range || dot(-toLight / distance, normalize(u_light_direction)) < u_light_cos_angle) discard;
+
+    float shadow = 0.0;
+
+    if(u_light_shadows > 0.5) {
+        vec4 projected = u_light_matrix * vec4(position, 1.0);
+
+        projected = projected / projected.w * 0.5 + 0.5;
+
+        shadow = projected.z - 0.005 > SHADOW_DEPTH(projected.xy) ? 1.0 : 0.0;
+    }
+
+    float diffuse = max(dot(normal, toLight / distance), 0.0);
+
+    o_color = vec4(albedo * u_light_color * u_light_intensity * diffuse * (1.0 - shadow), 1.0);
+}
+)";
+
+    /**
+     * The directives of the shaders sampling the shadow arrays (cube map arrays are not in GLSL 330).
+     */
+    const char* SHADOW_ARRAYS_DEFINES = "#extension GL_ARB_texture_cube_map_array : require\n#define SHADOW_ARRAYS\n";
+
+    /**
+     * Compiles a lighting fragment shader (with the G-buffer functions).
+     */
+    GLuint compile_lighting_fragment(const char* source, bool shadowArrays) {
+        std::string fragment = source;
+
+        fragment.insert(fragment.find('\n') + 1, GBUFFER_FUNCTIONS);
+
+        if(shadowArrays) {
+            fragment.insert(fragment.find('\n') + 1, SHADOW_ARRAYS_DEFINES);
+        }
+
+        return pepng::compile_shader(fragment.c_str(), GL_FRAGMENT_SHADER);
+    }
+
+    /**
+     * Texture units for the shadow samplers that are not attached to a light.
+     *
+     * Samplers of different types cannot share a unit, so the unused ones are moved away from unit 0.
+     */
+    const GLint UNUSED_CUBE_UNIT = 14;
+    const GLint UNUSED_2D_UNIT = 15;
+
+    /**
+     * The number of listed lights of each type shaded by the object shader (MAX_LIST).
+     */
+    const size_t LIST_SIZE = 4;
+}
+
+bench::Spinner::Spinner(glm::vec3 degreesPerSecond) :
+    Component("Spinner"),
+    __degrees_per_second(degreesPerSecond)
+{}
+
+bench::Spinner::Spinner(const Spinner& spinner) :
+    Component(spinner),
+    __degrees_per_second(spinner.__degrees_per_second)
+{}
+
+std::shared_ptr<bench::Spinner> bench::Spinner::make_spinner(glm::vec3 degreesPerSecond) {
+    std::shared_ptr<Spinner> spinner(new Spinner(degreesPerSecond));
+
+    return spinner;
+}
+
+bench::Spinner* bench::Spinner::clone_implementation() {
+    return new Spinner(*this);
+}
+
+void bench::Spinner::update(std::shared_ptr<WithComponents> parent) {
+    if(!this->_is_active) return;
+
+    if(auto transform = parent->get_component<Transform>()) {
+        transform->delta_rotate(this->__degrees_per_second * Component::delta_time());
+    }
+}
+
+#ifdef IMGUI
+void bench::Spinner::imgui() {
+    Component::imgui();
+
+    ImGui::InputFloat3("Degrees/s", glm::value_ptr(this->__degrees_per_second));
+}
+#endif
+
+bench::SceneShaders bench::make_scene_shaders(bool lightLists, bool clustered, bool deferred, bool shadowArrays) {
+    SceneShaders shaders;
+
+    shaders.geometry = 0;
+    shaders.point_volume = 0;
+    shaders.spot_volume = 0;
+    shaders.ambient = 0;
+
+    std::string fragment = OBJECT_FRAGMENT;
+
+    // After the #version line.
+    if(lightLists) {
+        fragment.insert(fragment.find('\n') + 1, "#define LIGHT_LISTS\n");
+    }
+
+    if(clustered) {
+        fragment.insert(fragment.find('\n') + 1, "#define CLUSTERED\n");
+    }
+
+    if(shadowArrays) {
+        fragment.insert(fragment.find('\n') + 1, SHADOW_ARRAYS_DEFINES);
+    }
+
+    shaders.object = pepng::make_shader_program(
+        pepng::compile_shader(OBJECT_VERTEX, GL_VERTEX_SHADER),
+        pepng::compile_shader(fragment.c_str(), GL_FRAGMENT_SHADER)
+    );
+
+    shaders.point_shadow = pepng::make_shader_program(
+        pepng::compile_shader(POINT_SHADOW_VERTEX, GL_VERTEX_SHADER),
+        pepng::compile_shader(POINT_SHADOW_GEOMETRY, GL_GEOMETRY_SHADER),
+        pepng::compile_shader(POINT_SHADOW_FRAGMENT, GL_FRAGMENT_SHADER)
+    );
+
+    shaders.spot_shadow = pepng::make_shader_program(
+        pepng::compile_shader(SPOT_SHADOW_VERTEX, GL_VERTEX_SHADER),
+        pepng::compile_shader(SPOT_SHADOW_FRAGMENT, GL_FRAGMENT_SHADER)
+    );
+
+    if(deferred) {
+        shaders.geometry = pepng::make_shader_program(
+            pepng::compile_shader(OBJECT_VERTEX, GL_VERTEX_SHADER),
+            pepng::compile_shader(GEOMETRY_FRAGMENT, GL_FRAGMENT_SHADER)
+        );
+
+        shaders.point_volume = pepng::make_shader_program(
+            pepng::compile_shader(VOLUME_VERTEX, GL_VERTEX_SHADER),
+            compile_lighting_fragment(POINT_VOLUME_FRAGMENT, shadowArrays)
+        );
+
+        shaders.spot_volume = pepng::make_shader_program(
+            pepng::compile_shader(VOLUME_VERTEX, GL_VERTEX_SHADER),
+            compile_lighting_fragment(SPOT_VOLUME_FRAGMENT, shadowArrays)
+        );
+
+        shaders.ambient = pepng::make_shader_program(
+            pepng::compile_shader(FULLSCREEN_VERTEX, GL_VERTEX_SHADER),
+            compile_lighting_fragment(AMBIENT_FRAGMENT, shadowArrays)
+        );
+    }
+
+    glUseProgram(shaders.object);
+
+    for(size_t i = 0; i < (lightLists ? LIST_SIZE : bench::MAX_LIGHTS); i++) {
+        std::stringstream point;
+        std::stringstream spot;
+
+        point << (lightLists ? "u_point_list_shadows[" : "u_point_shadows[") << i << "]";
+        spot << (lightLists ? "u_spot_list_shadows[" : "u_spot_shadows[") << i << "]";
+
+        glUniform1i(glGetUniformLocation(shaders.object, point.str().c_str()), UNUSED_CUBE_UNIT);
+        glUniform1i(glGetUniformLocation(shaders.object, spot.str().c_str()), UNUSED_2D_UNIT);
+    }
+
+    // Without lights of a type, its array sampler keeps an unused unit (the per light samplers are not used with arrays).
+    glUniform1i(glGetUniformLocation(shaders.object, "u_point_shadow_array"), UNUSED_CUBE_UNIT);
+    glUniform1i(glGetUniformLocation(shaders.object, "u_spot_shadow_array"), UNUSED_2D_UNIT);
+
+    return shaders;
+}
+
+std::shared_ptr<Model> bench::make_sphere(size_t segments, float radius) {
+    segments = std::max<size_t>(segments, 3);
+
+    size_t rings = segments / 2 + 1;
+
+    auto point = [&](size_t ring, size_t segment) {
+        float theta = glm::pi<float>() * ring / rings;
+        float phi = glm::two_pi<float>() * segment / segments;
+
+        return glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+    };
+
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<unsigned int> indices;
+
+    auto add = [&](size_t ring, size_t segment) {
+        auto normal = point(ring, segment);
+
+        indices.push_back(vertices.size());
+        vertices.push_back(normal * radius);
+        normals.push_back(normal);
+        uvs.push_back(glm::vec2((float) segment / segments, (float) ring / rings));
+    };
+
+    for(size_t ring = 0; ring < rings; ring++) {
+        for(size_t segment = 0; segment < segments; segment++) {
+            add(ring, segment);
+            add(ring + 1, segment);
+            add(ring + 1, segment + 1);
+
+            add(ring, segment);
+            add(ring + 1, segment + 1);
+            add(ring, segment + 1);
+        }
+    }
+
+    std::stringstream name;
+
+    name << "Sphere" << segments;
+
+    return Model::make_model()
+        ->set_name(name.str())
+        ->set_count(vertices.size())
+        ->calculate_offset(vertices, indices)
+        ->attach_buffer(pepng::make_buffer<glm::vec3>(std::move(vertices), GL_ARRAY_BUFFER, 0, 3))
+        ->attach_buffer(pepng::make_buffer<glm::vec3>(std::move(normals), GL_ARRAY_BUFFER, 1, 3))
+        ->attach_buffer(pepng::make_buffer<glm::vec2>(std::move(uvs), GL_ARRAY_BUFFER, 2, 2));
+}
+
+std::shared_ptr<Object> bench::build_scene(const SceneConfig& config, const SceneShaders& shaders) {
+    std::mt19937 random(config.seed);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    /**
+     * Texture (1x1 white)
+     */
+    GLuint textureIndex;
+    unsigned char white[] = { 255, 255, 255, 255 };
+
+    glGenTextures(1, &textureIndex);
+    glBindTexture(GL_TEXTURE_2D, textureIndex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+
+    auto texture = pepng::make_texture(textureIndex);
+
+    /**
+     * Prototypes (one per mesh)
+     */
+    std::vector<std::shared_ptr<Object>> prototypes;
+
+    for(size_t i = 0; i < std::max<size_t>(config.meshes, 1); i++) {
+        auto prototype = pepng::make_object("Prototype");
+
+        prototype->attach_component(pepng::make_transform());
+        prototype->attach_component(pepng::make_renderer(bench::make_sphere(8 + 4 * (i % 8), 0.5f), Material::make_material(shaders.object, texture)));
+
+        // Copied by the clones and the instances.
+        prototype->get_component<Renderer>()->is_static = config.static_objects;
+
+        if(config.animate && !config.static_objects) {
+            prototype->attach_component(bench::Spinner::make_spinner(glm::vec3(0.0f, 45.0f, 0.0f)));
+        }
+
+        prototypes.push_back(prototype);
+    }
+
+    // The instances share the renderer model and material, and the spinner.
+    std::vector<std::shared_ptr<Prefab>> prefabs;
+
+    for(auto prototype : prototypes) {
+        prefabs.push_back(pepng::make_prefab(prototype));
+    }
+
+    auto make_instance = [&](size_t index) {
+        auto prototype = prototypes.at(index % prototypes.size());
+
+        std::shared_ptr<Object> instance;
+
+        if(config.clone) {
+            instance = prototype->clone();
+        } else {
+            instance = prefabs.at(index % prefabs.size())->instantiate();
+        }
+
+        // The spinning objects stay dynamic.
+        if(config.static_objects) {
+            bool spins = config.animate && index % 8 == 0;
+
+            if(spins) {
+                instance->get_component<Renderer>()->is_static = false;
+                instance->attach_component(bench::Spinner::make_spinner(glm::vec3(0.0f, 45.0f, 0.0f)));
+            }
+        }
+
+        return instance;
+    };
+
+    /**
+     * Hierarchy (breadth first with the smallest fanout that fits the objects in depth levels)
+     */
+    size_t depth = std::max<size_t>(config.depth, 1);
+    size_t fanout = 1;
+
+    auto capacity = [depth](size_t fanout) {
+        size_t total = 0;
+        size_t level = 1;
+
+        for(size_t i = 0; i < depth; i++) {
+            level *= fanout;
+            total += level;
+        }
+
+        return total;
+    };
+
+    while(fanout < config.objects && capacity(fanout) < config.objects) {
+        fanout++;
+    }
+
+    auto root = pepng::make_object("Scene");
+
+    root->attach_component(pepng::make_transform());
+
+    std::vector<std::shared_ptr<Object>> level = { root };
+    size_t created = 0;
+    size_t grid = (size_t) std::ceil(std::sqrt((double) std::min(fanout, std::max<size_t>(config.objects, 1))));
+    float extent = grid * 1.5f;
+
+    for(size_t levelIndex = 0; levelIndex < depth && created < config.objects; levelIndex++) {
+        std::vector<std::shared_ptr<Object>> next;
+
+        for(auto parent : level) {
+            for(size_t i = 0; i < fanout && created < config.objects; i++) {
+                auto instance = make_instance(created);
+                auto transform = instance->get_component<Transform>();
+
+                if(levelIndex == 0) {
+                    transform->position = glm::vec3((i % grid) * 3.0f - extent, 0.0f, (i / grid) * 3.0f - extent);
+                } else {
+                    transform->position = glm::vec3(unit(random), unit(random), unit(random)) * 1.5f;
+                    transform->scale = glm::vec3(0.7f);
+                }
+
+                parent->attach_child(instance);
+                next.push_back(instance);
+                created++;
+            }
+        }
+
+        level = next;
+    }
+
+    pepng::instantiate(root);
+
+    /**
+     * Camera
+     */
+    auto cameraObject = pepng::make_camera_object(
+        pepng::make_camera_transform(glm::vec3(0.0f, extent, extent * 2.0f + 5.0f), glm::vec3(25.0f, 0.0f, 0.0f)),
+        pepng::make_viewport(glm::vec2(0.0f), glm::vec2(1.0f)),
+        pepng::make_perspective(glm::radians(60.0f), pepng::windowX() / pepng::windowY(), 0.1f, extent * 8.0f + 50.0f)
+    );
+
+    // Before the lights, so the G-buffer gets the first light texture units.
+    if(config.deferred) {
+        cameraObject->get_component<Camera>()->set_deferred(pepng::make_deferred_shading(shaders.geometry, shaders.ambient, shaders.point_volume, shaders.spot_volume));
+    }
+
+    pepng::instantiate(cameraObject);
+
+    /**
+     * Lights (spotlights first, see bench::MAX_SHADOW_LIGHTS)
+     */
+    for(size_t i = 0; i < config.spotlights; i++) {
+        auto light = pepng::make_spotlight(shaders.spot_shadow, 60.0f, glm::vec3(1.0f, 0.9f, 0.8f), 1.0f);
+
+        light->set_shadows(config.shadows);
+
+        if(config.light_range > 0.0f) light->set_range(config.light_range);
+
+        auto lightObject = pepng::make_object("Spotlight");
+
+        lightObject->attach_component(pepng::make_transform(
+            glm::vec3(unit(random) * extent, 10.0f, unit(random) * extent),
+            glm::vec3(-80.0f, 360.0f * i / std::max<size_t>(config.spotlights, 1), 0.0f)
+        ));
+        lightObject->attach_component(light);
+
+        pepng::instantiate(lightObject);
+    }
+
+    for(size_t i = 0; i < config.point_lights; i++) {
+        auto light = pepng::make_point_light(shaders.point_shadow, glm::vec3(0.8f, 0.9f, 1.0f), 1.0f);
+
+        light->set_shadows(config.shadows);
+
+        if(config.light_range > 0.0f) light->set_range(config.light_range);
+
+        float angle = glm::two_pi<float>() * i / std::max<size_t>(config.point_lights, 1);
+
+        auto lightObject = pepng::make_object("Pointlight");
+
+        lightObject->attach_component(pepng::make_transform(glm::vec3(std::cos(angle) * extent, 5.0f, std::sin(angle) * extent)));
+        lightObject->attach_component(light);
+
+        pepng::instantiate(lightObject);
+    }
+
+    return root;
+}
+
+std::string bench::scene_json(const SceneConfig& config) {
+    std::stringstream ss;
+
+    ss  << "{ \"objects\": " << config.objects
+        << ", \"depth\": " << config.depth
+        << ", \"meshes\": " << config.meshes
+        << ", \"clone\": " << (config.clone ? "true" : "false")
+        << ", \"point_lights\": " << config.point_lights
+        << ", \"spotlights\": " << config.spotlights
+        << ", \"shadows\": " << (config.shadows ? "true" : "false")
+        << ", \"light_lists\": " << (config.light_lists ? "true" : "false")
+        << ", \"light_culling\": " << (config.light_culling ? "true" : "false")
+        << ", \"light_range\": " << config.light_range
+        << ", \"clustered\": " << (config.clustered ? "true" : "false")
+        << ", \"deferred\": " << (config.deferred ? "true" : "false")
+        << ", \"animate\": " << (config.animate ? "true" : "false")
+        << ", \"static\": " << (config.static_objects ? "true" : "false")
+        << ", \"seed\": " << config.seed
+        << " }";
+
+    return ss.str();
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <string>
+
+#include <pepng.h>
+
+namespace bench {
+    /**
+     * Parameters of a synthetic scene.
+     */
+    struct SceneConfig {
+        /**
+         * Number of rendered objects.
+         */
+        size_t objects;
+        /**
+         * Number of hierarchy levels below the scene root (1 makes all objects children of the root).
+         */
+        size_t depth;
+        /**
+         * Number of distinct generated meshes.
+         */
+        size_t meshes;
+        /**
+         * Are objects created with Object::clone (true) or share the mesh Models (false)?
+         */
+        bool clone;
+        size_t point_lights;
+        size_t spotlights;
+        bool shadows;
+        /**
+         * Does the scene shader only shade the lights listed for each draw (see Renderer::assign_lights)?
+         */
+        bool light_lists;
+        /**
+         * Are the light lists limited to the lights in range (see pepng::set_light_culling)?
+         */
+        bool light_culling;
+        /**
+         * The range of the lights (0 keeps the Light default).
+         */
+        float light_range;
+        /**
+         * Are the lights without shadows shaded through the light clusters (see pepng::set_clustered_lighting)?
+         */
+        bool clustered;
+        /**
+         * Does the camera render deferred (see Camera::set_deferred)?
+         */
+        bool deferred;
+        /**
+         * Do objects rotate every update (adds an update cost)?
+         */
+        bool animate;
+        /**
+         * Are the objects static (their shadows are cached, see Renderer::is_static)? With animate, only every 8th object spins.
+         */
+        bool static_objects;
+        unsigned int seed;
+    };
+
+    /**
+     * The shader programs used by the synthetic scenes.
+     */
+    struct SceneShaders {
+        GLuint object;
+        GLuint point_shadow;
+        GLuint spot_shadow;
+        /**
+         * The deferred shading programs (0 unless compiled with deferred).
+         */
+        GLuint geometry;
+        GLuint point_volume;
+        GLuint spot_volume;
+        GLuint ambient;
+    };
+
+    /**
+     * Maximum number of lights of each type in the scene shader.
+     */
+    const size_t MAX_LIGHTS = 8;
+
+    /**
+     * Maximum number of lights of each type in the scene shader with light lists.
+     */
+    const size_t MAX_LISTED_LIGHTS = 64;
+
+    /**
+     * Maximum number of lights of each type with clustered lighting.
+     */
+    const size_t MAX_CLUSTERED_LIGHTS = 1024;
+
+    /**
+     * Maximum number of lights of each type with deferred shading.
+     */
+    const size_t MAX_DEFERRED_LIGHTS = 1024;
+
+    /**
+     * Maximum number of lights with a shadow map (2 + index must be a valid texture unit).
+     */
+    const size_t MAX_SHADOW_LIGHTS = 12;
+
+    /**
+     * Component that rotates its transform (parallel safe).
+     */
+    class Spinner : public Component {
+        public:
+            static std::shared_ptr<Spinner> make_spinner(glm::vec3 degreesPerSecond);
+
+            virtual void update(std::shared_ptr<WithComponents> parent) override;
+
+            virtual bool parallel_safe() override { return true; }
+
+            /**
+             * Only holds its rate, so the prefab instances share it.
+             */
+            virtual bool instance_shared() override { return true; }
+
+            #ifdef IMGUI
+            virtual void imgui() override;
+            #endif
+
+        protected:
+            virtual Spinner* clone_implementation() override;
+
+            Spinner(glm::vec3 degreesPerSecond);
+            Spinner(const Spinner& spinner);
+
+        private:
+            glm::vec3 __degrees_per_second;
+    };
+
+    /**
+     * Compiles the scene shaders (embedded GLSL 330).
+     * 
+     * @param lightLists Does the object shader iterate the draw light lists (instead of every light slot)?
+     * @param clustered Does the object shader also iterate the lights of the fragment cluster?
+     * @param deferred Are the deferred shading programs compiled?
+     * @param shadowArrays Do the shaders sample the shadow arrays (see pepng::set_shadow_arrays)?
+     */
+    SceneShaders make_scene_shaders(bool lightLists = false, bool clustered = false, bool deferred = false, bool shadowArrays = false);
+
+    /**
+     * Generates a UV sphere (non indexed triangles with normals and UVs).
+     */
+    std::shared_ptr<Model> make_sphere(size_t segments, float radius);
+
+    /**
+     * Builds the scene into the pepng world (camera, lights and objects).
+     *
+     * @return The root Object.
+     */
+    std::shared_ptr<Object> build_scene(const SceneConfig& config, const SceneShaders& shaders);
+
+    /**
+     * Writes the scene config as a JSON object.
+     */
+    std::string scene_json(const SceneConfig& config);
+}
@@ -4,14 +4,16 @@ Camera::Camera(std::shared_ptr<Viewport> viewport, std::shared_ptr<Projection> p
     Component("Camera"),
     viewport(viewport),
     projection(projection),
-    __parent(nullptr)
+    __parent(),
+    __deferred(nullptr)
 {}
 
 Camera::Camera(const Camera& camera) :
     Component(camera),
     viewport(camera.viewport->clone()),
     projection(camera.projection->clone()),
-    __parent(camera.__parent)
+    __parent(camera.__parent),
+    __deferred(camera.__deferred)
 {}
 
 std::shared_ptr<Camera> Camera::current_camera = nullptr;
@@ -34,44 +36,97 @@ Camera* Camera::clone_implementation() {
 }
 
 void Camera::init(std::shared_ptr<WithComponents> parent) {
-    this->__parent = parent;
+    this->__parent = parent->handle();
+}
+
+void Camera::destroy(std::shared_ptr<WithComponents> parent) {
+    auto& cameras = Camera::cameras;
+
+    for(size_t i = 0; i < cameras.size(); i++) {
+        if(cameras.at(i).get() == this) {
+            cameras.at(i) = cameras.back();
+            cameras.pop_back();
+
+            break;
+        }
+    }
+
+    if(Camera::current_camera.get() == this) {
+        Camera::current_camera = nullptr;
+    }
+
+    this->__parent = Handle<WithComponents>();
 }
 
 void Camera::render(GLuint shaderProgram) {
-    glUniformMatrix4fv(
-        glGetUniformLocation(shaderProgram, "u_projection"),
-        1,
-        GL_FALSE,
-        glm::value_ptr(this->projection->matrix())
-    );
+    Camera::render(this->state(), shaderProgram);
+}
+
+CameraState Camera::state(float alpha) {
+    CameraState state;
+
+    state.viewport_position = this->viewport->position;
+    state.viewport_scale = this->viewport->scale;
+    state.viewport_active = this->viewport->active();
+    state.projection = this->projection->matrix();
+    state.has_transform = false;
+    state.deferred = this->__deferred;
 
     // TODO: Should we throw if there is no parent?
-    if(this->__parent == nullptr) return;
+    auto parent = this->__parent.get();
 
-    auto transform = this->__parent->get_component<Transform>();
+    if(parent == nullptr) return state;
+
+    auto transform = parent->get_component<Transform>();
 
     if(transform == nullptr) {
         std::stringstream ss;
 
-        ss << *this->__parent << " is being rendered without a transform.";
+        ss << *parent << " is being rendered without a transform.";
 
         std::cout << ss.str() << std::endl;
 
         throw std::runtime_error(ss.str());
     }
 
-    glUniform3fv(
-        glGetUniformLocation(shaderProgram, "u_camera_pos"),
-        1,
-        glm::value_ptr(transform->position)
-    );
+    state.has_transform = true;
+    state.position = transform->interpolated_position(alpha);
+    state.view = transform->view_matrix(alpha);
+
+    return state;
+}
 
-    glUniformMatrix4fv(
-        glGetUniformLocation(shaderProgram, "u_view"),
-        1,
-        GL_FALSE,
-        glm::value_ptr(transform->view_matrix())
+void Camera::render(const CameraState& state, GLuint shaderProgram) {
+    CommandBuffer commands;
+
+    Camera::record(commands, state, shaderProgram);
+
+    commands.replay();
+}
+
+void Camera::record(CommandBuffer& commands, const CameraState& state, GLuint shaderProgram) {
+    commands.uniform("u_projection", &state.projection);
+
+    if(!state.has_transform) return;
+
+    commands.uniform("u_camera_pos", state.position);
+
+    commands.uniform("u_view", &state.view);
+}
+
+bool Camera::render_viewport(const CameraState& state, glm::vec2 windowDimension) {
+    if(!state.viewport_active) {
+        return false;
+    }
+
+    glViewport(
+        state.viewport_position.x * windowDimension.x, 
+        state.viewport_position.y * windowDimension.y, 
+        state.viewport_scale.x * windowDimension.x, 
+        state.viewport_scale.y * windowDimension.y
     );
+
+    return true;
 }
 
 Viewport::Viewport(glm::vec2 position, glm::vec2 scale) : 
@@ -8,6 +8,10 @@
 
 #include "component.hpp"
 #include "transform.hpp"
+#include "../gl/command_buffer.hpp"
+
+class Camera;
+class DeferredShading;
 
 /**
  * Viewport used for glViewport (which uses relative position instead of absolute).
@@ -134,6 +138,48 @@ class Perspective : public Projection {
         float __far;
 };
 
+/**
+ * Copy of the Camera values used when rendering (see RenderSnapshot).
+ */
+struct CameraState {
+    /**
+     * The camera that this state was copied from.
+     */
+    std::shared_ptr<Camera> camera;
+    /**
+     * The relative XY position of the viewport.
+     */
+    glm::vec2 viewport_position;
+    /**
+     * The relative XY scale of the viewport.
+     */
+    glm::vec2 viewport_scale;
+    /**
+     * Is the viewport visible?
+     */
+    bool viewport_active;
+    /**
+     * The projection matrix.
+     */
+    glm::mat4 projection;
+    /**
+     * The view matrix (only set if has_transform).
+     */
+    glm::mat4 view;
+    /**
+     * The camera world position (only set if has_transform).
+     */
+    glm::vec3 position;
+    /**
+     * Does the camera have a parent transform?
+     */
+    bool has_transform;
+    /**
+     * The deferred shading of the camera (nullptr renders forward).
+     */
+    std::shared_ptr<DeferredShading> deferred;
+};
+
 /**
  * The Camera component used in rendering.
  */
@@ -164,10 +210,52 @@ class Camera : public Component {
          */
         std::shared_ptr<Viewport> viewport;
 
+        /**
+         * Accessor for the deferred shading (nullptr if the camera renders forward).
+         */
+        inline std::shared_ptr<DeferredShading> deferred() { return this->__deferred; }
+
+        /**
+         * Mutator for the deferred shading (nullptr renders forward, the deferred shading can be shared by cameras).
+         */
+        inline void set_deferred(std::shared_ptr<DeferredShading> deferred) { this->__deferred = deferred; }
+
         void render(GLuint shaderProgram);
 
+        /**
+         * Copies the current camera values.
+         * 
+         * @param alpha The transform interpolation factor (see Transform::view_matrix).
+         * @throw If the camera parent has no transform.
+         */
+        CameraState state(float alpha = 1.0f);
+
+        /**
+         * Binds the camera values to the shader program.
+         */
+        static void render(const CameraState& state, GLuint shaderProgram);
+
+        /**
+         * Records the camera uniforms for the shader program.
+         */
+        static void record(CommandBuffer& commands, const CameraState& state, GLuint shaderProgram);
+
+        /**
+         * Applies the camera viewport.
+         * 
+         * @return If the viewport is visible.
+         */
+        static bool render_viewport(const CameraState& state, glm::vec2 windowDimension);
+
         virtual void init(std::shared_ptr<WithComponents> parent) override;
 
+        /**
+         * Removes the camera from Camera::cameras (swap and pop) and clears the parent handle.
+         */
+        virtual void destroy(std::shared_ptr<WithComponents> parent) override;
+
+        virtual bool parallel_safe() override { return true; }
+
         #ifdef IMGUI
         virtual void imgui() override;
         #endif
@@ -182,8 +270,12 @@ class Camera : public Component {
         /**
          * Pointer to the parent component of the camera.
          * We store this because camera rendering doesn't fall in the update/rendering stage.
+         * 
+         * A handle, as the parent owns the camera (a shared_ptr would keep both alive).
          */
-        std::shared_ptr<WithComponents> __parent;
+        Handle<WithComponents> __parent;
+
+        std::shared_ptr<DeferredShading> __deferred;
 };
 
 namespace pepng {
@@ -1,15 +1,46 @@
 #include "component.hpp"
 
+float Component::__delta_time = 1.0f / 60.0f;
+bool Component::__fixed_step = false;
+
 Component::Component(std::string name) : 
     _name(name),
-    _is_active(true)
+    _is_active(true),
+    __handle(Component::slots().insert(this))
 {}
 
 Component::Component(const Component& component) : 
     _name(component._name),
-    _is_active(component._is_active)
+    _is_active(component._is_active),
+    __handle(Component::slots().insert(this))
 {}
 
+Component::~Component() {
+    Component::slots().erase(this->__handle);
+}
+
+SlotMap<Component>& Component::slots() {
+    static auto slots = new SlotMap<Component>();
+
+    return *slots;
+}
+
+float Component::delta_time() {
+    return Component::__delta_time;
+}
+
+void Component::set_delta_time(float deltaTime) {
+    Component::__delta_time = deltaTime;
+}
+
+bool Component::fixed_step() {
+    return Component::__fixed_step;
+}
+
+void Component::set_fixed_step(bool fixedStep) {
+    Component::__fixed_step = fixedStep;
+}
+
 std::ostream& Component::operator_ostream(std::ostream& os) const {
     os << "Component { " << this->_name << " }";
 
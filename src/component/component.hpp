@@ -15,6 +15,7 @@
 #endif
 
 #include "../util/cloneable.hpp"
+#include "../util/handle.hpp"
 
 class WithComponents;
 
@@ -28,6 +29,8 @@ class Component :
     public Cloneable<Component> 
 {
     public:
+        virtual ~Component();
+
         /**
          * Accessor for the component name.
          */
@@ -56,6 +59,68 @@ class Component :
 
         virtual void update(std::shared_ptr<WithComponents> parent) {};
 
+        /**
+         * Called when the parent is removed from the world (see pepng::destroy).
+         *
+         * Components registered globally unregister here.
+         */
+        virtual void destroy(std::shared_ptr<WithComponents> parent) {};
+
+        /**
+         * The simulated time (in seconds) of the current update.
+         * 
+         * Equals the fixed timestep when it is enabled (see pepng::set_fixed_timestep), otherwise the frame time.
+         */
+        static float delta_time();
+
+        /**
+         * Mutator for the update delta time (set by the frame loop).
+         */
+        static void set_delta_time(float deltaTime);
+
+        /**
+         * Can update run on a worker thread during the parallel update?
+         * 
+         * Components that touch Input, OpenGL or state outside of their parent must keep this false (they are updated on the main thread).
+         */
+        virtual bool parallel_safe() { return false; }
+
+        /**
+         * Does update consume the input of the frame (mouse deltas, button presses)?
+         * 
+         * With a fixed timestep, these components update once per frame (with the frame time) instead of once per step,
+         * so a press or a mouse move is applied exactly once (see Object::update_frame).
+         */
+        virtual bool per_frame() { return false; }
+
+        /**
+         * Is a fixed step running (the Component::per_frame components are skipped)?
+         */
+        static bool fixed_step();
+
+        /**
+         * Mutator for the fixed step state (set by the frame loop).
+         */
+        static void set_fixed_step(bool fixedStep);
+
+        /**
+         * Can prefab instances share this component instead of cloning it (see Prefab)?
+         *
+         * Only components without per-object state (init must not store its parent) can return true.
+         * The instances then share its settings and active state.
+         */
+        virtual bool instance_shared() { return false; }
+
+        /**
+         * Accessor for the handle (a non owning reference, see Handle).
+         */
+        inline Handle<Component> handle() const { return this->__handle; }
+
+        /**
+         * The slots of every component (never destroyed so components released during exit can still erase their slot).
+         */
+        static SlotMap<Component>& slots();
+
         #ifdef IMGUI
         virtual void imgui() override;
         #endif
@@ -74,6 +139,13 @@ class Component :
          * Name of the component (the child class will define this in the constructor).
          */
         std::string _name;
+
+    private:
+        static float __delta_time;
+
+        static bool __fixed_step;
+
+        Handle<Component> __handle;
 };
 
 std::ostream& operator<<(std::ostream& os, const Component& component);
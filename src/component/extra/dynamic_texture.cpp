@@ -54,7 +54,7 @@ void DynamicTexture::update(std::shared_ptr<WithComponents> parent) {
         this->current_index = this->start_texture_index;
     }
 
-    renderer->material->texture = pepng::make_texture(this->current_index);
+    renderer->unique_material()->texture = pepng::make_texture(this->current_index);
 }
 
 #ifdef IMGUI
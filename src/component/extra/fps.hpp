@@ -11,6 +11,16 @@ class FPS : public Component {
 
         virtual void update(std::shared_ptr<WithComponents> parent) override;
 
+        /**
+         * Reads the input of the frame.
+         */
+        virtual bool per_frame() override { return true; }
+
+        /**
+         * Only holds speeds, so the prefab instances share it (and its speeds).
+         */
+        virtual bool instance_shared() override { return true; }
+
         #ifdef IMGUI
         virtual void imgui() override;
         #endif
@@ -44,6 +44,11 @@ class Selector : public Component {
 
         virtual void update(std::shared_ptr<WithComponents> parent) override;
 
+        /**
+         * Reads the input of the frame.
+         */
+        virtual bool per_frame() override { return true; }
+
         #ifdef IMGUI
         virtual void imgui() override;
         #endif
@@ -52,28 +52,31 @@ void Transformer::update(std::shared_ptr<WithComponents> parent) {
 
     auto input = Input::get();
 
+    // Speeds are per second.
+    auto deltaTime = Component::delta_time();
+
     auto deltaPosition = glm::vec4(input->axis("horizontal"), 0.0f, input->axis("vertical"), 0.0f);
 
     if (glm::length(deltaPosition) > 0.0f) {
-        transform->position += glm::vec3(transform->rotation_matrix() * deltaPosition) * this->__position_speed;
+        transform->position += glm::vec3(transform->rotation_matrix() * deltaPosition) * this->__position_speed * deltaTime;
     }
 
     auto deltaShear = glm::vec3(input->axis("shorizontal"), 0.0f, input->axis("svertical"));
 
     if (glm::length(deltaShear) > 0.0f) {
-        transform->shear += deltaShear * this->__position_speed;
+        transform->shear += deltaShear * this->__position_speed * deltaTime;
     }
 
     auto deltaRotation = glm::vec3(input->axis("yaw"), 0.0f, input->axis("pitch"));
 
     if (glm::length(deltaRotation) > 0.0f) {
-        transform->delta_rotate(deltaRotation * this->__rotation_speed);
+        transform->delta_rotate(deltaRotation * this->__rotation_speed * deltaTime);
     }
 
     auto deltaScale = glm::vec3(input->axis("scale"));
 
     if (glm::length(deltaScale) > 0.0f) {
-        transform->scale += deltaScale * this->__scale_speed;
+        transform->scale += deltaScale * this->__scale_speed * deltaTime;
     }
 
     if(input->button_down("recenter")) {
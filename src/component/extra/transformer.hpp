@@ -7,10 +7,20 @@
  */
 class Transformer : public Component {
     public:
-        static std::shared_ptr<Transformer> make_transformer(float positionSpeed = 0.1f, float rotationSpeed = 1.0f, float scaleSpeed = 0.01f);
+        static std::shared_ptr<Transformer> make_transformer(float positionSpeed = 6.0f, float rotationSpeed = 60.0f, float scaleSpeed = 0.6f);
 
         virtual void update(std::shared_ptr<WithComponents> parent) override;
 
+        /**
+         * Reads the input of the frame.
+         */
+        virtual bool per_frame() override { return true; }
+
+        /**
+         * Only holds speeds, so the prefab instances share it (and its speeds).
+         */
+        virtual bool instance_shared() override { return true; }
+
         #ifdef IMGUI
         virtual void imgui() override;
         #endif
@@ -37,5 +47,5 @@ class Transformer : public Component {
 };
 
 namespace pepng {
-    std::shared_ptr<Transformer> make_transformer(float positionSpeed = 0.1f, float rotationSpeed = 1.0f, float scaleSpeed = 0.01f);
+    std::shared_ptr<Transformer> make_transformer(float positionSpeed = 6.0f, float rotationSpeed = 60.0f, float scaleSpeed = 0.6f);
 };
\ No newline at end of file
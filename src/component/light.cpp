@@ -1,8 +1,63 @@
 #include "light.hpp"
 
-int Light::__count = 0;
+#include <sstream>
+
+#include "../gl/render_target.hpp"
+#include "../core/shadow_array.hpp"
+
+LightSlots Light::__texture_slots("");
+#ifndef EMSCRIPTEN
+std::mutex Light::_released_mutex;
+std::mutex Light::__destroyed_mutex;
+#endif
+GLuint Light::__copy_fbos[2] = { 0, 0 };
 std::vector<std::shared_ptr<Light>> Light::lights;
 
+LightSlots::LightSlots(const std::string& uniform) :
+    __uniform(uniform),
+    __count(0)
+{
+    LightSlots::registry().push_back(this);
+}
+
+std::vector<LightSlots*>& LightSlots::registry() {
+    static std::vector<LightSlots*> registry;
+
+    return registry;
+}
+
+int LightSlots::acquire() {
+    if(this->__released.empty()) return this->__count++;
+
+    auto slot = this->__released.back();
+
+    this->__released.pop_back();
+
+    return slot;
+}
+
+void LightSlots::release(int slot) {
+    this->__released.push_back(slot);
+}
+
+std::vector<std::string> LightSlots::disabled_uniforms() {
+    std::vector<std::string> uniforms;
+
+    for(auto slots : LightSlots::registry()) {
+        if(slots->__uniform.empty()) continue;
+
+        for(auto slot : slots->__released) {
+            std::stringstream ss;
+
+            ss << slots->__uniform << "[" << slot << "].is_active";
+
+            uniforms.push_back(ss.str());
+        }
+    }
+
+    return uniforms;
+}
+
 Light::Light(GLuint shader_program, glm::vec3 color, float intensity) : 
     Component("Light"),
     _shader_program(shader_program),
@@ -11,7 +66,16 @@ Light::Light(GLuint shader_program, glm::vec3 color, float intensity) :
     _intensity(intensity),
     _color(color),
     _shadows(true),
-    _texture_index(Light::__count++)
+    _texture(0),
+    _fbo(0),
+    _static_texture(0),
+    _static_fbo(0),
+    _texture_target(GL_TEXTURE_2D),
+    _shared_target(false),
+    _texture_index(-1),
+    __registered(false),
+    __static_signature(0),
+    __shadow_signature(0)
 {}
 
 Light::Light(const Light& light) : 
@@ -22,13 +86,34 @@ Light::Light(const Light& light) :
     _intensity(light._intensity),
     _color(light._color),
     _shadows(light._shadows),
-    _texture_index(Light::__count++)
+    _texture(0),
+    _fbo(0),
+    _static_texture(0),
+    _static_fbo(0),
+    _texture_target(light._texture_target),
+    _shared_target(false),
+    _texture_index(-1),
+    __registered(false),
+    __static_signature(0),
+    __shadow_signature(0)
 {}
 
+void Light::register_light(std::shared_ptr<Light> light) {
+    light->_texture_index = light->has_texture_unit() ? Light::__texture_slots.acquire() : -1;
+    light->acquire_slot();
+    light->__registered = true;
+
+    Light::lights.push_back(light);
+}
+
+GLint Light::reserve_texture_unit() {
+    return 2 + Light::__texture_slots.acquire();
+}
+
 void Light::init(std::shared_ptr<WithComponents> parent) {
-    this->_transform = parent->get_component<Transform>();
+    this->_transform = parent->get_handle<Transform>();
 
-    if(this->_transform == nullptr) {
+    if(this->_transform.is_null()) {
         std::stringstream ss;
 
         ss << "Light does not have a transform.";
@@ -39,16 +124,221 @@ void Light::init(std::shared_ptr<WithComponents> parent) {
     }
 }
 
-void Light::update_fbo() {
-    #ifdef EMSCRIPTEN
-    glDrawBuffers(0, nullptr);
-    #else
-    glDrawBuffer(GL_NONE);
+void Light::destroy(std::shared_ptr<WithComponents> parent) {
+    if(!this->__registered) return;
+
+    this->__registered = false;
+
+    auto& lights = Light::lights;
+
+    for(size_t i = 0; i < lights.size(); i++) {
+        if(lights.at(i).get() == this) {
+            {
+                #ifndef EMSCRIPTEN
+                std::lock_guard<std::mutex> lock(Light::__destroyed_mutex);
+                #endif
+
+                // Snapshots captured before may still initialize the shadow maps, so they are released after them.
+                Light::destroyed().push_back(lights.at(i));
+            }
+
+            lights.at(i) = lights.back();
+            lights.pop_back();
+
+            break;
+        }
+    }
+
+    if(this->_texture_index >= 0) Light::__texture_slots.release(this->_texture_index);
+
+    this->release_slot();
+}
+
+std::vector<std::shared_ptr<Light>>& Light::destroyed() {
+    static auto destroyed = new std::vector<std::shared_ptr<Light>>();
+
+    return *destroyed;
+}
+
+std::vector<std::shared_ptr<Light>> Light::take_destroyed() {
+    std::vector<std::shared_ptr<Light>> lights;
+
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(Light::__destroyed_mutex);
     #endif
-    glReadBuffer(GL_NONE);
+
+    lights.swap(Light::destroyed());
+
+    return lights;
+}
+
+void Light::return_destroyed(const std::vector<std::shared_ptr<Light>>& lights) {
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(Light::__destroyed_mutex);
+    #endif
+
+    Light::destroyed().insert(Light::destroyed().end(), lights.begin(), lights.end());
+}
+
+void Light::release_shadow_maps() {
+    this->release();
+}
+
+void Light::init_fbo() {
+    auto state = this->state();
+
+    this->init_fbo(state);
+}
+
+void Light::init_fbo(const LightState& state) {
+    this->delayed_init();
+
+    // Drawn outside of the shadow pass, so it is not the static casters cache anymore.
+    this->__shadow_signature = 0;
+
+    CommandBuffer commands;
+
+    this->record_fbo(commands, state);
+
+    commands.replay();
+}
+
+void Light::record_fbo(CommandBuffer& commands, const LightState& state) {
+    this->record_fbo(commands, state, this->_fbo, true);
+}
+
+void Light::init_static_map() {
+    if(this->_static_fbo != 0) return;
+
+    this->acquire_target(this->_static_fbo, this->_static_texture, true);
+
+    this->__static_signature = 0;
+}
+
+void Light::copy_static_map(const LightState& state) {
+    if(Light::__copy_fbos[0] == 0) {
+        glGenFramebuffers(2, Light::__copy_fbos);
+
+        // Depth only (the frame buffers are incomplete with the default color buffers).
+        for(auto fbo : Light::__copy_fbos) {
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+            #ifdef EMSCRIPTEN
+            glDrawBuffers(0, nullptr);
+            #else
+            glDrawBuffer(GL_NONE);
+            #endif
+            glReadBuffer(GL_NONE);
+        }
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, Light::__copy_fbos[0]);
+
+    // The static casters map has the size of the shadow map (the atlas tiles draw their static casters again, see pepng::extra::render_shadows).
+    auto size = this->shadow_size();
+
+    // The layered attachments cannot be blitted at once, so the cube maps are copied face by face.
+    bool cube = this->_texture_target == GL_TEXTURE_CUBE_MAP;
+
+    for(int i = 0; i < (cube ? 6 : 1); i++) {
+        GLenum face = cube ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + i : GL_TEXTURE_2D;
+
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, face, this->_static_texture, 0);
+
+        // The array layer faces have their own frame buffers.
+        if(this->_array) {
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, this->_array->face_fbo(state.slot, i));
+        } else {
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, Light::__copy_fbos[1]);
+            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, face, this->_texture, 0);
+        }
+
+        glBlitFramebuffer(0, 0, size, size, 0, 0, size, size, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    }
+
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+int Light::shadow_size() {
+    return this->_array ? ShadowArray::RESOLUTION : Light::SHADOW_SIZE;
+}
+
+GLuint Light::shadow_texture() {
+    return this->_array ? this->_array->texture() : this->_texture;
+}
+
+GLenum Light::shadow_target() {
+    return this->_array ? this->_array->target() : this->_texture_target;
+}
+
+void Light::render(GLuint shaderProgram) {
+    auto state = this->state();
+
+    this->render(state, shaderProgram);
+}
+
+void Light::render(const LightState& state, GLuint shaderProgram) {
+    this->delayed_init();
+
+    CommandBuffer commands;
+
+    this->record(commands, state, shaderProgram);
+
+    commands.replay();
+}
+
+std::vector<LightState> Light::states() {
+    std::vector<LightState> states;
+
+    states.reserve(Light::lights.size());
+
+    for(auto light : Light::lights) {
+        states.push_back(light->state());
+    }
+
+    return states;
+}
+
+LightState Light::state(float alpha) {
+    LightState state;
+
+    auto transform = this->_transform.get();
+
+    state.type = LightType::OTHER;
+    state.slot = -1;
+    state.texture_unit = 2 + this->_texture_index;
+    state.is_active = this->_is_active && transform != nullptr;
+    state.shadows = this->_shadows;
+    state.position = transform ? transform->interpolated_position(alpha) : glm::vec3(0.0f);
+    state.direction = transform ? -transform->interpolated_forward(alpha) : glm::vec3(0.0f, 0.0f, -1.0f);
+    state.color = this->_color;
+    state.intensity = this->_intensity;
+    state.near_plane = this->_near;
+    state.far_plane = this->_far;
+    state.angle = 0.0f;
+    state.matrix = glm::mat4(1.0f);
+    state.shadow_matrix = glm::mat4(1.0f);
+    state.atlas_tile = glm::ivec3(0);
+    state.static_signature = 0;
+
+    return state;
+}
+
+void Light::update_fbo() {
+    CommandBuffer commands;
+
+    this->record_update_fbo(commands);
+
+    commands.replay();
+}
+
+void Light::record_update_fbo(CommandBuffer& commands) {
+    commands.disable_color_buffers();
+    commands.bind_framebuffer(RenderTarget::framebuffer());
+}
+
+void Light::record_caster(CommandBuffer& commands, const LightState& state, const DrawItem& item) {}
+
 #ifdef IMGUI
 void Light::imgui() {
     Component::imgui();
@@ -56,6 +346,7 @@ void Light::imgui() {
     ImGui::InputFloat("Near", &this->_near);
     ImGui::InputFloat("Far", &this->_far);
     ImGui::InputFloat("Intensity", &this->_intensity);
+    ImGui::Checkbox("Shadows", &this->_shadows);
     ImGui::ColorPicker3("Color", glm::value_ptr(this->_color));
 }
 #endif
\ No newline at end of file
@@ -2,6 +2,12 @@
 
 #include <vector>
 #include <memory>
+#include <string>
+#include <cstdint>
+
+#ifndef EMSCRIPTEN
+#include <mutex>
+#endif
 
 #include <GL/glew.h>
 
@@ -9,19 +15,305 @@
 #include "with_components.hpp"
 #include "transform.hpp"
 #include "../util/delayed_init.hpp"
+#include "../util/memory.hpp"
+#include "../gl/command_buffer.hpp"
+
+class Light;
+class ShadowArray;
+struct DrawItem;
+
+/**
+ * The shader array of a light (lights of other types are not put in the per draw light lists).
+ */
+enum class LightType {
+    OTHER,
+    POINT,
+    SPOT
+};
+
+/**
+ * Copy of the Light values used when rendering (see RenderSnapshot).
+ */
+struct LightState {
+    /**
+     * The light that this state was copied from (used for the OpenGL objects).
+     */
+    std::shared_ptr<Light> light;
+    LightType type;
+    /**
+     * The index in the shader array of the type (e.g. u_pointlights).
+     */
+    int slot;
+    /**
+     * The texture unit of the shadow map.
+     */
+    GLint texture_unit;
+    bool is_active;
+    bool shadows;
+    glm::vec3 position;
+    glm::vec3 direction;
+    glm::vec3 color;
+    float intensity;
+    float near_plane;
+    float far_plane;
+    /**
+     * The cone angle in degrees (spotlights only).
+     */
+    float angle;
+    /**
+     * The light projection matrix (spotlights only).
+     */
+    glm::mat4 matrix;
+    /**
+     * The light projection matrix of the shadow map lookups (the matrix mapped to the atlas tile, see ShadowAtlas).
+     */
+    glm::mat4 shadow_matrix;
+    /**
+     * The shadow atlas tile (x, y and size in texels, size 0 if the light is not in the atlas).
+     */
+    glm::ivec3 atlas_tile;
+    /**
+     * The static draws casting a shadow in range (indices in RenderSnapshot::draws, filled for lights with shadows).
+     */
+    std::vector<size_t> static_casters;
+    /**
+     * The other draws casting a shadow in range (drawn over the cached static casters every frame).
+     */
+    std::vector<size_t> dynamic_casters;
+    /**
+     * Hash of the shadow values and the static casters in range (changes when the light or one of them moves, never 0).
+     */
+    uint64_t static_signature;
+};
+
+/**
+ * Allocates the shader array slots of a light type (released slots are reused first).
+ */
+class LightSlots {
+    public:
+        /**
+         * @param uniform The uniform array name (empty if the slots are not a uniform array).
+         */
+        LightSlots(const std::string& uniform);
+
+        int acquire();
+
+        void release(int slot);
+
+        /**
+         * The uniforms that disable the released slots of every light type (e.g. u_pointlights[2].is_active).
+         */
+        static std::vector<std::string> disabled_uniforms();
+
+    private:
+        std::string __uniform;
+
+        int __count;
+
+        std::vector<int> __released;
+
+        static std::vector<LightSlots*>& registry();
+};
 
 class Light : public Component, public DelayedInit {
     public:
         static std::vector<std::shared_ptr<Light>> lights;
 
-        virtual void init_fbo() = 0;
-        virtual void update_fbo();
-        virtual void render(GLuint shaderProgram) = 0;
+        /**
+         * The width and height of the shadow maps that a light owns (its shadow map and its static casters map).
+         */
+        static constexpr int SHADOW_SIZE = 1024;
+
+        /**
+         * Reserves a texture unit that no light shadow map uses (e.g. for LightClusters).
+         */
+        static GLint reserve_texture_unit();
+
+        /**
+         * Removes the light from Light::lights (swap and pop) and releases its slots.
+         *
+         * The shadow maps are released later on the OpenGL thread (see Light::take_destroyed).
+         */
+        virtual void destroy(std::shared_ptr<WithComponents> parent) override;
+
+        /**
+         * Takes the lights destroyed since the last call (must be called from the update thread, see RenderSnapshot::capture).
+         *
+         * Their shadow maps are released by Light::release_shadow_maps once the snapshots captured before are rendered.
+         */
+        static std::vector<std::shared_ptr<Light>> take_destroyed();
+
+        /**
+         * Gives back destroyed lights that were taken but not released (e.g. by a snapshot that was never rendered).
+         */
+        static void return_destroyed(const std::vector<std::shared_ptr<Light>>& lights);
+
+        /**
+         * Releases the shadow maps of a destroyed light (must be called from the OpenGL thread).
+         */
+        void release_shadow_maps();
+
+        /**
+         * Initializes the frame buffer with the current light values.
+         */
+        void init_fbo();
+
+        /**
+         * Initializes the frame buffer from a light state (records and replays Light::record_fbo).
+         */
+        void init_fbo(const LightState& state);
+
+        /**
+         * Restores the default frame buffer (records and replays Light::record_update_fbo).
+         */
+        void update_fbo();
+
+        /**
+         * Attaches the current light values to the shader program.
+         */
+        void render(GLuint shaderProgram);
+
+        /**
+         * Attaches a light state to the shader program (records and replays Light::record).
+         */
+        void render(const LightState& state, GLuint shaderProgram);
+
+        /**
+         * Copies the current light values.
+         * 
+         * @param alpha The transform interpolation factor (see Transform::interpolated_position).
+         */
+        virtual LightState state(float alpha = 1.0f);
+
+        /**
+         * Copies the current values of every registered light (built once per pass, see Object::render).
+         */
+        static std::vector<LightState> states();
+
+        /**
+         * Records the frame buffer initialization of a light state (clears the shadow map).
+         *
+         * The light must be initialized (see Light::delayed_init).
+         */
+        void record_fbo(CommandBuffer& commands, const LightState& state);
+
+        /**
+         * Records the frame buffer initialization of a light state for a shadow frame buffer (see Light::static_fbo).
+         *
+         * @param clear Is the depth cleared (false draws over the copied static casters, see Light::copy_static_map)?
+         */
+        virtual void record_fbo(CommandBuffer& commands, const LightState& state, GLuint fbo, bool clear) = 0;
+
+        /**
+         * Records the end of the shadow pass (binds back the frame target, see RenderTarget::current_target).
+         */
+        virtual void record_update_fbo(CommandBuffer& commands);
+
+        /**
+         * Records the uniforms of a shadow caster draw of a light state (e.g. the cube faces it does not touch).
+         *
+         * Called from the recording jobs, so it must only read the state and the draw.
+         */
+        virtual void record_caster(CommandBuffer& commands, const LightState& state, const DrawItem& item);
+
+        /**
+         * Records the light state uniforms for the shader program.
+         *
+         * The light must be initialized (see Light::delayed_init).
+         */
+        virtual void record(CommandBuffer& commands, const LightState& state, GLuint shaderProgram) = 0;
 
         inline GLuint shader_program() { return _shader_program; }
 
+        /**
+         * Accessor for the shadow map texture (0 until the light is initialized, the atlas texture with an atlas, 0 with a shadow array).
+         */
+        inline GLuint texture() { return this->_texture; }
+
+        /**
+         * Accessor for the shadow map frame buffer (0 until the light is initialized).
+         */
+        inline GLuint fbo() { return this->_fbo; }
+
+        /**
+         * The width and height of the shadow map that the light renders into (ShadowArray::RESOLUTION with a shadow array, Light::SHADOW_SIZE otherwise).
+         *
+         * With an atlas, the light renders into its tile instead (see LightState::atlas_tile).
+         */
+        int shadow_size();
+
+        /**
+         * Accessor for the sampled shadow map (the shadow array of the light type, or Light::texture).
+         */
+        GLuint shadow_texture();
+
+        /**
+         * Accessor for the texture target of the sampled shadow map (e.g. GL_TEXTURE_CUBE_MAP_ARRAY with a shadow array).
+         */
+        GLenum shadow_target();
+
+        /**
+         * Initializes the frame buffer of the static casters (must be called from the OpenGL thread).
+         *
+         * The static casters are cached apart only when dynamic casters are in range (otherwise the shadow map is the cache).
+         */
+        void init_static_map();
+
+        /**
+         * Accessor for the frame buffer of the static casters (0 until Light::init_static_map).
+         */
+        inline GLuint static_fbo() { return this->_static_fbo; }
+
+        /**
+         * Copies the static casters into the shadow map of the state (must be called from the OpenGL thread, binds the draw frame buffer).
+         */
+        void copy_static_map(const LightState& state);
+
+        /**
+         * Accessor for the signature of the static casters map (see LightState::static_signature, 0 if invalid).
+         */
+        inline uint64_t static_signature() { return this->__static_signature; }
+
+        inline void set_static_signature(uint64_t signature) { this->__static_signature = signature; }
+
+        /**
+         * Accessor for the signature of the shadow map when it only holds the static casters (0 otherwise).
+         *
+         * The shadow pass is skipped while it matches the light state (nothing in range moved).
+         */
+        inline uint64_t shadow_signature() { return this->__shadow_signature; }
+
+        inline void set_shadow_signature(uint64_t signature) { this->__shadow_signature = signature; }
+
+        /**
+         * Can the shadow pass of the state be skipped (no dynamic caster in range and the shadow map signature matches)?
+         */
+        inline bool is_shadow_cached(const LightState& state) { return state.dynamic_casters.empty() && this->__shadow_signature == state.static_signature; }
+
+        /**
+         * Accessor for shadows.
+         */
+        inline bool shadows() { return this->_shadows; }
+
+        /**
+         * Mutator for shadows (lights without shadows skip the shadow pass).
+         */
+        inline void set_shadows(bool shadows) { this->_shadows = shadows; }
+
+        /**
+         * Accessor for the range (also the far plane of the shadow map).
+         */
+        inline float range() { return this->_far; }
+
+        /**
+         * Mutator for the range (the light is left out of the light lists of draws beyond it, see Renderer::assign_lights).
+         */
+        inline void set_range(float range) { this->_far = range; }
+
         virtual void init(std::shared_ptr<WithComponents> parent) override;
 
+        virtual bool parallel_safe() override { return true; }
+
         #ifdef IMGUI
         virtual void imgui() override;
         #endif
@@ -30,10 +322,30 @@ class Light : public Component, public DelayedInit {
         Light(GLuint shader_program, glm::vec3 color, float intensity);
         Light(const Light& light);
 
-        std::shared_ptr<Transform> _transform;
+        /**
+         * The parent transform (not owned, the parent owns the light).
+         */
+        Handle<Transform> _transform;
         GLuint _texture;
         int _texture_index;
         GLuint _fbo;
+        /**
+         * The shadow map of the static casters (see Light::init_static_map).
+         */
+        GLuint _static_texture;
+        GLuint _static_fbo;
+        /**
+         * The texture target of the shadow maps (GL_TEXTURE_CUBE_MAP or GL_TEXTURE_2D).
+         */
+        GLenum _texture_target;
+        /**
+         * The shadow array of the light type (nullptr if the light samples its own shadow map, see ShadowArray).
+         */
+        std::shared_ptr<ShadowArray> _array;
+        /**
+         * Is the shadow map shared by the lights of the type (the atlas or the shadow array, not released with the light)?
+         */
+        bool _shared_target;
         GLuint _shader_program;
         bool _shadows;
         float _near;
@@ -41,6 +353,73 @@ class Light : public Component, public DelayedInit {
         float _intensity;
         glm::vec3 _color;
     
+        /**
+         * Adds the light to Light::lights and acquires its slots (the clones that are not registered hold none).
+         */
+        static void register_light(std::shared_ptr<Light> light);
+
+        /**
+         * Does the light bind its shadow map to its own texture unit (false if it shares the unit of its atlas or shadow array)?
+         *
+         * Only the lights with their own unit take one from Light::reserve_texture_unit, so the shared units do not limit the light count.
+         */
+        virtual bool has_texture_unit() = 0;
+
+        /**
+         * Acquires the shader slot of the light type (called once by Light::register_light).
+         */
+        virtual void acquire_slot() = 0;
+
+        /**
+         * Releases the shader slot of the light type (called once by Light::destroy, on the update thread).
+         */
+        virtual void release_slot() = 0;
+
+        /**
+         * Releases the shadow maps (called once by Light::release_shadow_maps, on the OpenGL thread).
+         */
+        virtual void release() = 0;
+
+        /**
+         * Takes a released frame buffer and shadow map of the light type, or creates them (must be called from the OpenGL thread).
+         *
+         * @param isStatic Is it the static casters map (only changes the tracked name)?
+         */
+        virtual void acquire_target(GLuint& fbo, GLuint& texture, bool isStatic) = 0;
+
+        #ifndef EMSCRIPTEN
+        /**
+         * Guards the released shadow maps (released on the update thread, reused on the OpenGL thread).
+         */
+        static std::mutex _released_mutex;
+        #endif
+
     private:
-        static int __count;
+        /**
+         * Is the light in Light::lights (see Light::register_light)?
+         */
+        bool __registered;
+
+        uint64_t __static_signature;
+
+        uint64_t __shadow_signature;
+
+        static LightSlots __texture_slots;
+
+        /**
+         * The destroyed lights waiting for a snapshot to release their shadow maps (never destroyed, so the snapshots released during exit can still give theirs back).
+         */
+        static std::vector<std::shared_ptr<Light>>& destroyed();
+
+        #ifndef EMSCRIPTEN
+        /**
+         * Guards Light::destroyed (given back by the snapshots released on the render thread).
+         */
+        static std::mutex __destroyed_mutex;
+        #endif
+
+        /**
+         * The read and draw frame buffers of Light::copy_static_map (created on first use).
+         */
+        static GLuint __copy_fbos[2];
 };
\ No newline at end of file
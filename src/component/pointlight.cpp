@@ -1,29 +1,71 @@
 #include "pointlight.hpp"
+#include "renderer.hpp"
+#include "../core/shadow_array.hpp"
+
+#include <cmath>
 
 /**
  * STATICS
  */
 
-int Pointlight::__count = 0;
+LightSlots Pointlight::__slots("u_pointlights");
+std::vector<std::pair<GLuint, GLuint>> Pointlight::__released_targets;
+std::shared_ptr<ShadowArray> Pointlight::shadow_array;
 
 Pointlight::Pointlight(GLuint shader_program, glm::vec3 color, float intensity) : 
-    Light(shader_program, color, intensity)
+    Light(shader_program, color, intensity),
+    __index(-1)
 {
     this->_name = "Pointlight";
+    this->_texture_target = GL_TEXTURE_CUBE_MAP;
 }
 
 Pointlight::Pointlight(const Pointlight& light) : 
-    Light(light)
+    Light(light),
+    __index(-1)
 {}
 
 Pointlight* Pointlight::clone_implementation() {
     return new Pointlight(*this);
 }
 
+bool Pointlight::has_texture_unit() {
+    return Pointlight::shadow_array == nullptr;
+}
+
+void Pointlight::acquire_slot() {
+    this->__index = Pointlight::__slots.acquire();
+}
+
+void Pointlight::release_slot() {
+    Pointlight::__slots.release(this->__index);
+}
+
+void Pointlight::release() {
+    if(!this->_is_init) return;
+
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(Light::_released_mutex);
+    #endif
+
+    // The shadow maps stay allocated (still counted, under the released name) until another light takes them.
+    if(!this->_shared_target) {
+        MemoryTracker::track(MemoryKind::SHADOW_MAP, this->_texture, "Released pointlight", 6ull * Light::SHADOW_SIZE * Light::SHADOW_SIZE * 4);
+
+        Pointlight::__released_targets.push_back({ this->_fbo, this->_texture });
+    }
+
+    if(this->_static_fbo != 0) {
+        MemoryTracker::track(MemoryKind::SHADOW_MAP, this->_static_texture, "Released pointlight", 6ull * Light::SHADOW_SIZE * Light::SHADOW_SIZE * 4);
+
+        Pointlight::__released_targets.push_back({ this->_static_fbo, this->_static_texture });
+    }
+}
+
 std::shared_ptr<Pointlight> Pointlight::make_point_light(GLuint shader_program, glm::vec3 color, float intensity) {
     std::shared_ptr<Pointlight> light(new Pointlight(shader_program, color, intensity));
 
-    Light::lights.push_back(light);
+    Light::register_light(light);
 
     return light;
 }
@@ -37,10 +79,45 @@ void Pointlight::delayed_init() {
     
     this->_is_init = true;
 
-    glGenFramebuffers(1, &this->_fbo);
+    // Renders directly into its cube map of the array (the layered array frame buffer, offset by u_shadow_layer).
+    if(Pointlight::shadow_array) {
+        this->_array = Pointlight::shadow_array;
+        this->_array->reserve(this->__index + 1);
+
+        this->_fbo = this->_array->fbo(this->__index);
+        this->_shared_target = true;
+
+        return;
+    }
+
+    this->acquire_target(this->_fbo, this->_texture, false);
+}
+
+void Pointlight::acquire_target(GLuint& fbo, GLuint& texture, bool isStatic) {
+    auto name = this->_name + " " + std::to_string(this->__index) + (isStatic ? " static" : "");
 
-    glGenTextures(1, &this->_texture);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, this->_texture);
+    #ifndef EMSCRIPTEN
+    std::unique_lock<std::mutex> lock(Light::_released_mutex);
+    #endif
+
+    if(!Pointlight::__released_targets.empty()) {
+        std::tie(fbo, texture) = Pointlight::__released_targets.back();
+
+        Pointlight::__released_targets.pop_back();
+
+        MemoryTracker::track(MemoryKind::SHADOW_MAP, texture, name, 6ull * Light::SHADOW_SIZE * Light::SHADOW_SIZE * 4);
+
+        return;
+    }
+
+    #ifndef EMSCRIPTEN
+    lock.unlock();
+    #endif
+
+    glGenFramebuffers(1, &fbo);
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
 
     for(int i = 0; i < 6; i++) {
         #ifdef EMSCRIPTEN
@@ -48,8 +125,8 @@ void Pointlight::delayed_init() {
             GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 
             0, 
             GL_DEPTH_COMPONENT24, 
-            1024,
-            1024,
+            Light::SHADOW_SIZE,
+            Light::SHADOW_SIZE,
             0,
             GL_DEPTH_COMPONENT,
             GL_UNSIGNED_INT,
@@ -60,8 +137,8 @@ void Pointlight::delayed_init() {
             GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 
             0, 
             GL_DEPTH_COMPONENT32, 
-            1024,
-            1024,
+            Light::SHADOW_SIZE,
+            Light::SHADOW_SIZE,
             0,
             GL_DEPTH_COMPONENT,
             GL_FLOAT,
@@ -76,129 +153,155 @@ void Pointlight::delayed_init() {
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);  
 
-    glBindFramebuffer(GL_FRAMEBUFFER, this->_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
 
     #ifdef EMSCRIPTEN
     for(int i = 0; i < 6; i++) {
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, this->_texture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, texture, 0);
     }
     #else
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, this->_texture, 0);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0);
     #endif
     
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    MemoryTracker::track(MemoryKind::SHADOW_MAP, texture, name, 6ull * Light::SHADOW_SIZE * Light::SHADOW_SIZE * 4);
 }
 
-void Pointlight::init_fbo() {
-    this->delayed_init();
+void Pointlight::record_fbo(CommandBuffer& commands, const LightState& state, GLuint fbo, bool clear) {
+    bool layered = this->_array && fbo == this->_fbo;
+
+    commands.viewport(0, 0, this->shadow_size(), this->shadow_size());
 
-    glViewport(0, 0, 1024, 1024);
-    glBindFramebuffer(GL_FRAMEBUFFER, this->_fbo);
-    glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+    // The whole array is attached, so only the faces of the light cube map are cleared.
+    if(layered && clear) {
+        for(int i = 0; i < 6; i++) {
+            commands.bind_framebuffer(this->_array->face_fbo(state.slot, i));
+            commands.clear(GL_DEPTH_BUFFER_BIT);
+        }
+    }
 
-    glUseProgram(this->_shader_program);
+    commands.bind_framebuffer(fbo);
 
-    auto light_position = this->_transform->position;
+    if(!layered && clear) commands.clear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 
-    glUniform3fv(
-        glGetUniformLocation(this->_shader_program, "u_light_pos"),
-        1,
-        glm::value_ptr(light_position)
-    );
+    commands.use_program(this->_shader_program);
 
-    glUniform1f(
-        glGetUniformLocation(this->_shader_program, "u_far"),
-        this->_far
-    );
+    commands.uniform("u_shadow_layer", (GLint) (layered ? state.slot * 6 : 0));
 
-    auto shadow_projection = this->projection();
+    auto light_position = state.position;
 
-    std::vector<glm::mat4> shadowTransforms;
-    
-    shadowTransforms.push_back(shadow_projection * 
-                    glm::lookAt(light_position, light_position + glm::vec3(1.0, 0.0, 0.0), glm::vec3(0.0,-1.0, 0.0)));
-    shadowTransforms.push_back(shadow_projection * 
-                    glm::lookAt(light_position, light_position + glm::vec3(-1.0, 0.0, 0.0), glm::vec3(0.0,-1.0, 0.0)));
-    shadowTransforms.push_back(shadow_projection * 
-                    glm::lookAt(light_position, light_position + glm::vec3(0.0, 1.0, 0.0), glm::vec3(0.0, 0.0, 1.0)));
-    shadowTransforms.push_back(shadow_projection * 
-                    glm::lookAt(light_position, light_position + glm::vec3(0.0,-1.0, 0.0), glm::vec3(0.0, 0.0,-1.0)));
-    shadowTransforms.push_back(shadow_projection * 
-                    glm::lookAt(light_position, light_position + glm::vec3(0.0, 0.0, 1.0), glm::vec3(0.0,-1.0, 0.0)));
-    shadowTransforms.push_back(shadow_projection * 
-                    glm::lookAt(light_position, light_position + glm::vec3(0.0, 0.0,-1.0), glm::vec3(0.0,-1.0, 0.0)));
+    commands.uniform("u_light_pos", light_position);
+
+    commands.uniform("u_far", state.far_plane);
+
+    auto shadow_projection = Pointlight::projection(state.near_plane, state.far_plane);
+
+    glm::mat4 shadowTransforms[] = {
+        shadow_projection * 
+            glm::lookAt(light_position, light_position + glm::vec3(1.0, 0.0, 0.0), glm::vec3(0.0,-1.0, 0.0)),
+        shadow_projection * 
+            glm::lookAt(light_position, light_position + glm::vec3(-1.0, 0.0, 0.0), glm::vec3(0.0,-1.0, 0.0)),
+        shadow_projection * 
+            glm::lookAt(light_position, light_position + glm::vec3(0.0, 1.0, 0.0), glm::vec3(0.0, 0.0, 1.0)),
+        shadow_projection * 
+            glm::lookAt(light_position, light_position + glm::vec3(0.0,-1.0, 0.0), glm::vec3(0.0, 0.0,-1.0)),
+        shadow_projection * 
+            glm::lookAt(light_position, light_position + glm::vec3(0.0, 0.0, 1.0), glm::vec3(0.0,-1.0, 0.0)),
+        shadow_projection * 
+            glm::lookAt(light_position, light_position + glm::vec3(0.0, 0.0,-1.0), glm::vec3(0.0,-1.0, 0.0))
+    };
     
-    glUniformMatrix4fv(
-        glGetUniformLocation(this->_shader_program, "u_shadow_matrices"),
-        6,
-        GL_FALSE,
-        glm::value_ptr(shadowTransforms[0])
-    );
+    commands.uniform("u_shadow_matrices", shadowTransforms, 6);
+}
+
+GLint Pointlight::culled_faces(glm::vec3 lightPosition, glm::vec3 center, float radius) {
+    auto p = center - lightPosition;
+
+    // The faces are the 90 degree pyramids around each axis (e.g. x >= |y| and x >= |z| for +X).
+    float extent = radius * std::sqrt(2.0f);
+    GLint culled = 0;
+
+    for(int axis = 0; axis < 3; axis++) {
+        float a = p[(axis + 1) % 3];
+        float b = p[(axis + 2) % 3];
+
+        for(int sign = 0; sign < 2; sign++) {
+            float along = sign == 0 ? p[axis] : -p[axis];
+
+            bool touches = along > -radius
+                && along - a > -extent && along + a > -extent
+                && along - b > -extent && along + b > -extent;
+
+            if(!touches) culled |= 1 << (axis * 2 + sign);
+        }
+    }
+
+    return culled;
+}
+
+void Pointlight::record_caster(CommandBuffer& commands, const LightState& state, const DrawItem& item) {
+    commands.uniform("u_cull_faces", item.bounds_radius < 0.0f ? (GLint) 0 : Pointlight::culled_faces(state.position, item.bounds_center, item.bounds_radius));
+}
+
+LightState Pointlight::state(float alpha) {
+    auto state = Light::state(alpha);
+
+    state.type = LightType::POINT;
+    state.slot = this->__index;
+
+    if(Pointlight::shadow_array) {
+        state.texture_unit = Pointlight::shadow_array->texture_unit();
+    }
+
+    return state;
 }
 
 glm::mat4 Pointlight::projection() {
-    return glm::perspective(glm::radians(90.0f), 1.0f, this->_near, this->_far); 
+    return Pointlight::projection(this->_near, this->_far);
+}
+
+glm::mat4 Pointlight::projection(float near_plane, float far_plane) {
+    return glm::perspective(glm::radians(90.0f), 1.0f, near_plane, far_plane); 
 }
 
 glm::mat4 Pointlight::matrix() {
     return this->projection() * this->_transform->view_matrix();
 }
 
-void Pointlight::render(GLuint shader_program) {
+void Pointlight::record(CommandBuffer& commands, const LightState& state, GLuint shader_program) {
     std::stringstream ss;
 
     ss << "u_pointlights[" << this->__index << "]";
 
     auto struct_prefix = ss.str();
 
-    glUniform1i(
-        glGetUniformLocation(shader_program, (struct_prefix + ".is_active").c_str()),
-        this->_is_active
-    );
-
-    if(!this->_is_active) return;
+    commands.uniform(struct_prefix + ".is_active", (GLint) state.is_active);
 
-    glActiveTexture(GL_TEXTURE2 + this->_texture_index);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, this->_texture);
+    if(!state.is_active) return;
 
-    std::stringstream shadow_texture;
+    commands.bind_texture(state.texture_unit, this->shadow_target(), this->shadow_texture());
 
-    shadow_texture << "u_point_shadows[" << this->__index << "]";
+    if(this->_array) {
+        // The array is indexed by the slot in the shader, so every point light binds the same texture (skipped by the bind cache).
+        commands.uniform("u_point_shadow_array", state.texture_unit);
+    } else {
+        std::stringstream shadow_texture;
 
-    glUniform1i(
-        glGetUniformLocation(shader_program, shadow_texture.str().c_str()), 
-        2 + this->_texture_index
-    );
+        shadow_texture << "u_point_shadows[" << this->__index << "]";
 
-    auto light_position = this->_transform->position;
-    auto light_direction = -this->_transform->forward();
+        commands.uniform(shadow_texture.str(), state.texture_unit);
+    }
 
-    glUniform3fv(
-        glGetUniformLocation(shader_program, (struct_prefix + ".position").c_str()),
-        1,
-        glm::value_ptr(light_position)
-    );
+    commands.uniform(struct_prefix + ".position", state.position);
 
-    glUniform1f(
-        glGetUniformLocation(shader_program, (struct_prefix + ".range").c_str()),
-        this->_far
-    );
+    commands.uniform(struct_prefix + ".range", state.far_plane);
 
-    glUniform3fv(
-        glGetUniformLocation(shader_program, (struct_prefix + ".color").c_str()),
-        1,
-        glm::value_ptr(this->_color)
-    );
+    commands.uniform(struct_prefix + ".color", state.color);
 
-    glUniform1f(
-        glGetUniformLocation(shader_program, (struct_prefix + ".intensity").c_str()),
-        this->_intensity
-    );
+    commands.uniform(struct_prefix + ".intensity", state.intensity);
 
-    glUniform1f(
-        glGetUniformLocation(shader_program, (struct_prefix + ".shadows").c_str()),
-        this->_shadows
-    );
+    commands.uniform(struct_prefix + ".shadows", (GLfloat) state.shadows);
 }
 
 #ifdef IMGUI
@@ -6,13 +6,43 @@ class Pointlight : public Light {
     public:
         static std::shared_ptr<Pointlight> make_point_light(GLuint shader_program, glm::vec3 color, float intensity);
 
+        /**
+         * The shadow array of the point lights (nullptr gives every point light its own cube map, see pepng::set_shadow_arrays).
+         *
+         * Must be set before the point lights are initialized.
+         */
+        static std::shared_ptr<ShadowArray> shadow_array;
+
         virtual void delayed_init() override;
-        virtual void init_fbo() override;
-        virtual void render(GLuint shader_program) override;
+        virtual LightState state(float alpha = 1.0f) override;
+        using Light::record_fbo;
+
+        /**
+         * Records the shadow pass of the state, with u_shadow_layer the first layer of the light in the shadow array (0 without array).
+         */
+        virtual void record_fbo(CommandBuffer& commands, const LightState& state, GLuint fbo, bool clear) override;
+        virtual void record(CommandBuffer& commands, const LightState& state, GLuint shader_program) override;
+
+        /**
+         * Records u_cull_faces, the cube faces that the draw bounds do not touch (see Pointlight::culled_faces).
+         */
+        virtual void record_caster(CommandBuffer& commands, const LightState& state, const DrawItem& item) override;
 
         glm::mat4 matrix();
         glm::mat4 projection();
 
+        /**
+         * The cube face projection for near/far planes.
+         */
+        static glm::mat4 projection(float near_plane, float far_plane);
+
+        /**
+         * The cube faces that a bounding sphere does not touch (bit i for the face GL_TEXTURE_CUBE_MAP_POSITIVE_X + i).
+         *
+         * The shadow geometry shader skips these layers, so a caster is only rasterized into the faces that can see it.
+         */
+        static GLint culled_faces(glm::vec3 lightPosition, glm::vec3 center, float radius);
+
         #ifdef IMGUI
         virtual void imgui() override;
         #endif
@@ -20,12 +50,28 @@ class Pointlight : public Light {
     protected:
         virtual Pointlight* clone_implementation() override;
 
+        virtual bool has_texture_unit() override;
+
+        virtual void acquire_slot() override;
+
+        virtual void release_slot() override;
+
+        virtual void release() override;
+
+        virtual void acquire_target(GLuint& fbo, GLuint& texture, bool isStatic) override;
+
         Pointlight(GLuint shader_program, glm::vec3 color, float intensity);
         Pointlight(const Pointlight& light);
 
     private:
         int __index;
-        static int __count;
+
+        static LightSlots __slots;
+
+        /**
+         * The frame buffers and shadow maps of the destroyed lights (reused by Pointlight::acquire_target).
+         */
+        static std::vector<std::pair<GLuint, GLuint>> __released_targets;
 };
 
 namespace pepng {
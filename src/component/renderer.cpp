@@ -4,25 +4,92 @@
 #include "transform.hpp"
 #include "../object/camera.hpp"
 
+#include <cmath>
+
+namespace {
+    /**
+     * The uniform names of the light list entries (e.g. u_point_list[3]), built once.
+     */
+    std::array<std::string, MAX_DRAW_LIGHTS> indexed_names(const char* name) {
+        std::array<std::string, MAX_DRAW_LIGHTS> names;
+
+        for(int i = 0; i < MAX_DRAW_LIGHTS; i++) {
+            std::stringstream ss;
+
+            ss << name << "[" << i << "]";
+
+            names.at(i) = ss.str();
+        }
+
+        return names;
+    }
+
+    const auto POINT_LIST = indexed_names("u_point_list");
+    const auto POINT_LIST_SHADOWS = indexed_names("u_point_list_shadows");
+    const auto SPOT_LIST = indexed_names("u_spot_list");
+    const auto SPOT_LIST_SHADOWS = indexed_names("u_spot_list_shadows");
+
+    /**
+     * Inserts the light by decreasing score (the weakest light is dropped when the list is full).
+     */
+    void insert_light(std::array<DrawLight, MAX_DRAW_LIGHTS>& lights, std::array<float, MAX_DRAW_LIGHTS>& scores, int& count, const DrawLight& light, float score) {
+        if(count == MAX_DRAW_LIGHTS && score <= scores.at(count - 1)) return;
+
+        int i = std::min(count, MAX_DRAW_LIGHTS - 1);
+
+        for(; i > 0 && scores.at(i - 1) < score; i--) {
+            scores.at(i) = scores.at(i - 1);
+            lights.at(i) = lights.at(i - 1);
+        }
+
+        scores.at(i) = score;
+        lights.at(i) = light;
+
+        if(count < MAX_DRAW_LIGHTS) count++;
+    }
+
+    /**
+     * Is the sphere outside of the spotlight cone (see "Cull that cone", Wronski)?
+     */
+    bool outside_cone(const LightState& light, glm::vec3 center, float radius) {
+        auto direction = glm::normalize(light.direction);
+        auto toCenter = center - light.position;
+        float along = glm::dot(toCenter, direction);
+        float halfAngle = glm::radians(light.angle / 2.0f);
+        float across = std::sqrt(std::max(glm::dot(toCenter, toCenter) - along * along, 0.0f));
+
+        return std::cos(halfAngle) * across - along * std::sin(halfAngle) > radius || along < -radius;
+    }
+}
+
 Renderer::Renderer(std::shared_ptr<Model> model, std::shared_ptr<Material> material, GLenum render_mode) :
     Component("Renderer"),
     model(model),
     material(material),
     render_mode(render_mode),
     receive_shadow(true),
-    display_texture(true)
+    display_texture(true),
+    is_static(false),
+    __model_share(std::make_shared<bool>(true)),
+    __material_share(std::make_shared<bool>(true))
 {}
 
+// The model is shared (copied on write), so cloning does not depend on the mesh size.
 Renderer::Renderer(const Renderer& renderer) :
     Component(renderer),
-    model(renderer.model->clone2()),
+    model(renderer.model),
     material(renderer.material->clone()),
     render_mode(renderer.render_mode),
     receive_shadow(renderer.receive_shadow),
-    display_texture(renderer.display_texture)
+    display_texture(renderer.display_texture),
+    is_static(renderer.is_static),
+    __model_share(renderer.__model_share),
+    __material_share(std::make_shared<bool>(true))
 {}
 
 std::shared_ptr<Renderer> Renderer::make_renderer(std::shared_ptr<Model> model, std::shared_ptr<Material> material, GLenum render_mode) {
+    if(Pool::enabled()) return pepng::make_pooled<Renderer>(model, material, render_mode);
+
     std::shared_ptr<Renderer> renderer(new Renderer(model, material, render_mode));
 
     return renderer;
@@ -37,9 +104,9 @@ Renderer* Renderer::clone_implementation() {
 }
 
 void Renderer::init(std::shared_ptr<WithComponents> parent) {
-    this->__transform = parent->get_component<Transform>();
+    this->__transform = parent->get_handle<Transform>();
 
-    if (this->__transform == nullptr) {
+    if (this->__transform.is_null()) {
         std::stringstream ss;
 
         ss << *parent << " has no transform." << std::endl;
@@ -50,71 +117,178 @@ void Renderer::init(std::shared_ptr<WithComponents> parent) {
     }
 }
 
-void Renderer::render(std::shared_ptr<WithComponents> parent, GLuint shaderProgram) {
-    if(!this->model->is_init()) this->model->delayed_init();
+std::shared_ptr<Model> Renderer::unique_model() {
+    if(this->__model_share.use_count() > 1) {
+        this->model = this->model->clone2();
+        this->__model_share = std::make_shared<bool>(true);
+    }
 
-    if(this->model->vao() == -1 || !this->active()) return;
+    return this->model;
+}
 
-    glUseProgram(shaderProgram);
-    
-    glActiveTexture(GL_TEXTURE1);
+std::shared_ptr<Material> Renderer::unique_material() {
+    if(this->__material_share.use_count() > 1) {
+        this->material = this->material->clone();
+        this->__material_share = std::make_shared<bool>(true);
+    }
+
+    return this->material;
+}
+
+std::shared_ptr<Renderer> Renderer::instance() {
+    // Not a copy, which would clone the material.
+    auto renderer = Renderer::make_renderer(this->model, this->material, this->render_mode);
+
+    renderer->_name = this->_name;
+    renderer->_is_active = this->_is_active;
+    renderer->receive_shadow = this->receive_shadow;
+    renderer->display_texture = this->display_texture;
+    renderer->is_static = this->is_static;
+    renderer->__model_share = this->__model_share;
+    renderer->__material_share = this->__material_share;
+
+    return renderer;
+}
+
+glm::mat4 Renderer::world_matrix(float alpha) {
+    auto transform = this->__transform.get();
+
+    return transform->interpolated_parent_matrix(alpha)
+        * glm::translate(glm::mat4(1.0f), this->model->offset())
+        * transform->world_matrix(alpha)
+        * glm::translate(glm::mat4(1.0f), -this->model->offset());
+}
+
+DrawItem Renderer::draw_item(float alpha) {
+    DrawItem item;
+
+    item.model = this->model;
+    item.texture = this->material->texture;
+    item.shader_program = this->material->shader_program();
+    item.render_mode = this->render_mode;
+    item.world_matrix = this->world_matrix(alpha);
+    item.receive_shadow = this->receive_shadow;
+    item.display_texture = this->display_texture;
+    item.transparent = this->material->transparent();
+    item.is_static = this->is_static;
+    item.bounds_center = glm::vec3(item.world_matrix[3]);
+    item.bounds_radius = -1.0f;
+    item.point_light_count = 0;
+    item.spotlight_count = 0;
+
+    if(this->model->has_bounds()) {
+        auto center = (this->model->bounds_min() + this->model->bounds_max()) / 2.0f;
+        auto extent = (this->model->bounds_max() - this->model->bounds_min()) / 2.0f;
+
+        float scale = std::max({
+            glm::length(glm::vec3(item.world_matrix[0])),
+            glm::length(glm::vec3(item.world_matrix[1])),
+            glm::length(glm::vec3(item.world_matrix[2]))
+        });
+
+        item.bounds_center = glm::vec3(item.world_matrix * glm::vec4(center, 1.0f));
+        item.bounds_radius = glm::length(extent) * scale;
+    }
+
+    return item;
+}
+
+void Renderer::assign_lights(DrawItem& item, const std::vector<LightState>& lights, bool cull) {
+    std::array<float, MAX_DRAW_LIGHTS> pointScores;
+    std::array<float, MAX_DRAW_LIGHTS> spotScores;
+
+    item.point_light_count = 0;
+    item.spotlight_count = 0;
 
-    glBindTexture(GL_TEXTURE_2D, this->material->texture->gl_index());
+    bool bounded = item.bounds_radius >= 0.0f;
 
-    glUniform1i(
-        glGetUniformLocation(shaderProgram, "u_texture"), 
-        1
-    );
+    for(auto& light : lights) {
+        if(!light.is_active || light.type == LightType::OTHER) continue;
 
-    GLuint uWorld = glGetUniformLocation(shaderProgram, "u_world");
+        // Distance from the light to the bounds (0 inside).
+        float distance = bounded ? std::max(glm::length(item.bounds_center - light.position) - item.bounds_radius, 0.0f) : 0.0f;
 
-    if (uWorld >= 0) {
-        auto worldMatrix = this->__transform->parent_matrix
-            * glm::translate(glm::mat4(1.0f), this->model->offset())
-            * this->__transform->world_matrix()
-            * glm::translate(glm::mat4(1.0f), -this->model->offset());
+        if(cull && !Renderer::in_light(item, light)) continue;
 
-        glUniformMatrix4fv(
-            uWorld,
-            1,
-            GL_FALSE,
-            glm::value_ptr(worldMatrix)
-        );
+        float score = light.intensity * std::max(1.0f - distance / light.far_plane, 0.0f);
+
+        DrawLight drawLight { light.slot, light.texture_unit };
+
+        if(light.type == LightType::POINT) {
+            insert_light(item.point_lights, pointScores, item.point_light_count, drawLight, score);
+        } else {
+            insert_light(item.spotlights, spotScores, item.spotlight_count, drawLight, score);
+        }
     }
+}
+
+bool Renderer::in_light(const DrawItem& item, const LightState& light) {
+    if(item.bounds_radius < 0.0f) return true;
+
+    if(glm::length(item.bounds_center - light.position) - item.bounds_radius > light.far_plane) return false;
+
+    return light.type != LightType::SPOT || !outside_cone(light, item.bounds_center, item.bounds_radius);
+}
+
+void Renderer::render(std::shared_ptr<WithComponents> parent, GLuint shaderProgram) {
+    this->render(parent, shaderProgram, Light::states());
+}
+
+void Renderer::render(std::shared_ptr<WithComponents> parent, GLuint shaderProgram, const std::vector<LightState>& lights) {
+    if(!this->active()) return;
+
+    auto item = this->draw_item();
 
-    GLuint uReceiveShadow = glGetUniformLocation(shaderProgram, "u_receive_shadow");
+    Renderer::assign_lights(item, lights);
 
-    if(uReceiveShadow >= 0) {
-        glUniform1f(
-            uReceiveShadow,
-            this->receive_shadow
-        );
+    Renderer::render(item, shaderProgram);
+}
+
+void Renderer::render(const DrawItem& item, GLuint shaderProgram) {
+    if(!item.model->is_init()) item.model->delayed_init();
+
+    CommandBuffer commands;
+
+    Renderer::record(commands, item, shaderProgram);
+
+    commands.replay();
+}
+
+void Renderer::record(CommandBuffer& commands, const DrawItem& item, GLuint shaderProgram) {
+    if(item.model->vao() == -1) return;
+
+    commands.use_program(shaderProgram);
+
+    commands.bind_texture(1, GL_TEXTURE_2D, item.texture->gl_index());
+
+    commands.uniform("u_texture", (GLint) 1);
+
+    commands.uniform("u_world", &item.world_matrix);
+
+    commands.uniform("u_receive_shadow", (GLfloat) item.receive_shadow);
+
+    commands.uniform("u_display_texture", (GLfloat) item.display_texture);
+
+    commands.uniform("u_point_count", (GLint) item.point_light_count);
+
+    for(int i = 0; i < item.point_light_count; i++) {
+        commands.uniform(POINT_LIST.at(i), item.point_lights.at(i).slot);
+        commands.uniform(POINT_LIST_SHADOWS.at(i), item.point_lights.at(i).texture_unit);
     }
 
-    GLuint uDisplayTexture = glGetUniformLocation(shaderProgram, "u_display_texture");
+    commands.uniform("u_spot_count", (GLint) item.spotlight_count);
 
-    if(uDisplayTexture >= 0) {
-        glUniform1f(
-            uDisplayTexture,
-            this->display_texture
-        );
+    for(int i = 0; i < item.spotlight_count; i++) {
+        commands.uniform(SPOT_LIST.at(i), item.spotlights.at(i).slot);
+        commands.uniform(SPOT_LIST_SHADOWS.at(i), item.spotlights.at(i).texture_unit);
     }
 
-    glBindVertexArray(this->model->vao());
+    commands.bind_vao(item.model->vao());
 
-    if(this->model->has_element_array()) {
-        glDrawElements(
-            this->render_mode,
-            this->model->count(),
-            GL_UNSIGNED_INT,
-            0
-        );
+    if(item.model->has_element_array()) {
+        commands.draw_elements(item.render_mode, item.model->count());
     } else {
-        glDrawArrays(
-            this->render_mode,
-            0,
-            this->model->count()
-        );
+        commands.draw_arrays(item.render_mode, 0, item.model->count());
     }
 }
 
@@ -131,11 +305,17 @@ void Renderer::render(std::shared_ptr<WithComponents> parent) {
 
     Camera::current_camera->render(shaderProgram);
 
-    for(auto light : Light::lights) {
-        light->render(shaderProgram);
+    auto lights = Light::states();
+
+    for(size_t i = 0; i < lights.size(); i++) {
+        Light::lights.at(i)->render(lights.at(i), shaderProgram);
+    }
+
+    for(auto& uniform : LightSlots::disabled_uniforms()) {
+        glUniform1i(glGetUniformLocation(shaderProgram, uniform.c_str()), 0);
     }
 
-    this->render(parent, shaderProgram);
+    this->render(parent, shaderProgram, lights);
 }
 
 #ifdef IMGUI
@@ -197,5 +377,6 @@ void Renderer::imgui() {
 
     ImGui::Checkbox("Texture", &this->display_texture);
     ImGui::Checkbox("Shadow", &this->receive_shadow);
+    ImGui::Checkbox("Static", &this->is_static);
 }
 #endif
\ No newline at end of file
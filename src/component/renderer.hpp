@@ -1,6 +1,8 @@
 #pragma once
 
 #include <memory>
+#include <array>
+#include <vector>
 
 #include <GL/glew.h>
 #include <glm/gtx/string_cast.hpp>
@@ -9,9 +11,75 @@
 #include "light.hpp"
 #include "../gl/model.hpp"
 #include "../gl/material.hpp"
+#include "../gl/command_buffer.hpp"
+#include "../util/pool.hpp"
+
+/**
+ * The maximum number of lights of each type in the light list of a draw.
+ */
+const int MAX_DRAW_LIGHTS = 8;
+
+/**
+ * A light reaching a draw (see Renderer::assign_lights).
+ */
+struct DrawLight {
+    /**
+     * The index in the shader array (u_pointlights or u_spotlights).
+     */
+    GLint slot;
+    /**
+     * The texture unit of the shadow map.
+     */
+    GLint texture_unit;
+};
+
+/**
+ * Copy of the Renderer values used when rendering (see RenderSnapshot).
+ */
+struct DrawItem {
+    std::shared_ptr<Model> model;
+    std::shared_ptr<Texture> texture;
+    /**
+     * The material shader program (used for the camera passes).
+     */
+    GLuint shader_program;
+    GLenum render_mode;
+    glm::mat4 world_matrix;
+    bool receive_shadow;
+    bool display_texture;
+    /**
+     * Is the material transparent (see Material::set_transparent)?
+     */
+    bool transparent;
+    /**
+     * Is the renderer static (its shadow is cached, see Renderer::is_static)?
+     */
+    bool is_static;
+    /**
+     * The world bounding sphere center.
+     */
+    glm::vec3 bounds_center;
+    /**
+     * The world bounding sphere radius (negative if the model has no bounds).
+     */
+    float bounds_radius;
+    /**
+     * The point lights reaching the bounds (strongest first).
+     */
+    std::array<DrawLight, MAX_DRAW_LIGHTS> point_lights;
+    int point_light_count;
+    /**
+     * The spotlights reaching the bounds (strongest first).
+     */
+    std::array<DrawLight, MAX_DRAW_LIGHTS> spotlights;
+    int spotlight_count;
+};
 
 /**
  * The Rendering component for objects.
+ *
+ * Cloning a renderer (or its object) shares the model instead of copying its geometry: changing the model of a clone
+ * changes every renderer sharing it. Call Renderer::unique_model first to modify the model of a single clone.
  */
 class Renderer : public Component {
     public:
@@ -20,11 +88,13 @@ class Renderer : public Component {
          */
         GLenum render_mode;
         /**
-         * Pointer to the model.
+         * Pointer to the model (shared with the clones of this renderer, see Renderer::unique_model).
+         *
+         * Not copied on write by itself: modifying it through a clone modifies every sharer.
          */
         std::shared_ptr<Model> model;
         /**
-         * Pointer to the material.
+         * Pointer to the material (shared with prefab instances, see Renderer::unique_material).
          */
         std::shared_ptr<Material> material;
         /**
@@ -35,6 +105,10 @@ class Renderer : public Component {
          * Does model display texture?
          */
         bool display_texture;
+        /**
+         * Does the model never move (its shadow is cached by the lights until it moves, see Light::static_signature)?
+         */
+        bool is_static;
 
         /**
          * Shared_ptr constructor for Renderer.
@@ -42,9 +116,79 @@ class Renderer : public Component {
         static std::shared_ptr<Renderer> make_renderer(std::shared_ptr<Model> model, std::shared_ptr<Material> material, GLenum render_mode);
 
         void render(std::shared_ptr<WithComponents> object, GLuint shaderProgram);
+
+        /**
+         * Draws the renderer with the light states of the pass (see Light::states, built once instead of per draw).
+         */
+        void render(std::shared_ptr<WithComponents> object, GLuint shaderProgram, const std::vector<LightState>& lights);
+
+        /**
+         * Copy-on-write accessor for the model (clones it first if other renderers share it).
+         *
+         * Use it before modifying the geometry of a cloned renderer.
+         * When pipelined, the clone waits for the render thread if it is initializing the shared model.
+         */
+        std::shared_ptr<Model> unique_model();
+
+        /**
+         * Copy-on-write accessor for the material (clones it first if other renderers share it).
+         */
+        std::shared_ptr<Material> unique_material();
+
+        /**
+         * Creates a renderer that shares the model and the material (used by the prefab instances).
+         */
+        std::shared_ptr<Renderer> instance();
+
+        /**
+         * The world matrix of the model (parent, transform and model offset).
+         * 
+         * @param alpha The transform interpolation factor (see Transform::world_matrix).
+         */
+        glm::mat4 world_matrix(float alpha = 1.0f);
+
+        /**
+         * Copies the current renderer values.
+         * 
+         * @param alpha The transform interpolation factor.
+         */
+        virtual DrawItem draw_item(float alpha = 1.0f);
+
+        /**
+         * Fills the light lists of the draw with the active lights whose range reaches its bounds.
+         * 
+         * When more than MAX_DRAW_LIGHTS lights of a type reach it, the strongest (intensity and distance) are kept.
+         * 
+         * @param cull Are lights outside of their range kept out of the lists (false ranks every active light, still capped at MAX_DRAW_LIGHTS per type)?
+         */
+        static void assign_lights(DrawItem& item, const std::vector<LightState>& lights, bool cull = true);
+
+        /**
+         * Does the light reach the bounds (its range, and its cone for spotlights)? Draws without bounds are always reached.
+         */
+        static bool in_light(const DrawItem& item, const LightState& light);
+
+        /**
+         * Draws a copied renderer with the shader program.
+         */
+        static void render(const DrawItem& item, GLuint shaderProgram);
+
+        /**
+         * Records the draw of a copied renderer with the shader program.
+         *
+         * The model and texture must be initialized (see RenderSnapshot::prepare).
+         * The light lists are recorded as u_point_count, u_point_list[i] (the u_pointlights index) and
+         * u_point_list_shadows[i] (the shadow map unit), and the same with u_spot (shaders without them ignore the lists).
+         */
+        static void record(CommandBuffer& commands, const DrawItem& item, GLuint shaderProgram);
+
         virtual void init(std::shared_ptr<WithComponents> object) override;
         virtual void render(std::shared_ptr<WithComponents> object) override;
+        virtual bool parallel_safe() override { return true; }
 
+        /**
+         * Copies the renderer with a shared model and a cloned material (see Renderer::unique_model before modifying the model).
+         */
         virtual Renderer* clone_implementation() override;
 
         #ifdef IMGUI
@@ -52,11 +196,26 @@ class Renderer : public Component {
         #endif
     
     protected:
+        friend class PoolAllocator<Renderer>;
+
         Renderer(std::shared_ptr<Model> model, std::shared_ptr<Material> material, GLenum render_mode);
         Renderer(const Renderer& renderer);
 
     private:
-        std::shared_ptr<Transform> __transform;
+        /**
+         * The parent transform (not owned, the parent owns the renderer).
+         */
+        Handle<Transform> __transform;
+
+        /**
+         * Shared by the renderers sharing the model (its use count is the number of sharers).
+         */
+        std::shared_ptr<bool> __model_share;
+
+        /**
+         * Shared by the renderers sharing the material.
+         */
+        std::shared_ptr<bool> __material_share;
 };
 
 namespace pepng {
@@ -3,10 +3,16 @@
  */
 #include "spotlight.hpp"
 
+#include "../core/atlas.hpp"
+#include "../core/shadow_array.hpp"
+
 /**
  * STATICS
  */
-int Spotlight::__count = 0;
+LightSlots Spotlight::__slots("u_spotlights");
+std::vector<std::pair<GLuint, GLuint>> Spotlight::__released_targets;
+std::shared_ptr<ShadowAtlas> Spotlight::atlas;
+std::shared_ptr<ShadowArray> Spotlight::shadow_array;
 
 /**
  * CONSTRUCTORS
@@ -17,7 +23,7 @@ int Spotlight::__count = 0;
 Spotlight::Spotlight(GLuint shader_program, float angle, glm::vec3 color, float intensity) :
     Light(shader_program, color, intensity),
     __angle(angle),
-    __index(__count++)
+    __index(-1)
 {
     this->_name = "Spotlight";
 }
@@ -25,7 +31,7 @@ Spotlight::Spotlight(GLuint shader_program, float angle, glm::vec3 color, float
 Spotlight::Spotlight(const Spotlight& spotlight) : 
     Light(spotlight),
     __angle(spotlight.__angle),
-    __index(__count++)
+    __index(-1)
 {}
 
 /**
@@ -39,10 +45,43 @@ Spotlight* Spotlight::clone_implementation() {
     return new Spotlight(*this);
 }
 
+bool Spotlight::has_texture_unit() {
+    return Spotlight::atlas == nullptr && Spotlight::shadow_array == nullptr;
+}
+
+void Spotlight::acquire_slot() {
+    this->__index = Spotlight::__slots.acquire();
+}
+
+void Spotlight::release_slot() {
+    Spotlight::__slots.release(this->__index);
+}
+
+void Spotlight::release() {
+    if(!this->_is_init) return;
+
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(Light::_released_mutex);
+    #endif
+
+    // The shadow maps stay allocated (still counted, under the released name) until another light takes them.
+    if(!this->_shared_target) {
+        MemoryTracker::track(MemoryKind::SHADOW_MAP, this->_texture, "Released spotlight", (size_t) Light::SHADOW_SIZE * Light::SHADOW_SIZE * 4);
+
+        Spotlight::__released_targets.push_back({ this->_fbo, this->_texture });
+    }
+
+    if(this->_static_fbo != 0) {
+        MemoryTracker::track(MemoryKind::SHADOW_MAP, this->_static_texture, "Released spotlight", (size_t) Light::SHADOW_SIZE * Light::SHADOW_SIZE * 4);
+
+        Spotlight::__released_targets.push_back({ this->_static_fbo, this->_static_texture });
+    }
+}
+
 std::shared_ptr<Spotlight> Spotlight::make_spotlight(GLuint shader_program, float angle, glm::vec3 color, float intensity) {
     std::shared_ptr<Spotlight> instance(new Spotlight(shader_program, angle, color, intensity));
 
-    Light::lights.push_back(instance);
+    Light::register_light(instance);
 
     return instance;
 }
@@ -56,13 +95,41 @@ std::shared_ptr<Spotlight> pepng::make_spotlight(GLuint shader_program, float an
  */
 
 glm::mat4 Spotlight::matrix() {
+    return this->matrix(1.0f);
+}
+
+glm::mat4 Spotlight::matrix(float alpha) {
+    auto transform = this->_transform.get();
+    auto position = transform->interpolated_position(alpha);
+
     return glm::perspective(
         glm::radians(this->__angle), 
         1.0f, 
         0.1f, 
         this->_far
     ) 
-    * glm::lookAt(this->_transform->position, this->_transform->position - this->_transform->forward(), glm::vec3(0.0f, 1.0f, 0.0f));
+    * glm::lookAt(position, position - transform->interpolated_forward(alpha), glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+LightState Spotlight::state(float alpha) {
+    auto state = Light::state(alpha);
+
+    state.type = LightType::SPOT;
+    state.slot = this->__index;
+    state.angle = this->__angle;
+
+    if(this->_transform) {
+        state.matrix = this->matrix(alpha);
+        state.shadow_matrix = state.matrix;
+    }
+
+    if(Spotlight::atlas) {
+        state.texture_unit = Spotlight::atlas->texture_unit();
+    } else if(Spotlight::shadow_array) {
+        state.texture_unit = Spotlight::shadow_array->texture_unit();
+    }
+
+    return state;
 }
 
 void Spotlight::delayed_init() {
@@ -70,18 +137,63 @@ void Spotlight::delayed_init() {
     
     this->_is_init = true;
 
-    glGenFramebuffers(1, &this->_fbo);
+    if(Spotlight::atlas) {
+        Spotlight::atlas->init();
+
+        this->_fbo = Spotlight::atlas->fbo();
+        this->_texture = Spotlight::atlas->texture();
+        this->_shared_target = true;
+
+        return;
+    }
+
+    // Renders directly into its layer of the array.
+    if(Spotlight::shadow_array) {
+        this->_array = Spotlight::shadow_array;
+        this->_array->reserve(this->__index + 1);
+
+        this->_fbo = this->_array->fbo(this->__index);
+        this->_shared_target = true;
+
+        return;
+    }
 
-    glGenTextures(1, &this->_texture);
-    glBindTexture(GL_TEXTURE_2D, this->_texture);
+    this->acquire_target(this->_fbo, this->_texture, false);
+}
+
+void Spotlight::acquire_target(GLuint& fbo, GLuint& texture, bool isStatic) {
+    auto name = this->_name + " " + std::to_string(this->__index) + (isStatic ? " static" : "");
+
+    #ifndef EMSCRIPTEN
+    std::unique_lock<std::mutex> lock(Light::_released_mutex);
+    #endif
+
+    if(!Spotlight::__released_targets.empty()) {
+        std::tie(fbo, texture) = Spotlight::__released_targets.back();
+
+        Spotlight::__released_targets.pop_back();
+
+        MemoryTracker::track(MemoryKind::SHADOW_MAP, texture, name, (size_t) Light::SHADOW_SIZE * Light::SHADOW_SIZE * 4);
+
+        return;
+    }
+
+    #ifndef EMSCRIPTEN
+    lock.unlock();
+    #endif
+
+    glGenFramebuffers(1, &fbo);
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
 
     #ifdef EMSCRIPTEN
     glTexImage2D(
         GL_TEXTURE_2D, 
         0, 
         GL_DEPTH_COMPONENT24, 
-        1024,
-        1024,
+        Light::SHADOW_SIZE,
+        Light::SHADOW_SIZE,
         0,
         GL_DEPTH_COMPONENT,
         GL_UNSIGNED_INT,
@@ -92,8 +204,8 @@ void Spotlight::delayed_init() {
         GL_TEXTURE_2D, 
         0, 
         GL_DEPTH_COMPONENT32, 
-        1024,
-        1024,
+        Light::SHADOW_SIZE,
+        Light::SHADOW_SIZE,
         0,
         GL_DEPTH_COMPONENT,
         GL_FLOAT,
@@ -106,117 +218,85 @@ void Spotlight::delayed_init() {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, this->_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
     #ifdef EMSCRIPTEN
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, this->_texture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
     #else
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, this->_texture, 0);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0);
     #endif
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    MemoryTracker::track(MemoryKind::SHADOW_MAP, texture, name, (size_t) Light::SHADOW_SIZE * Light::SHADOW_SIZE * 4);
 }
 
-void Spotlight::init_fbo() {
-    this->delayed_init();
+void Spotlight::record_fbo(CommandBuffer& commands, const LightState& state, GLuint fbo, bool clear) {
+    commands.bind_framebuffer(fbo);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, this->_fbo);
+    auto tile = state.atlas_tile;
 
-    glViewport(0, 0, 1024, 1024);
-    glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+    if(tile.z > 0) {
+        commands.viewport(tile.x, tile.y, tile.z, tile.z);
 
-    glUseProgram(this->_shader_program);
+        // The clear is limited to the tile (the other lights keep their shadow maps).
+        if(clear) {
+            commands.scissor(tile.x, tile.y, tile.z, tile.z);
+            commands.clear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+            commands.scissor(0, 0, 0, 0);
+        }
+    } else {
+        commands.viewport(0, 0, this->shadow_size(), this->shadow_size());
 
-    auto matrix_location = glGetUniformLocation(this->_shader_program, "u_matrix");
+        if(clear) commands.clear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+    }
 
-    glUniformMatrix4fv(
-        matrix_location,
-        1,
-        GL_FALSE,
-        glm::value_ptr(this->matrix())
-    );
+    commands.use_program(this->_shader_program);
 
-    auto far_location = glGetUniformLocation(this->_shader_program, "u_far");
+    commands.uniform("u_matrix", &state.matrix);
 
-    glUniform1f(
-        far_location,
-        this->_far
-    );
+    commands.uniform("u_far", state.far_plane);
 }
 
-void Spotlight::render(GLuint shader_program) {
+void Spotlight::record(CommandBuffer& commands, const LightState& state, GLuint shader_program) {
     std::stringstream ss;
 
     ss << "u_spotlights[" << this->__index << "]";
 
     auto struct_prefix = ss.str();
 
-    glUniform1i(
-        glGetUniformLocation(shader_program, (struct_prefix + ".is_active").c_str()),
-        this->_is_active
-    );
-
-    if(!this->_is_active) return;
-
-    std::stringstream shadow_texture;
+    commands.uniform(struct_prefix + ".is_active", (GLint) state.is_active);
 
-    shadow_texture << "u_spot_shadows[" << this->__index << "]";
+    if(!state.is_active) return;
 
-    glActiveTexture(GL_TEXTURE1 + this->_texture_index);
-    glBindTexture(GL_TEXTURE_2D, this->_texture);
+    // Same units as the pointlights (unit 1 is the material texture), or the atlas or array unit shared by every spotlight.
+    commands.bind_texture(state.texture_unit, this->shadow_target(), this->shadow_texture());
 
-    auto shadow_texture_location = glGetUniformLocation(shader_program, shadow_texture.str().c_str());
+    if(this->_array) {
+        // The array is indexed by the slot in the shader, so every spotlight binds the same texture (skipped by the bind cache).
+        commands.uniform("u_spot_shadow_array", state.texture_unit);
+    } else {
+        std::stringstream shadow_texture;
 
-    glUniform1i(shadow_texture_location, 1 + this->_texture_index);
+        shadow_texture << "u_spot_shadows[" << this->__index << "]";
 
-    auto light_position = this->_transform->position;
-    auto light_direction = -this->_transform->forward();
+        commands.uniform(shadow_texture.str(), state.texture_unit);
+    }
 
-    glUniform3fv(
-        glGetUniformLocation(shader_program, (struct_prefix + ".position").c_str()),
-        1,
-        glm::value_ptr(light_position)
-    );
-
-    glUniform3fv(
-        glGetUniformLocation(shader_program, (struct_prefix + ".direction").c_str()),
-        1,
-        glm::value_ptr(light_direction)
-    );
+    commands.uniform(struct_prefix + ".position", state.position);
 
-    glUniform1f(
-        glGetUniformLocation(shader_program, (struct_prefix + ".range").c_str()),
-        this->_far
-    );
+    commands.uniform(struct_prefix + ".direction", state.direction);
 
-    glUniform3fv(
-        glGetUniformLocation(shader_program, (struct_prefix + ".color").c_str()),
-        1,
-        glm::value_ptr(this->_color)
-    );
+    commands.uniform(struct_prefix + ".range", state.far_plane);
 
-    glUniform1f(
-        glGetUniformLocation(shader_program, (struct_prefix + ".angle").c_str()),
-        glm::radians(this->__angle / 2.0f)
-    );
+    commands.uniform(struct_prefix + ".color", state.color);
 
-    glUniform1f(
-        glGetUniformLocation(shader_program, (struct_prefix + ".intensity").c_str()),
-        this->_intensity
-    );
+    commands.uniform(struct_prefix + ".angle", glm::radians(state.angle / 2.0f));
 
-    glUniform1f(
-        glGetUniformLocation(shader_program, (struct_prefix + ".shadows").c_str()),
-        this->_shadows
-    );
+    commands.uniform(struct_prefix + ".intensity", state.intensity);
 
-    auto matrix_location = glGetUniformLocation(shader_program, (struct_prefix + ".matrix").c_str());
+    commands.uniform(struct_prefix + ".shadows", (GLfloat) state.shadows);
 
-    glUniformMatrix4fv(
-        matrix_location,
-        1,
-        GL_FALSE,
-        glm::value_ptr(this->matrix())
-    );
+    commands.uniform(struct_prefix + ".matrix", &state.shadow_matrix);
 }
 
 /**
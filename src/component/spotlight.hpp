@@ -7,6 +7,8 @@
 
 #include "light.hpp"
 
+class ShadowAtlas;
+
 /**
  * Component for Spotlight.
  */
@@ -23,21 +25,43 @@ class Spotlight : public Light {
          */
         static std::shared_ptr<Spotlight> make_spotlight(GLuint shader_program, float angle, glm::vec3 color, float intensity);
 
+        /**
+         * The shadow atlas of the spotlights (nullptr gives every spotlight its own shadow map, see pepng::set_shadow_atlas).
+         *
+         * Must be set before the spotlights are initialized.
+         */
+        static std::shared_ptr<ShadowAtlas> atlas;
+
+        /**
+         * The shadow array of the spotlights (used without atlas, see pepng::set_shadow_arrays).
+         *
+         * Must be set before the spotlights are initialized.
+         */
+        static std::shared_ptr<ShadowArray> shadow_array;
+
         /**
          * LIFETIME METHODS
          */
 
         virtual void delayed_init() override;
 
-        // Attaches Light to shader program.
-        virtual void render(GLuint shader_program) override;
+        // Copies the light values (with the cone angle and matrix).
+        virtual LightState state(float alpha = 1.0f) override;
+
+        // Records the Light uniforms for the shader program.
+        virtual void record(CommandBuffer& commands, const LightState& state, GLuint shader_program) override;
 
-        // Initializes the Frame buffer.
-        virtual void init_fbo() override;
+        using Light::record_fbo;
+
+        // Records the Frame buffer initialization.
+        virtual void record_fbo(CommandBuffer& commands, const LightState& state, GLuint fbo, bool clear) override;
 
         // This light projection matrix.
         glm::mat4 matrix();
 
+        // This light projection matrix between the previous and current simulation state.
+        glm::mat4 matrix(float alpha);
+
         /**
          * IMGUI
          * 
@@ -53,6 +77,21 @@ class Spotlight : public Light {
          * We need to supply a raw clone for the shared_ptr.
          */
         virtual Spotlight* clone_implementation() override;
+
+        // Does the spotlight bind its own shadow map (not the atlas or array unit)?
+        virtual bool has_texture_unit() override;
+
+        // Acquires the shader slot.
+        virtual void acquire_slot() override;
+
+        // Releases the shader slot.
+        virtual void release_slot() override;
+
+        // Keeps the shadow map for the next Spotlight.
+        virtual void release() override;
+
+        // Takes a released frame buffer and shadow map, or creates them.
+        virtual void acquire_target(GLuint& fbo, GLuint& texture, bool isStatic) override;
     
     private:
         /**
@@ -74,7 +113,13 @@ class Spotlight : public Light {
         float __angle;
 
         int __index;
-        static int __count;
+
+        static LightSlots __slots;
+
+        /**
+         * The frame buffers and shadow maps of the destroyed lights (reused by Spotlight::acquire_target).
+         */
+        static std::vector<std::pair<GLuint, GLuint>> __released_targets;
 };
 
 // Gives access to shared_ptr constructor to the pepng namespace.
@@ -50,16 +50,21 @@ Transform::Transform(
     rotationZ(rotationZ),
     scale(scale),
     shear(shear),
-    parent_matrix(glm::mat4(1.0f))
+    parent_matrix(glm::mat4(1.0f)),
+    __has_previous(false)
 {}
 
 std::shared_ptr<Transform> Transform::make_transform(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, glm::vec3 shear) {
+    if(Pool::enabled()) return pepng::make_pooled<Transform>(position, rotation, scale, shear);
+
     std::shared_ptr<Transform> transform(new Transform(position, rotation, scale, shear));
 
     return transform;
 }
 
 std::shared_ptr<Transform> Transform::make_transform(glm::vec3 position, glm::quat rotation, glm::vec3 scale, glm::vec3 shear) {
+    if(Pool::enabled()) return pepng::make_pooled<Transform>(position, rotation, scale, shear);
+
     std::shared_ptr<Transform> transform(new Transform(position, rotation, scale, shear));
 
     return transform;
@@ -111,6 +116,72 @@ glm::highp_mat4 Transform::view_matrix() {
     return matrix;
 }
 
+void Transform::store_previous() {
+    this->__has_previous = true;
+    this->__previous_position = this->position;
+    this->__previous_rotation = this->rotation();
+    this->__previous_forward = this->forward();
+    this->__previous_scale = this->scale;
+    this->__previous_shear = this->shear;
+    this->__previous_parent_matrix = this->parent_matrix;
+}
+
+bool Transform::is_interpolated(float alpha) {
+    return this->__has_previous && alpha < 1.0f;
+}
+
+glm::vec3 Transform::interpolated_position(float alpha) {
+    if(!this->is_interpolated(alpha)) return this->position;
+
+    return glm::mix(this->__previous_position, this->position, alpha);
+}
+
+glm::quat Transform::interpolated_rotation(float alpha) {
+    if(!this->is_interpolated(alpha)) return this->rotation();
+
+    return glm::slerp(this->__previous_rotation, this->rotation(), alpha);
+}
+
+glm::vec3 Transform::interpolated_forward(float alpha) {
+    if(!this->is_interpolated(alpha)) return this->forward();
+
+    auto forward = glm::mix(this->__previous_forward, this->forward(), alpha);
+
+    return glm::length(forward) > 0.0f ? glm::normalize(forward) : this->forward();
+}
+
+glm::mat4 Transform::interpolated_parent_matrix(float alpha) {
+    if(!this->is_interpolated(alpha)) return this->parent_matrix;
+
+    // Component wise blend (close enough for the small changes of a single step).
+    return this->__previous_parent_matrix * (1.0f - alpha) + this->parent_matrix * alpha;
+}
+
+glm::highp_mat4 Transform::world_matrix(float alpha) {
+    if(!this->is_interpolated(alpha)) return this->world_matrix();
+
+    auto matrix = glm::mat4(1.0f);
+
+    matrix = glm::translate(matrix, this->interpolated_position(alpha));
+    matrix *= glm::toMat4(this->interpolated_rotation(alpha));
+    matrix = glm::scale(matrix, glm::mix(this->__previous_scale, this->scale, alpha));
+
+    auto shear = glm::mix(this->__previous_shear, this->shear, alpha);
+
+    return glm::shearX3D(matrix, shear.x, shear.z);
+}
+
+glm::highp_mat4 Transform::view_matrix(float alpha) {
+    if(!this->is_interpolated(alpha)) return this->view_matrix();
+
+    auto matrix = glm::mat4(1.0f);
+
+    matrix = glm::translate(matrix, -this->interpolated_position(alpha));
+    matrix = glm::toMat4(this->interpolated_rotation(alpha)) * matrix;
+
+    return matrix;
+}
+
 glm::vec3 Transform::right() {
     return this->rotation() * glm::vec3(-1.0f, 0.0f, 0.0f);
 }
@@ -11,6 +11,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "component.hpp"
+#include "../util/pool.hpp"
 
 /**
  * Component to store position, scale, and rotation.
@@ -48,6 +49,43 @@ class Transform : public Component {
          */
         glm::highp_mat4 view_matrix();
 
+        /**
+         * Stores the current values as the previous simulation state (called before each fixed update).
+         */
+        void store_previous();
+
+        /**
+         * Gets the position between the previous and current simulation state.
+         * 
+         * @param alpha The interpolation factor (1 is the current state).
+         */
+        glm::vec3 interpolated_position(float alpha);
+
+        /**
+         * Gets the rotation between the previous and current simulation state.
+         */
+        glm::quat interpolated_rotation(float alpha);
+
+        /**
+         * Gets the forward vector between the previous and current simulation state.
+         */
+        glm::vec3 interpolated_forward(float alpha);
+
+        /**
+         * Gets the parent matrix between the previous and current simulation state.
+         */
+        glm::mat4 interpolated_parent_matrix(float alpha);
+
+        /**
+         * Gets the world matrix between the previous and current simulation state.
+         */
+        glm::highp_mat4 world_matrix(float alpha);
+
+        /**
+         * Gets the view matrix between the previous and current simulation state.
+         */
+        glm::highp_mat4 view_matrix(float alpha);
+
         /**
          * Rotates using euler degree rotation relative to current rotation.
          * 
@@ -97,18 +135,30 @@ class Transform : public Component {
          */
         virtual glm::vec3 right();
 
+        /**
+         * Transform has no update logic, so it is always safe in the parallel update.
+         */
+        virtual bool parallel_safe() override { return true; }
+
         friend std::ostream& operator<<(std::ostream& os, const Transform& transform);
 
         #ifdef IMGUI
         virtual void imgui() override;
         #endif
     protected:
+        friend class PoolAllocator<Transform>;
+
         glm::quat rotationX;
         glm::quat rotationY;
         glm::quat rotationZ;
 
         Transform(const Transform &transform);
 
+        /**
+         * Should the interpolation use the previous state?
+         */
+        bool is_interpolated(float alpha);
+
         Transform(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, glm::vec3 shear);
 
         Transform(glm::vec3 position, glm::quat rotation, glm::vec3 scale, glm::vec3 shear);
@@ -123,6 +173,18 @@ class Transform : public Component {
         );
 
         virtual Transform* clone_implementation() override;
+
+    private:
+        /**
+         * Is there a previous simulation state?
+         */
+        bool __has_previous;
+        glm::vec3 __previous_position;
+        glm::quat __previous_rotation;
+        glm::vec3 __previous_forward;
+        glm::vec3 __previous_scale;
+        glm::vec3 __previous_shear;
+        glm::mat4 __previous_parent_matrix;
 };
 
 std::ostream& operator<<(std::ostream& os, const Transform& transform);
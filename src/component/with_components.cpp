@@ -1,12 +1,22 @@
 #include "with_components.hpp"
 
-WithComponents::WithComponents() {}
-WithComponents::WithComponents(const WithComponents& withComponents) {
+WithComponents::WithComponents() : __handle(WithComponents::slots().insert(this)) {}
+WithComponents::WithComponents(const WithComponents& withComponents) : __handle(WithComponents::slots().insert(this)) {
     for(auto component : withComponents.components) {
         this->components.push_back(component->clone());
     }
 }
 
+WithComponents::~WithComponents() {
+    WithComponents::slots().erase(this->__handle);
+}
+
+SlotMap<WithComponents>& WithComponents::slots() {
+    static auto slots = new SlotMap<WithComponents>();
+
+    return *slots;
+}
+
 std::shared_ptr<WithComponents> WithComponents::attach_component(std::shared_ptr<Component> component) {
     this->components.push_back(component);
 
@@ -17,10 +27,30 @@ std::shared_ptr<WithComponents> WithComponents::attach_component(std::shared_ptr
 
 void WithComponents::update_components() {
     for(auto component : this->get_components()) {
+        if(Component::fixed_step() && component->per_frame()) continue;
+
         component->update(shared_from_this());
     }
 }
 
+void WithComponents::update_components(bool parallelSafe) {
+    for(auto component : this->get_components()) {
+        if(Component::fixed_step() && component->per_frame()) continue;
+
+        if(component->parallel_safe() == parallelSafe) {
+            component->update(shared_from_this());
+        }
+    }
+}
+
+void WithComponents::update_frame_components() {
+    for(auto component : this->get_components()) {
+        if(component->per_frame()) {
+            component->update(shared_from_this());
+        }
+    }
+}
+
 void WithComponents::render_components() {
     for(auto component : this->get_components()) {
         component->render(shared_from_this());
@@ -18,6 +18,18 @@ class WithComponents :
     public std::enable_shared_from_this<WithComponents> 
 {
     public:
+        virtual ~WithComponents();
+
+        /**
+         * Accessor for the handle (a non owning reference, see Handle).
+         */
+        inline Handle<WithComponents> handle() const { return this->__handle; }
+
+        /**
+         * The slots of every component holder (never destroyed, see Component::slots).
+         */
+        static SlotMap<WithComponents>& slots();
+
         /**
          * Attaches a Component to this.
          */
@@ -28,6 +40,16 @@ class WithComponents :
          */
         void update_components();
 
+        /**
+         * Updates the components with matching Component::parallel_safe (used by the parallel update).
+         */
+        void update_components(bool parallelSafe);
+
+        /**
+         * Updates the Component::per_frame components (skipped by the fixed steps).
+         */
+        void update_frame_components();
+
         /**
          * Updates the components that need rendering.
          */
@@ -95,6 +117,24 @@ class WithComponents :
             return std::shared_ptr<T>(nullptr);
         }
 
+        /**
+         * Get the handle of a component of certain type (resolved without reference counting).
+         * 
+         * @return A null handle if component cannot be found.
+         */
+        template<typename T>
+        Handle<T> get_handle() {
+            for (auto component : this->components) {
+                if(dynamic_cast<T*>(component.get())) {
+                    auto handle = component->handle();
+
+                    return Handle<T>(handle.index(), handle.generation());
+                }
+            }
+
+            return Handle<T>();
+        }
+
         /**
          * Checks if component is attached.
          */
@@ -149,6 +189,8 @@ class WithComponents :
          * Components attached to this.
          */
         std::vector<std::shared_ptr<Component>> components;
+
+        Handle<WithComponents> __handle;
 };
 
 std::ostream& operator<<(std::ostream& os, const WithComponents& component);
\ No newline at end of file
@@ -0,0 +1,326 @@
+#include "atlas.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <unordered_set>
+
+#include "shadows.hpp"
+#include "../util/memory.hpp"
+
+ShadowAtlas::ShadowAtlas(int size) :
+    __size(ShadowAtlas::MAX_TILE),
+    __unit(Light::reserve_texture_unit()),
+    __fbo(0),
+    __texture(0),
+    __is_init(false),
+    __tile_count(0),
+    __used_texels(0),
+    __failed(0)
+{
+    while(this->__size < size) this->__size *= 2;
+
+    this->__nodes.resize(this->depth(ShadowAtlas::MIN_TILE) + 1);
+
+    for(size_t i = 0; i < this->__nodes.size(); i++) {
+        this->__nodes.at(i).resize(1ull << (2 * i), TileNode::FREE);
+    }
+}
+
+ShadowAtlas::~ShadowAtlas() {
+    if(!this->__is_init) return;
+
+    MemoryTracker::untrack(MemoryKind::SHADOW_MAP, this->__texture);
+
+    glDeleteFramebuffers(1, &this->__fbo);
+    glDeleteTextures(1, &this->__texture);
+}
+
+std::shared_ptr<ShadowAtlas> ShadowAtlas::make_shadow_atlas(int size) {
+    std::shared_ptr<ShadowAtlas> atlas(new ShadowAtlas(size));
+
+    return atlas;
+}
+
+std::shared_ptr<ShadowAtlas> pepng::make_shadow_atlas(int size) {
+    return ShadowAtlas::make_shadow_atlas(size);
+}
+
+void ShadowAtlas::init() {
+    if(this->__is_init) return;
+
+    this->__is_init = true;
+
+    glGenFramebuffers(1, &this->__fbo);
+
+    glGenTextures(1, &this->__texture);
+    glBindTexture(GL_TEXTURE_2D, this->__texture);
+
+    #ifdef EMSCRIPTEN
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, this->__size, this->__size, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+    #else
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32, this->__size, this->__size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    #endif
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, this->__fbo);
+    #ifdef EMSCRIPTEN
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, this->__texture, 0);
+    #else
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, this->__texture, 0);
+    #endif
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    MemoryTracker::track(MemoryKind::SHADOW_MAP, this->__texture, "Shadow atlas", (size_t) this->__size * this->__size * 4);
+}
+
+bool ShadowAtlas::is_atlased(const LightState& light) {
+    return light.type == LightType::SPOT && light.is_active && light.shadows;
+}
+
+int ShadowAtlas::depth(int tileSize) {
+    int depth = 0;
+
+    while((this->__size >> depth) > tileSize) depth++;
+
+    return depth;
+}
+
+bool ShadowAtlas::allocate_tile(int depth, glm::ivec3& tile) {
+    return this->allocate_tile(0, 0, 0, depth, tile);
+}
+
+bool ShadowAtlas::allocate_tile(int depth, int x, int y, int targetDepth, glm::ivec3& tile) {
+    auto& node = this->__nodes.at(depth).at(x + y * (1 << depth));
+
+    if(depth == targetDepth) {
+        if(node != TileNode::FREE) return false;
+
+        int size = this->__size >> depth;
+
+        node = TileNode::USED;
+        tile = glm::ivec3(x * size, y * size, size);
+
+        return true;
+    }
+
+    if(node == TileNode::USED) return false;
+
+    if(node == TileNode::FREE) {
+        node = TileNode::SPLIT;
+
+        for(int i = 0; i < 4; i++) {
+            this->__nodes.at(depth + 1).at((2 * x + i % 2) + (2 * y + i / 2) * (1 << (depth + 1))) = TileNode::FREE;
+        }
+    }
+
+    // The split children are tried first, so the free nodes stay whole for the larger tiles.
+    for(auto state : { TileNode::SPLIT, TileNode::FREE }) {
+        for(int i = 0; i < 4; i++) {
+            int childX = 2 * x + i % 2;
+            int childY = 2 * y + i / 2;
+
+            if(this->__nodes.at(depth + 1).at(childX + childY * (1 << (depth + 1))) != state) continue;
+
+            if(this->allocate_tile(depth + 1, childX, childY, targetDepth, tile)) return true;
+        }
+    }
+
+    return false;
+}
+
+void ShadowAtlas::free_tile(glm::ivec3 tile) {
+    int depth = this->depth(tile.z);
+    int x = tile.x / tile.z;
+    int y = tile.y / tile.z;
+
+    this->__nodes.at(depth).at(x + y * (1 << depth)) = TileNode::FREE;
+
+    // Merges the parents whose 4 children are free.
+    while(depth > 0) {
+        x /= 2;
+        y /= 2;
+        depth--;
+
+        bool free = true;
+
+        for(int i = 0; i < 4; i++) {
+            free = free && this->__nodes.at(depth + 1).at((2 * x + i % 2) + (2 * y + i / 2) * (1 << (depth + 1))) == TileNode::FREE;
+        }
+
+        if(!free) break;
+
+        this->__nodes.at(depth).at(x + y * (1 << depth)) = TileNode::FREE;
+    }
+}
+
+glm::mat4 ShadowAtlas::tile_matrix(glm::ivec3 tile) {
+    float size = (float) this->__size;
+    float scale = tile.z / size;
+
+    glm::mat4 matrix(1.0f);
+
+    matrix[0][0] = scale;
+    matrix[1][1] = scale;
+    matrix[3][0] = scale + 2.0f * tile.x / size - 1.0f;
+    matrix[3][1] = scale + 2.0f * tile.y / size - 1.0f;
+
+    return matrix;
+}
+
+std::vector<bool> ShadowAtlas::allocate(std::vector<LightState>& lights, const std::vector<CameraState>& cameras) {
+    std::vector<bool> retiled(lights.size(), false);
+
+    struct TileRequest {
+        size_t light;
+        int size;
+        float influence;
+    };
+
+    std::vector<TileRequest> requests;
+
+    int maxLevel = this->depth(ShadowAtlas::MIN_TILE) - this->depth(ShadowAtlas::MAX_TILE);
+
+    for(size_t i = 0; i < lights.size(); i++) {
+        auto& light = lights.at(i);
+
+        light.atlas_tile = glm::ivec3(0);
+
+        if(!ShadowAtlas::is_atlased(light)) continue;
+
+        float influence = ShadowScheduler::influence(light, cameras);
+
+        // Halves the tile every time the influence halves (below 1, the camera further than twice the range).
+        int level = influence >= 1.0f ? 0 : std::min((int) std::floor(-std::log2(influence)), maxLevel);
+
+        requests.push_back({ i, ShadowAtlas::MAX_TILE >> level, influence });
+    }
+
+    std::stable_sort(requests.begin(), requests.end(), [](const TileRequest& a, const TileRequest& b) {
+        return a.influence > b.influence;
+    });
+
+    // Frees the tiles of the lights that left the atlas, and the tiles larger than needed (a smaller tile always fits in them).
+    std::unordered_set<Light*> requested;
+
+    for(auto& request : requests) {
+        auto light = lights.at(request.light).light.get();
+        auto tile = this->__tiles.find(light);
+
+        requested.insert(light);
+
+        if(tile != this->__tiles.end() && tile->second.z > request.size) {
+            this->free_tile(tile->second);
+            this->__tiles.erase(tile);
+        }
+    }
+
+    for(auto it = this->__tiles.begin(); it != this->__tiles.end();) {
+        if(requested.count(it->first)) {
+            it++;
+
+            continue;
+        }
+
+        this->free_tile(it->second);
+
+        it = this->__tiles.erase(it);
+    }
+
+    size_t failed = 0;
+
+    for(size_t i = 0; i < requests.size(); i++) {
+        auto& request = requests.at(i);
+        auto& light = lights.at(request.light);
+        auto current = this->__tiles.find(light.light.get());
+
+        glm::ivec3 tile;
+
+        if(current != this->__tiles.end()) {
+            // A smaller tile (allocated when the atlas was full) is only replaced if the requested size is free.
+            if(current->second.z < request.size && this->allocate_tile(this->depth(request.size), tile)) {
+                this->free_tile(current->second);
+
+                current->second = tile;
+                retiled.at(request.light) = true;
+            }
+
+            continue;
+        }
+
+        bool allocated = false;
+
+        while(!allocated) {
+            for(int size = request.size; size >= ShadowAtlas::MIN_TILE && !allocated; size /= 2) {
+                allocated = this->allocate_tile(this->depth(size), tile);
+            }
+
+            if(allocated) break;
+
+            // Evicts the tile of the least influent light after this one (it takes what is left when its turn comes).
+            size_t evicted = requests.size();
+
+            for(size_t j = requests.size() - 1; j > i; j--) {
+                if(this->__tiles.count(lights.at(requests.at(j).light).light.get())) {
+                    evicted = j;
+
+                    break;
+                }
+            }
+
+            if(evicted == requests.size()) break;
+
+            auto victim = this->__tiles.find(lights.at(requests.at(evicted).light).light.get());
+
+            this->free_tile(victim->second);
+            this->__tiles.erase(victim);
+        }
+
+        if(!allocated) {
+            light.shadows = false;
+
+            failed++;
+
+            continue;
+        }
+
+        this->__tiles[light.light.get()] = tile;
+        retiled.at(request.light) = true;
+    }
+
+    size_t usedTexels = 0;
+
+    for(auto& request : requests) {
+        auto& light = lights.at(request.light);
+        auto tile = this->__tiles.find(light.light.get());
+
+        if(tile == this->__tiles.end()) continue;
+
+        light.atlas_tile = tile->second;
+        light.shadow_matrix = this->tile_matrix(tile->second) * light.matrix;
+
+        // The tile holds another light's depth, so the cached shadow map is invalid.
+        if(retiled.at(request.light)) light.light->set_shadow_signature(0);
+
+        usedTexels += (size_t) tile->second.z * tile->second.z;
+    }
+
+    this->__tile_count = this->__tiles.size();
+    this->__used_texels = usedTexels;
+    this->__failed = failed;
+
+    return retiled;
+}
+
+#ifdef IMGUI
+void ShadowAtlas::imgui() {
+    ImGui::Text("Size: %d", this->__size);
+    ImGui::Text("Tiles: %zu", this->__tile_count.load());
+    ImGui::Text("Used: %.1f%%", 100.0f * this->__used_texels / ((float) this->__size * this->__size));
+    ImGui::Text("Without tile: %zu", this->__failed.load());
+}
+#endif
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <unordered_map>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#ifdef IMGUI
+#include <imgui.h>
+#include "../ui/with_imgui.hpp"
+#endif
+
+#include "../component/camera.hpp"
+#include "../component/light.hpp"
+
+/**
+ * A depth texture shared by the spotlight shadow maps (see pepng::set_shadow_atlas).
+ *
+ * Every frame, the active spotlights with shadows get a square tile sized by their screen influence
+ * (ShadowAtlas::MAX_TILE when the camera is within about twice the range, halved every time the influence halves,
+ * down to ShadowAtlas::MIN_TILE), packed by a quadtree allocator: a free node is split in four until it has the tile size.
+ * A light keeps its tile while the size does not change, so its cached shadow map stays valid (see Light::is_shadow_cached).
+ * The lights with the highest influence are allocated first, a light without a tile has no shadows for the frame.
+ *
+ * The atlas is bound to a single texture unit for all spotlights, and LightState::shadow_matrix maps the light
+ * projection to the tile, so the shaders sample it like a spotlight shadow map.
+ */
+class ShadowAtlas
+    #ifdef IMGUI
+    : public WithImGui
+    #endif
+{
+    public:
+        /**
+         * The largest tile (also the shadow map size of a spotlight without the atlas).
+         */
+        static constexpr int MAX_TILE = 1024;
+
+        static constexpr int MIN_TILE = 128;
+
+        /**
+         * Shared_ptr constructor for ShadowAtlas (reserves its texture unit).
+         *
+         * @param size The atlas width and height (rounded up to a power of 2, at least ShadowAtlas::MAX_TILE).
+         */
+        static std::shared_ptr<ShadowAtlas> make_shadow_atlas(int size = 4096);
+
+        ~ShadowAtlas();
+
+        /**
+         * Creates the depth texture and its frame buffer (must be called from the OpenGL thread).
+         */
+        void init();
+
+        /**
+         * Is the light rendered into the atlas (an active spotlight with shadows)?
+         */
+        static bool is_atlased(const LightState& light);
+
+        /**
+         * Allocates the tiles of the atlased lights and sets their LightState::atlas_tile and LightState::shadow_matrix
+         * (the lights that did not get a tile lose their shadows for the frame).
+         *
+         * @return Did the tile of the light (same index in lights) change (its shadow map must be rendered)?
+         */
+        std::vector<bool> allocate(std::vector<LightState>& lights, const std::vector<CameraState>& cameras);
+
+        /**
+         * The matrix mapping the clip space of a light to the clip space of its tile.
+         */
+        glm::mat4 tile_matrix(glm::ivec3 tile);
+
+        inline GLuint fbo() { return this->__fbo; }
+
+        inline GLuint texture() { return this->__texture; }
+
+        inline GLint texture_unit() { return this->__unit; }
+
+        inline int size() { return this->__size; }
+
+        #ifdef IMGUI
+        virtual void imgui() override;
+        #endif
+
+    private:
+        ShadowAtlas(int size);
+        ShadowAtlas(const ShadowAtlas& atlas) = delete;
+
+        enum class TileNode : unsigned char {
+            FREE,
+            SPLIT,
+            USED
+        };
+
+        /**
+         * Allocates a free tile at the quadtree depth (the tile size is the atlas size >> depth).
+         *
+         * @return false if there is no free tile of this size.
+         */
+        bool allocate_tile(int depth, glm::ivec3& tile);
+
+        /**
+         * Allocates a free tile at the target depth under the node (x, y) of the depth (splits the free nodes on the way).
+         */
+        bool allocate_tile(int depth, int x, int y, int targetDepth, glm::ivec3& tile);
+
+        /**
+         * Frees a tile and merges the free siblings.
+         */
+        void free_tile(glm::ivec3 tile);
+
+        /**
+         * The quadtree depth of a tile size.
+         */
+        int depth(int tileSize);
+
+        int __size;
+
+        GLint __unit;
+
+        GLuint __fbo;
+
+        GLuint __texture;
+
+        bool __is_init;
+
+        /**
+         * The node states of every quadtree depth (node x + y * 2^depth).
+         */
+        std::vector<std::vector<TileNode>> __nodes;
+
+        /**
+         * The tile of the lights (x, y and size in texels).
+         */
+        std::unordered_map<Light*, glm::ivec3> __tiles;
+
+        /**
+         * The stats of the last allocation (published by the render thread for the ImGui window on the update thread).
+         */
+        std::atomic<size_t> __tile_count;
+
+        std::atomic<size_t> __used_texels;
+
+        std::atomic<size_t> __failed;
+};
+
+namespace pepng {
+    std::shared_ptr<ShadowAtlas> make_shadow_atlas(int size = 4096);
+}
@@ -0,0 +1,284 @@
+#include "clusters.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <sstream>
+
+#include "../util/memory.hpp"
+
+namespace {
+    const char* TEXTURE_NAMES[3] = { "u_cluster_lights", "u_cluster_grid", "u_cluster_indices" };
+}
+
+LightClusters::LightClusters(glm::ivec3 dimension) :
+    __dimension(glm::max(dimension, glm::ivec3(1))),
+    __near(0.1f),
+    __far(100.0f),
+    __linear(false),
+    __light_count(0),
+    __index_count(0),
+    __max_cluster_lights(0),
+    __is_init(false)
+{
+    for(int i = 0; i < 3; i++) {
+        this->__buffers[i] = 0;
+        this->__textures[i] = 0;
+        this->__units[i] = Light::reserve_texture_unit();
+    }
+}
+
+LightClusters::~LightClusters() {
+    if(!this->__is_init) return;
+
+    for(int i = 0; i < 3; i++) {
+        MemoryTracker::untrack(MemoryKind::BUFFER, this->__buffers[i]);
+    }
+
+    glDeleteTextures(3, this->__textures);
+    glDeleteBuffers(3, this->__buffers);
+}
+
+std::shared_ptr<LightClusters> LightClusters::make_light_clusters(glm::ivec3 dimension) {
+    std::shared_ptr<LightClusters> clusters(new LightClusters(dimension));
+
+    return clusters;
+}
+
+std::shared_ptr<LightClusters> pepng::make_light_clusters(glm::ivec3 dimension) {
+    return LightClusters::make_light_clusters(dimension);
+}
+
+bool LightClusters::is_clustered(const LightState& light) {
+    // Texture buffers are not available in WebGL.
+    #ifdef EMSCRIPTEN
+    return false;
+    #else
+    return light.is_active && !light.shadows && (light.type == LightType::POINT || light.type == LightType::SPOT);
+    #endif
+}
+
+std::string LightClusters::slot_uniform(const LightState& light) {
+    std::stringstream ss;
+
+    ss << (light.type == LightType::POINT ? "u_pointlights[" : "u_spotlights[") << light.slot << "].is_active";
+
+    return ss.str();
+}
+
+void LightClusters::build(const CameraState& camera, const std::vector<LightState>& lights, std::shared_ptr<JobSystem> jobs) {
+    auto& projection = camera.projection;
+    auto view = camera.has_transform ? camera.view : glm::mat4(1.0f);
+
+    // Recovers the planes from the projection (orthographic projections have no perspective divide).
+    this->__linear = projection[2][3] == 0.0f;
+
+    if(this->__linear) {
+        this->__near = (projection[3][2] + 1.0f) / projection[2][2];
+        this->__far = (projection[3][2] - 1.0f) / projection[2][2];
+    } else {
+        this->__near = projection[3][2] / (projection[2][2] - 1.0f);
+        this->__far = projection[3][2] / (projection[2][2] + 1.0f);
+    }
+
+    auto dimension = this->__dimension;
+    float near = this->__near;
+    float far = this->__far;
+    bool linear = this->__linear;
+
+    auto slice = [=](float depth) {
+        float t = linear ? (depth - near) / (far - near) : std::log(depth / near) / std::log(far / near);
+
+        return std::clamp((int) std::floor(t * dimension.z), 0, dimension.z - 1);
+    };
+
+    auto tile = [](float ndc, int count) {
+        return std::clamp((int) std::floor((ndc * 0.5f + 0.5f) * count), 0, count - 1);
+    };
+
+    this->__light_texels.clear();
+    this->__ranges.clear();
+
+    for(auto& light : lights) {
+        if(!LightClusters::is_clustered(light)) continue;
+
+        auto center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+        float radius = light.far_plane;
+
+        float depthMin = std::max(-center.z - radius, near);
+        float depthMax = std::min(-center.z + radius, far);
+
+        if(depthMin > depthMax) continue;
+
+        // The screen bounds of the box around the sphere (clipped to the depth range), which is in front of the camera.
+        glm::vec2 ndcMin(1.0f);
+        glm::vec2 ndcMax(-1.0f);
+
+        for(float depth : { depthMin, depthMax }) {
+            for(float x : { -radius, radius }) {
+                for(float y : { -radius, radius }) {
+                    auto clip = projection * glm::vec4(center.x + x, center.y + y, -depth, 1.0f);
+                    auto ndc = glm::vec2(clip) / clip.w;
+
+                    ndcMin = glm::min(ndcMin, ndc);
+                    ndcMax = glm::max(ndcMax, ndc);
+                }
+            }
+        }
+
+        if(ndcMax.x < -1.0f || ndcMax.y < -1.0f || ndcMin.x > 1.0f || ndcMin.y > 1.0f) continue;
+
+        LightRange range;
+
+        range.min = glm::ivec3(tile(ndcMin.x, dimension.x), tile(ndcMin.y, dimension.y), slice(depthMin));
+        range.max = glm::ivec3(tile(ndcMax.x, dimension.x), tile(ndcMax.y, dimension.y), slice(depthMax));
+
+        this->__ranges.push_back(range);
+
+        bool spot = light.type == LightType::SPOT;
+
+        this->__light_texels.push_back(glm::vec4(light.position, light.far_plane));
+        this->__light_texels.push_back(glm::vec4(light.color * light.intensity, spot ? 1.0f : 0.0f));
+        this->__light_texels.push_back(glm::vec4(spot ? glm::normalize(light.direction) : glm::vec3(0.0f), spot ? std::cos(glm::radians(light.angle / 2.0f)) : -2.0f));
+    }
+
+    this->__light_count = this->__ranges.size();
+
+    size_t cells = dimension.x * dimension.y;
+
+    this->__grid.resize(cells * dimension.z);
+    this->__slice_indices.resize(dimension.z);
+
+    // Every slice only writes its own cells and indices, so the slices are independent jobs.
+    auto assign = [this, cells, dimension](size_t z) {
+        auto grid = this->__grid.begin() + z * cells;
+        auto& indices = this->__slice_indices.at(z);
+
+        std::fill(grid, grid + cells, glm::uvec2(0));
+
+        for(auto& range : this->__ranges) {
+            if((int) z < range.min.z || (int) z > range.max.z) continue;
+
+            for(int y = range.min.y; y <= range.max.y; y++) {
+                for(int x = range.min.x; x <= range.max.x; x++) {
+                    grid[x + dimension.x * y].y++;
+                }
+            }
+        }
+
+        GLuint offset = 0;
+
+        for(size_t i = 0; i < cells; i++) {
+            grid[i].x = offset;
+
+            offset += grid[i].y;
+
+            grid[i].y = 0;
+        }
+
+        indices.resize(offset);
+
+        for(size_t light = 0; light < this->__ranges.size(); light++) {
+            auto& range = this->__ranges.at(light);
+
+            if((int) z < range.min.z || (int) z > range.max.z) continue;
+
+            for(int y = range.min.y; y <= range.max.y; y++) {
+                for(int x = range.min.x; x <= range.max.x; x++) {
+                    auto& cell = grid[x + dimension.x * y];
+
+                    indices.at(cell.x + cell.y++) = light;
+                }
+            }
+        }
+    };
+
+    if(jobs == nullptr) {
+        for(int z = 0; z < dimension.z; z++) {
+            assign(z);
+        }
+    } else {
+        jobs->parallel_for(dimension.z, assign);
+    }
+
+    // Merges the slices (the cell offsets become global).
+    this->__indices.clear();
+
+    size_t maxClusterLights = 0;
+
+    for(int z = 0; z < dimension.z; z++) {
+        GLuint offset = this->__indices.size();
+
+        for(size_t i = z * cells; i < (z + 1) * cells; i++) {
+            this->__grid.at(i).x += offset;
+
+            maxClusterLights = std::max<size_t>(maxClusterLights, this->__grid.at(i).y);
+        }
+
+        auto& indices = this->__slice_indices.at(z);
+
+        this->__indices.insert(this->__indices.end(), indices.begin(), indices.end());
+    }
+
+    this->__index_count = this->__indices.size();
+    this->__max_cluster_lights = maxClusterLights;
+}
+
+void LightClusters::upload(GLuint buffer, GLuint texture, GLenum format, const void* data, size_t bytes) {
+    // Texture buffers cannot be empty.
+    static const glm::vec4 EMPTY(0.0f);
+
+    if(bytes == 0) {
+        data = &EMPTY;
+        bytes = sizeof(EMPTY);
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+
+    // Replaces the storage, so the previous frame can still read the old one.
+    glBufferData(GL_TEXTURE_BUFFER, bytes, data, GL_STREAM_DRAW);
+
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    MemoryTracker::track(MemoryKind::BUFFER, buffer, "Light clusters", bytes);
+}
+
+void LightClusters::upload() {
+    #ifndef EMSCRIPTEN
+    if(!this->__is_init) {
+        glGenBuffers(3, this->__buffers);
+        glGenTextures(3, this->__textures);
+
+        this->__is_init = true;
+    }
+
+    this->upload(this->__buffers[0], this->__textures[0], GL_RGBA32F, this->__light_texels.data(), this->__light_texels.size() * sizeof(glm::vec4));
+    this->upload(this->__buffers[1], this->__textures[1], GL_RG32UI, this->__grid.data(), this->__grid.size() * sizeof(glm::uvec2));
+    this->upload(this->__buffers[2], this->__textures[2], GL_R32UI, this->__indices.data(), this->__indices.size() * sizeof(GLuint));
+    #endif
+}
+
+void LightClusters::record(CommandBuffer& commands) {
+    if(!this->__is_init) return;
+
+    for(int i = 0; i < 3; i++) {
+        commands.bind_texture(this->__units[i], GL_TEXTURE_BUFFER, this->__textures[i]);
+
+        commands.uniform(TEXTURE_NAMES[i], (GLint) this->__units[i]);
+    }
+
+    commands.uniform("u_cluster_dimension", glm::vec3(this->__dimension));
+
+    commands.uniform("u_cluster_depth", glm::vec3(this->__near, this->__far, this->__linear ? 1.0f : 0.0f));
+}
+
+#ifdef IMGUI
+void LightClusters::imgui() {
+    ImGui::Text("Clusters: %d x %d x %d", this->__dimension.x, this->__dimension.y, this->__dimension.z);
+    ImGui::Text("Lights: %zu", this->__light_count.load());
+    ImGui::Text("Indices: %zu", this->__index_count.load());
+    ImGui::Text("Max lights per cluster: %zu", this->__max_cluster_lights.load());
+}
+#endif
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <string>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#ifdef IMGUI
+#include <imgui.h>
+#include "../ui/with_imgui.hpp"
+#endif
+
+#include "jobs.hpp"
+#include "../component/camera.hpp"
+#include "../component/light.hpp"
+#include "../gl/command_buffer.hpp"
+
+/**
+ * Clustered forward lighting: the camera frustum is split into a grid of clusters (tiles in screen space,
+ * exponential slices in depth) and every cluster lists the lights reaching it.
+ *
+ * The lights, the grid and the light indices are uploaded as texture buffers, so the fragment shader
+ * only iterates the lights of its cluster (any number of lights, not limited to the u_pointlights/u_spotlights slots).
+ * Only the active point lights and spotlights without shadows are clustered (see LightClusters::is_clustered).
+ *
+ * Shader interface (see LightClusters::record):
+ * - u_cluster_lights (samplerBuffer, RGBA32F): 3 texels per light,
+ *   (position, range), (color * intensity, 0 for point or 1 for spot) and (direction, cosine of the half angle).
+ * - u_cluster_grid (usamplerBuffer, RG32UI): (first index, count) per cluster, x first then y then z.
+ * - u_cluster_indices (usamplerBuffer, R32UI): the light indices of the clusters.
+ * - u_cluster_dimension (vec3): the number of clusters on each axis.
+ * - u_cluster_depth (vec3): the near and far planes and 1 if the slices are linear (orthographic cameras).
+ */
+class LightClusters
+    #ifdef IMGUI
+    : public WithImGui
+    #endif
+{
+    public:
+        /**
+         * Shared_ptr constructor for LightClusters.
+         *
+         * @param dimension The number of clusters on each axis (X and Y in screen space, Z in depth).
+         */
+        static std::shared_ptr<LightClusters> make_light_clusters(glm::ivec3 dimension = glm::ivec3(16, 9, 24));
+
+        ~LightClusters();
+
+        /**
+         * Is the light shaded through the clusters (instead of its shader slot)?
+         */
+        static bool is_clustered(const LightState& light);
+
+        /**
+         * The is_active uniform of the shader slot of a light (e.g. u_pointlights[2].is_active, disabled while the light is clustered).
+         */
+        static std::string slot_uniform(const LightState& light);
+
+        /**
+         * Assigns the clustered lights to the clusters of the camera (one job per depth slice when jobs is set).
+         */
+        void build(const CameraState& camera, const std::vector<LightState>& lights, std::shared_ptr<JobSystem> jobs = nullptr);
+
+        /**
+         * Uploads the last build to the texture buffers (must be called from the OpenGL thread).
+         */
+        void upload();
+
+        /**
+         * Records the texture buffer binds and the cluster uniforms for the program in use.
+         */
+        void record(CommandBuffer& commands);
+
+        /**
+         * Accessor for the number of clusters on each axis.
+         */
+        inline glm::ivec3 dimension() { return this->__dimension; }
+
+        /**
+         * Accessor for the number of clustered lights of the last build.
+         */
+        inline size_t light_count() { return this->__light_count; }
+
+        /**
+         * Accessor for the number of light indices of the last build (the sum of the cluster light counts).
+         */
+        inline size_t index_count() { return this->__index_count; }
+
+        /**
+         * Accessor for the largest number of lights in a cluster of the last build.
+         */
+        inline size_t max_cluster_lights() { return this->__max_cluster_lights; }
+
+        #ifdef IMGUI
+        virtual void imgui() override;
+        #endif
+
+    private:
+        LightClusters(glm::ivec3 dimension);
+        LightClusters(const LightClusters& clusters) = delete;
+
+        /**
+         * The cluster bounds of a light (inclusive).
+         */
+        struct LightRange {
+            glm::ivec3 min;
+            glm::ivec3 max;
+        };
+
+        /**
+         * Uploads the values to the buffer and attaches it to the texture.
+         */
+        void upload(GLuint buffer, GLuint texture, GLenum format, const void* data, size_t bytes);
+
+        glm::ivec3 __dimension;
+
+        float __near;
+
+        float __far;
+
+        bool __linear;
+
+        /**
+         * The stats of the last build (published by the render thread for the ImGui window on the update thread).
+         */
+        std::atomic<size_t> __light_count;
+
+        std::atomic<size_t> __index_count;
+
+        std::atomic<size_t> __max_cluster_lights;
+
+        /**
+         * The light texels (3 per light).
+         */
+        std::vector<glm::vec4> __light_texels;
+
+        std::vector<LightRange> __ranges;
+
+        /**
+         * The (first index, count) of every cluster.
+         */
+        std::vector<glm::uvec2> __grid;
+
+        std::vector<GLuint> __indices;
+
+        /**
+         * The light indices of each depth slice (merged into __indices after the build).
+         */
+        std::vector<std::vector<GLuint>> __slice_indices;
+
+        bool __is_init;
+
+        GLuint __buffers[3];
+
+        GLuint __textures[3];
+
+        /**
+         * The texture units of the texture buffers (reserved from the light shadow map units).
+         */
+        GLint __units[3];
+};
+
+namespace pepng {
+    std::shared_ptr<LightClusters> make_light_clusters(glm::ivec3 dimension = glm::ivec3(16, 9, 24));
+}
@@ -0,0 +1,399 @@
+#include "deferred.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "pepng.hpp"
+
+namespace {
+    const char* GBUFFER_NAMES[3] = { "u_gbuffer_albedo", "u_gbuffer_normal", "u_gbuffer_depth" };
+
+    /**
+     * The number of sides of the cone volume.
+     */
+    const int CONE_SEGMENTS = 16;
+
+    /**
+     * Spotlights wider than this half angle use the sphere volume (the cone base grows with the tangent).
+     */
+    const float MAX_CONE_HALF_ANGLE = 60.0f;
+}
+
+DeferredShading::DeferredShading(GLuint geometryProgram, GLuint ambientProgram, GLuint pointProgram, GLuint spotProgram) :
+    __geometry_program(geometryProgram),
+    __ambient_program(ambientProgram),
+    __point_program(pointProgram),
+    __spot_program(spotProgram),
+    __gbuffer(nullptr),
+    __sphere(DeferredShading::make_sphere_volume()),
+    __cone(DeferredShading::make_cone_volume()),
+    __volume_count(0),
+    __gbuffer_width(0),
+    __gbuffer_height(0)
+{
+    std::vector<glm::vec3> triangle = { glm::vec3(-1.0f, -1.0f, 0.0f), glm::vec3(3.0f, -1.0f, 0.0f), glm::vec3(-1.0f, 3.0f, 0.0f) };
+
+    this->__fullscreen = Model::make_model()
+        ->set_name("Full screen triangle")
+        ->set_count(triangle.size())
+        ->attach_buffer(pepng::make_buffer<glm::vec3>(std::move(triangle), GL_ARRAY_BUFFER, 0, 3));
+
+    for(int i = 0; i < 3; i++) {
+        this->__units[i] = Light::reserve_texture_unit();
+    }
+}
+
+std::shared_ptr<DeferredShading> DeferredShading::make_deferred_shading(GLuint geometryProgram, GLuint ambientProgram, GLuint pointProgram, GLuint spotProgram) {
+    std::shared_ptr<DeferredShading> deferredShading(new DeferredShading(geometryProgram, ambientProgram, pointProgram, spotProgram));
+
+    return deferredShading;
+}
+
+std::shared_ptr<DeferredShading> pepng::make_deferred_shading(GLuint geometryProgram, GLuint ambientProgram, GLuint pointProgram, GLuint spotProgram) {
+    return DeferredShading::make_deferred_shading(geometryProgram, ambientProgram, pointProgram, spotProgram);
+}
+
+std::shared_ptr<Model> DeferredShading::make_sphere_volume() {
+    std::vector<glm::vec3> vertices;
+
+    // Octahedron faces (counter clockwise seen from outside).
+    for(int face = 0; face < 8; face++) {
+        glm::vec3 sign(face & 1 ? -1.0f : 1.0f, face & 2 ? -1.0f : 1.0f, face & 4 ? -1.0f : 1.0f);
+
+        glm::vec3 a(sign.x, 0.0f, 0.0f);
+        glm::vec3 b(0.0f, sign.y, 0.0f);
+        glm::vec3 c(0.0f, 0.0f, sign.z);
+
+        if(sign.x * sign.y * sign.z < 0.0f) std::swap(b, c);
+
+        vertices.push_back(a);
+        vertices.push_back(b);
+        vertices.push_back(c);
+    }
+
+    // Every subdivision splits the triangles in 4 (on the unit sphere).
+    for(int level = 0; level < 2; level++) {
+        std::vector<glm::vec3> subdivided;
+
+        for(size_t i = 0; i < vertices.size(); i += 3) {
+            auto a = vertices.at(i);
+            auto b = vertices.at(i + 1);
+            auto c = vertices.at(i + 2);
+
+            auto ab = glm::normalize(a + b);
+            auto bc = glm::normalize(b + c);
+            auto ca = glm::normalize(c + a);
+
+            for(auto vertex : { a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca }) {
+                subdivided.push_back(vertex);
+            }
+        }
+
+        vertices = subdivided;
+    }
+
+    // The faces are inside the unit sphere, so the vertices are pushed out until the closest face touches it.
+    float inner = 1.0f;
+
+    for(size_t i = 0; i < vertices.size(); i += 3) {
+        auto normal = glm::normalize(glm::cross(vertices.at(i + 1) - vertices.at(i), vertices.at(i + 2) - vertices.at(i)));
+
+        inner = std::min(inner, glm::dot(normal, vertices.at(i)));
+    }
+
+    for(auto& vertex : vertices) {
+        vertex = vertex / inner;
+    }
+
+    size_t count = vertices.size();
+
+    return Model::make_model()
+        ->set_name("Light volume sphere")
+        ->set_count(count)
+        ->attach_buffer(pepng::make_buffer<glm::vec3>(std::move(vertices), GL_ARRAY_BUFFER, 0, 3));
+}
+
+std::shared_ptr<Model> DeferredShading::make_cone_volume() {
+    std::vector<glm::vec3> vertices;
+
+    // The polygon encloses the unit circle.
+    float radius = 1.0f / std::cos(glm::pi<float>() / CONE_SEGMENTS);
+
+    auto base = [radius](int segment) {
+        float angle = glm::two_pi<float>() * segment / CONE_SEGMENTS;
+
+        return glm::vec3(std::cos(angle) * radius, std::sin(angle) * radius, -1.0f);
+    };
+
+    for(int i = 0; i < CONE_SEGMENTS; i++) {
+        // Side (counter clockwise seen from outside).
+        vertices.push_back(glm::vec3(0.0f));
+        vertices.push_back(base(i));
+        vertices.push_back(base(i + 1));
+
+        // Base (facing -Z).
+        vertices.push_back(glm::vec3(0.0f, 0.0f, -1.0f));
+        vertices.push_back(base(i + 1));
+        vertices.push_back(base(i));
+    }
+
+    size_t count = vertices.size();
+
+    return Model::make_model()
+        ->set_name("Light volume cone")
+        ->set_count(count)
+        ->attach_buffer(pepng::make_buffer<glm::vec3>(std::move(vertices), GL_ARRAY_BUFFER, 0, 3));
+}
+
+void DeferredShading::record_pass(CommandBuffer& commands, GLuint shaderProgram, const CameraState& camera, const glm::mat4& screenToWorld) {
+    commands.use_program(shaderProgram);
+
+    Camera::record(commands, camera, shaderProgram);
+
+    GLuint textures[3] = { this->__gbuffer->albedo_texture(), this->__gbuffer->normal_texture(), this->__gbuffer->depth_texture() };
+
+    for(int i = 0; i < 3; i++) {
+        commands.bind_texture(this->__units[i], GL_TEXTURE_2D, textures[i]);
+
+        commands.uniform(GBUFFER_NAMES[i], (GLint) this->__units[i]);
+    }
+
+    commands.uniform("u_gbuffer_texel", glm::vec3(1.0f / this->__gbuffer->width(), 1.0f / this->__gbuffer->height(), 0.0f));
+
+    commands.uniform("u_screen_to_world", &screenToWorld);
+}
+
+void DeferredShading::record_volume(CommandBuffer& commands, const LightState& light) {
+    bool spot = light.type == LightType::SPOT;
+    float halfAngle = light.angle / 2.0f;
+    float cosAngle = spot ? std::cos(glm::radians(halfAngle)) : -2.0f;
+
+    auto model = this->__sphere;
+    auto world = glm::scale(glm::translate(glm::mat4(1.0f), light.position), glm::vec3(light.far_plane));
+
+    if(spot && halfAngle <= MAX_CONE_HALF_ANGLE) {
+        // The cone points along -Z, so Z is the opposite of the light direction.
+        auto z = -glm::normalize(light.direction);
+        auto up = std::abs(z.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        auto x = glm::normalize(glm::cross(up, z));
+        auto y = glm::cross(z, x);
+
+        glm::mat4 rotation(1.0f);
+
+        rotation[0] = glm::vec4(x, 0.0f);
+        rotation[1] = glm::vec4(y, 0.0f);
+        rotation[2] = glm::vec4(z, 0.0f);
+
+        float base = light.far_plane * std::tan(glm::radians(halfAngle));
+
+        model = this->__cone;
+        world = glm::translate(glm::mat4(1.0f), light.position) * rotation * glm::scale(glm::mat4(1.0f), glm::vec3(base, base, light.far_plane));
+    }
+
+    if(light.shadows) {
+        commands.bind_texture(light.texture_unit, light.light->shadow_target(), light.light->shadow_texture());
+
+        commands.uniform("u_light_shadow", light.texture_unit);
+
+        // The layer of the light in the shadow arrays (see pepng::set_shadow_arrays).
+        commands.uniform("u_light_layer", (GLint) light.slot);
+    }
+
+    commands.uniform("u_world", &world);
+
+    commands.uniform("u_light_position", light.position);
+
+    commands.uniform("u_light_direction", light.direction);
+
+    commands.uniform("u_light_color", light.color);
+
+    commands.uniform("u_light_intensity", light.intensity);
+
+    commands.uniform("u_light_range", light.far_plane);
+
+    commands.uniform("u_light_cos_angle", cosAngle);
+
+    commands.uniform("u_light_shadows", (GLfloat) light.shadows);
+
+    if(spot) {
+        commands.uniform("u_light_matrix", &light.shadow_matrix);
+    }
+
+    commands.bind_vao(model->vao());
+
+    commands.draw_arrays(GL_TRIANGLES, 0, model->count());
+}
+
+void DeferredShading::render(std::shared_ptr<RenderSnapshot> snapshot, const CameraState& camera, const std::vector<CommandBuffer>& transparentDraws) {
+    PEPNG_PROFILE_SCOPE("Deferred");
+
+    int width = snapshot->window.x;
+    int height = snapshot->window.y;
+
+    if(this->__gbuffer == nullptr || this->__gbuffer->width() != width || this->__gbuffer->height() != height) {
+        this->__gbuffer = pepng::make_gbuffer(width, height);
+
+        this->__gbuffer_width = width;
+        this->__gbuffer_height = height;
+    }
+
+    for(auto model : { this->__sphere, this->__cone, this->__fullscreen }) {
+        if(!model->is_init()) model->delayed_init();
+    }
+
+    // Same rectangle as Camera::render_viewport.
+    GLint x = camera.viewport_position.x * snapshot->window.x;
+    GLint y = camera.viewport_position.y * snapshot->window.y;
+    GLsizei w = camera.viewport_scale.x * snapshot->window.x;
+    GLsizei h = camera.viewport_scale.y * snapshot->window.y;
+
+    auto target = RenderTarget::framebuffer();
+
+    // The buffers are shared by the cameras, so only the viewport is cleared.
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(x, y, w, h);
+
+    /**
+     * Geometry
+     */
+    {
+        PEPNG_PROFILE_GPU_SCOPE("Geometry");
+
+        glBindFramebuffer(GL_FRAMEBUFFER, this->__gbuffer->fbo());
+
+        GLfloat zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        GLfloat one = 1.0f;
+
+        glClearBufferfv(GL_COLOR, 0, zero);
+        glClearBufferfv(GL_COLOR, 1, zero);
+        glClearBufferfv(GL_DEPTH, 0, &one);
+
+        glDisable(GL_BLEND);
+
+        auto geometryProgram = this->__geometry_program;
+
+        CommandBuffer header;
+
+        header.use_program(geometryProgram);
+
+        Camera::record(header, camera, geometryProgram);
+
+        header.replay();
+
+        CommandBuffer::replay(pepng::record_draws(snapshot->draws, [geometryProgram](const DrawItem& draw) { return geometryProgram; }, 0, snapshot->opaque_count));
+
+        glEnable(GL_BLEND);
+    }
+
+    /**
+     * Lighting
+     */
+    {
+        PEPNG_PROFILE_GPU_SCOPE("Lighting");
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, this->__gbuffer->fbo());
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, this->__gbuffer->light_fbo());
+        glBlitFramebuffer(x, y, x + w, y + h, x, y, x + w, y + h, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, this->__gbuffer->light_fbo());
+
+        GLfloat background[4] = { snapshot->background_color.x, snapshot->background_color.y, snapshot->background_color.z, 1.0f };
+
+        glClearBufferfv(GL_COLOR, 0, background);
+
+        // Maps the window coordinates (and depth) to NDC, then to the world.
+        auto view = camera.has_transform ? camera.view : glm::mat4(1.0f);
+        auto windowToNdc = glm::scale(
+            glm::translate(glm::mat4(1.0f), glm::vec3(-2.0f * x / w - 1.0f, -2.0f * y / h - 1.0f, -1.0f)),
+            glm::vec3(2.0f / w, 2.0f / h, 2.0f)
+        );
+        auto screenToWorld = glm::inverse(camera.projection * view) * windowToNdc;
+
+        glDepthMask(GL_FALSE);
+
+        // Replaces the clear color of the covered pixels (the background pixels are discarded).
+        CommandBuffer ambient;
+
+        this->record_pass(ambient, this->__ambient_program, camera, screenToWorld);
+
+        ambient.bind_vao(this->__fullscreen->vao());
+        ambient.draw_arrays(GL_TRIANGLES, 0, this->__fullscreen->count());
+
+        glDisable(GL_BLEND);
+        glDisable(GL_DEPTH_TEST);
+
+        ambient.replay();
+
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+
+        // The back faces behind the geometry shade it (also when the camera is inside the volume).
+        CommandBuffer volumes;
+
+        size_t volumeCount = 0;
+
+        for(auto shaderProgram : { this->__point_program, this->__spot_program }) {
+            auto type = shaderProgram == this->__point_program ? LightType::POINT : LightType::SPOT;
+
+            this->record_pass(volumes, shaderProgram, camera, screenToWorld);
+
+            for(auto& light : snapshot->lights) {
+                if(!light.is_active || light.type != type) continue;
+
+                this->record_volume(volumes, light);
+
+                volumeCount++;
+            }
+        }
+
+        this->__volume_count = volumeCount;
+
+        glDepthFunc(GL_GEQUAL);
+        glCullFace(GL_FRONT);
+
+        // The back faces beyond the far plane are kept.
+        #ifndef EMSCRIPTEN
+        glEnable(GL_DEPTH_CLAMP);
+        #endif
+
+        volumes.replay();
+
+        #ifndef EMSCRIPTEN
+        glDisable(GL_DEPTH_CLAMP);
+        #endif
+
+        glCullFace(GL_BACK);
+        glDepthFunc(GL_LESS);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    /**
+     * Transparent (forward, tested against the opaque depth)
+     */
+    CommandBuffer::replay(transparentDraws);
+
+    glDepthMask(GL_TRUE);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, this->__gbuffer->light_fbo());
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+    glBlitFramebuffer(x, y, x + w, y + h, x, y, x + w, y + h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+
+    glDisable(GL_SCISSOR_TEST);
+}
+
+#ifdef IMGUI
+void DeferredShading::imgui() {
+    // The G-buffer is replaced on the render thread, so only the published stats are read.
+    if(this->__gbuffer_width > 0) {
+        ImGui::Text("G-buffer: %d x %d", this->__gbuffer_width.load(), this->__gbuffer_height.load());
+    }
+
+    ImGui::Text("Light volumes: %zu", this->__volume_count.load());
+}
+#endif
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <atomic>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#ifdef IMGUI
+#include <imgui.h>
+#include "../ui/with_imgui.hpp"
+#endif
+
+#include "snapshot.hpp"
+#include "../component/camera.hpp"
+#include "../component/light.hpp"
+#include "../gl/gbuffer.hpp"
+#include "../gl/model.hpp"
+#include "../gl/command_buffer.hpp"
+
+/**
+ * Deferred shading of a camera (see Camera::set_deferred).
+ *
+ * The opaque draws are rendered once into the G-buffer with the geometry program (same Renderer uniforms as the forward path),
+ * the ambient program writes every covered pixel once (the background keeps the clear color),
+ * then every active light draws its volume (a sphere for point lights, a cone for spotlights) with additive blending,
+ * so each pixel is shaded once per light reaching it. The transparent draws are rendered forward on top (see Material::set_transparent).
+ *
+ * Shader interface:
+ * - Geometry program: writes the albedo (location 0) and the octahedral encoded normal (location 1, see the lighting programs).
+ * - Lighting programs (ambient, point and spot): a_position (location 0) with u_world, u_view and u_projection,
+ *   u_gbuffer_albedo, u_gbuffer_normal and u_gbuffer_depth (sampler2D), u_gbuffer_texel (vec3, 1 / size of the G-buffer)
+ *   and u_screen_to_world (mat4, maps (gl_FragCoord.xy, depth, 1) to the world position).
+ *   The pixels with a depth of 1 (background) must be discarded. The ambient program draws a full screen triangle (a_position in NDC).
+ * - Point and spot programs: u_light_position, u_light_direction and u_light_color (vec3), u_light_intensity, u_light_range,
+ *   u_light_cos_angle and u_light_shadows (float), u_light_matrix (mat4, spotlights) and u_light_shadow (samplerCube or sampler2D).
+ *   With the shadow arrays, u_light_shadow is a samplerCubeArray or sampler2DArray and u_light_layer (int) the light layer.
+ */
+class DeferredShading
+    #ifdef IMGUI
+    : public WithImGui
+    #endif
+{
+    public:
+        /**
+         * Shared_ptr constructor for DeferredShading.
+         *
+         * @param geometryProgram The program writing the G-buffer.
+         * @param ambientProgram The program writing every covered pixel once (replaces the clear color).
+         * @param pointProgram The program shading a point light volume.
+         * @param spotProgram The program shading a spotlight volume.
+         */
+        static std::shared_ptr<DeferredShading> make_deferred_shading(GLuint geometryProgram, GLuint ambientProgram, GLuint pointProgram, GLuint spotProgram);
+
+        /**
+         * Renders the opaque draws of the snapshot deferred, then the transparent draws, into the camera viewport of the frame target.
+         *
+         * Must be called from the OpenGL thread, after the camera and light uniforms of the transparent draw programs are set.
+         *
+         * @param transparentDraws The recorded transparent draws (see RenderSnapshot::opaque_count).
+         */
+        void render(std::shared_ptr<RenderSnapshot> snapshot, const CameraState& camera, const std::vector<CommandBuffer>& transparentDraws);
+
+        inline GLuint geometry_program() { return this->__geometry_program; }
+
+        inline GLuint ambient_program() { return this->__ambient_program; }
+
+        inline GLuint point_program() { return this->__point_program; }
+
+        inline GLuint spot_program() { return this->__spot_program; }
+
+        /**
+         * Accessor for the G-buffer (nullptr until the first render, replaced on the OpenGL thread when the window is resized).
+         */
+        inline std::shared_ptr<GBuffer> gbuffer() { return this->__gbuffer; }
+
+        /**
+         * Accessor for the number of light volumes of the last render.
+         */
+        inline size_t volume_count() { return this->__volume_count; }
+
+        #ifdef IMGUI
+        virtual void imgui() override;
+        #endif
+
+    private:
+        DeferredShading(GLuint geometryProgram, GLuint ambientProgram, GLuint pointProgram, GLuint spotProgram);
+        DeferredShading(const DeferredShading& deferredShading) = delete;
+
+        /**
+         * Records the uniforms shared by the lighting programs.
+         */
+        void record_pass(CommandBuffer& commands, GLuint shaderProgram, const CameraState& camera, const glm::mat4& screenToWorld);
+
+        /**
+         * Records the light uniforms and its volume.
+         */
+        void record_volume(CommandBuffer& commands, const LightState& light);
+
+        /**
+         * Generates an octahedron sphere (subdivided) enclosing the unit sphere.
+         */
+        static std::shared_ptr<Model> make_sphere_volume();
+
+        /**
+         * Generates a cone from the origin to the unit disk at Z -1 (enclosing the circular cone).
+         */
+        static std::shared_ptr<Model> make_cone_volume();
+
+        GLuint __geometry_program;
+
+        GLuint __ambient_program;
+
+        GLuint __point_program;
+
+        GLuint __spot_program;
+
+        std::shared_ptr<GBuffer> __gbuffer;
+
+        std::shared_ptr<Model> __sphere;
+
+        std::shared_ptr<Model> __cone;
+
+        std::shared_ptr<Model> __fullscreen;
+
+        /**
+         * The texture units of the albedo, normal and depth textures (reserved from the light shadow map units).
+         */
+        GLint __units[3];
+
+        /**
+         * The stats of the last render (published by the render thread for the ImGui window on the update thread).
+         */
+        std::atomic<size_t> __volume_count;
+
+        std::atomic<int> __gbuffer_width;
+
+        std::atomic<int> __gbuffer_height;
+};
+
+namespace pepng {
+    std::shared_ptr<DeferredShading> make_deferred_shading(GLuint geometryProgram, GLuint ambientProgram, GLuint pointProgram, GLuint spotProgram);
+}
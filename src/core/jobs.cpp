@@ -0,0 +1,161 @@
+#include "jobs.hpp"
+#include "profiler.hpp"
+
+JobSystem::JobSystem(unsigned int threadCount)
+    #ifndef EMSCRIPTEN
+    : __stopping(false)
+    #endif
+{
+    #ifndef EMSCRIPTEN
+    for(unsigned int i = 0; i < threadCount; i++) {
+        this->__threads.push_back(std::thread(&JobSystem::work, this));
+    }
+    #endif
+}
+
+JobSystem::~JobSystem() {
+    #ifndef EMSCRIPTEN
+    {
+        std::lock_guard<std::mutex> lock(this->__mutex);
+
+        this->__stopping = true;
+    }
+
+    this->__condition.notify_all();
+
+    for(auto& thread : this->__threads) {
+        thread.join();
+    }
+    #endif
+}
+
+std::shared_ptr<JobSystem> JobSystem::make_job_system(unsigned int threadCount) {
+    #ifdef EMSCRIPTEN
+        threadCount = 0;
+    #else
+        if(threadCount == 0) {
+            auto hardwareCount = std::thread::hardware_concurrency();
+
+            threadCount = hardwareCount > 1 ? hardwareCount - 1 : 0;
+        }
+    #endif
+
+    std::shared_ptr<JobSystem> jobSystem(new JobSystem(threadCount));
+
+    return jobSystem;
+}
+
+std::shared_ptr<JobSystem> pepng::make_job_system(unsigned int threadCount) {
+    return JobSystem::make_job_system(threadCount);
+}
+
+unsigned int JobSystem::thread_count() {
+    #ifdef EMSCRIPTEN
+        return 1;
+    #else
+        return this->__threads.size() + 1;
+    #endif
+}
+
+void JobSystem::parallel_for(size_t count, std::function<void(size_t)> function, size_t grain) {
+    if(count == 0) return;
+
+    if(grain == 0) grain = 1;
+
+    size_t chunks = (count + grain - 1) / grain;
+
+    #ifndef EMSCRIPTEN
+    if(chunks > 1 && this->__threads.size() > 0) {
+        size_t remaining = chunks;
+        std::exception_ptr error = nullptr;
+        std::mutex errorMutex;
+
+        {
+            std::lock_guard<std::mutex> lock(this->__mutex);
+
+            for(size_t chunk = 0; chunk < chunks; chunk++) {
+                this->__jobs.push_back([&, chunk]() {
+                    size_t end = std::min(count, (chunk + 1) * grain);
+
+                    PEPNG_PROFILE_SCOPE("Job");
+
+                    try {
+                        for(size_t i = chunk * grain; i < end; i++) {
+                            function(i);
+                        }
+                    } catch(...) {
+                        std::lock_guard<std::mutex> errorLock(errorMutex);
+
+                        if(!error) error = std::current_exception();
+                    }
+
+                    {
+                        std::lock_guard<std::mutex> lock(this->__mutex);
+
+                        remaining--;
+                    }
+
+                    this->__done_condition.notify_all();
+                });
+            }
+        }
+
+        this->__condition.notify_all();
+        this->__done_condition.notify_all();
+
+        std::unique_lock<std::mutex> lock(this->__mutex);
+
+        while(remaining > 0) {
+            if(this->__jobs.empty()) {
+                this->__done_condition.wait(lock);
+
+                continue;
+            }
+
+            auto job = std::move(this->__jobs.front());
+
+            this->__jobs.pop_front();
+
+            lock.unlock();
+
+            job();
+
+            lock.lock();
+        }
+
+        lock.unlock();
+
+        if(error) std::rethrow_exception(error);
+
+        return;
+    }
+    #endif
+
+    for(size_t i = 0; i < count; i++) {
+        function(i);
+    }
+}
+
+#ifndef EMSCRIPTEN
+void JobSystem::work() {
+    PEPNG_PROFILE_THREAD("Worker");
+
+    while(true) {
+        std::function<void()> job;
+
+        {
+            std::unique_lock<std::mutex> lock(this->__mutex);
+
+            this->__condition.wait(lock, [this]() { return this->__stopping || !this->__jobs.empty(); });
+
+            if(this->__jobs.empty()) return;
+
+            job = std::move(this->__jobs.front());
+
+            this->__jobs.pop_front();
+        }
+
+        job();
+    }
+}
+#endif
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <exception>
+
+#ifndef EMSCRIPTEN
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#endif
+
+/**
+ * Pool of worker threads that engine work (update, recording, etc) is split across.
+ */
+class JobSystem {
+    public:
+        /**
+         * Shared_ptr constructor for JobSystem.
+         *
+         * @param threadCount The number of worker threads (0 uses the hardware concurrency minus the main thread).
+         */
+        static std::shared_ptr<JobSystem> make_job_system(unsigned int threadCount = 0);
+
+        ~JobSystem();
+
+        /**
+         * Calls function for every index in [0, count) across the workers.
+         *
+         * The calling thread runs jobs until all the indices are done (and sleeps when there are none), so parallel_for can be nested.
+         * The first exception thrown by a job is rethrown on the calling thread.
+         *
+         * @param grain The number of indices that a single job handles.
+         */
+        void parallel_for(size_t count, std::function<void(size_t)> function, size_t grain = 1);
+
+        /**
+         * Accessor for the number of threads (including the calling thread).
+         */
+        unsigned int thread_count();
+
+    private:
+        JobSystem(unsigned int threadCount);
+
+        #ifndef EMSCRIPTEN
+        /**
+         * Worker thread loop.
+         */
+        void work();
+
+        /**
+         * The worker threads.
+         */
+        std::vector<std::thread> __threads;
+
+        /**
+         * The queued jobs.
+         */
+        std::deque<std::function<void()>> __jobs;
+
+        std::mutex __mutex;
+
+        std::condition_variable __condition;
+
+        /**
+         * Wakes the threads waiting in parallel_for when a job finishes or new jobs are queued.
+         */
+        std::condition_variable __done_condition;
+
+        /**
+         * Set when the workers need to exit.
+         */
+        bool __stopping;
+        #endif
+};
+
+namespace pepng {
+    std::shared_ptr<JobSystem> make_job_system(unsigned int threadCount = 0);
+}
@@ -0,0 +1,206 @@
+#include "pacer.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+#ifndef EMSCRIPTEN
+#include <thread>
+#endif
+
+FramePacer::FramePacer(int swapInterval, float targetFps) :
+    __swap_interval(swapInterval),
+    __target_fps(targetFps),
+    __applied_interval(-2),
+    __adaptive_supported(false),
+    __deadline(std::chrono::steady_clock::now()),
+    __last_present(std::chrono::steady_clock::now()),
+    __has_present(false),
+    __frame_time(0.0f),
+    __jitter(0.0f),
+    __max_frame_time(0.0f),
+    __history_index(0)
+{}
+
+std::shared_ptr<FramePacer> FramePacer::make_frame_pacer(int swapInterval, float targetFps) {
+    std::shared_ptr<FramePacer> pacer(new FramePacer(swapInterval, targetFps));
+
+    return pacer;
+}
+
+std::shared_ptr<FramePacer> pepng::make_frame_pacer(int swapInterval, float targetFps) {
+    return FramePacer::make_frame_pacer(swapInterval, targetFps);
+}
+
+void FramePacer::set_swap_interval(int swapInterval) {
+    this->__swap_interval = std::max(swapInterval, FramePacer::ADAPTIVE_VSYNC);
+}
+
+void FramePacer::set_target_fps(float targetFps) {
+    this->__target_fps = std::max(targetFps, 0.0f);
+}
+
+void FramePacer::apply() {
+    int interval = this->__swap_interval;
+
+    if(interval == this->__applied_interval) return;
+
+    #ifdef EMSCRIPTEN
+        this->__adaptive_supported = false;
+    #else
+        this->__adaptive_supported = glfwExtensionSupported("WGL_EXT_swap_control_tear")
+            || glfwExtensionSupported("GLX_EXT_swap_control_tear");
+    #endif
+
+    if(interval == FramePacer::ADAPTIVE_VSYNC && !this->__adaptive_supported) {
+        glfwSwapInterval(1);
+    } else {
+        glfwSwapInterval(interval);
+    }
+
+    this->__applied_interval = interval;
+}
+
+void FramePacer::wait() {
+    float targetFps = this->__target_fps;
+
+    auto now = std::chrono::steady_clock::now();
+
+    if(targetFps <= 0.0f) {
+        this->__deadline = now;
+
+        return;
+    }
+
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / targetFps)
+    );
+
+    this->__deadline += period;
+
+    // Too late (or the rate changed), so the schedule restarts from now instead of bursting to catch up.
+    if(this->__deadline < now || this->__deadline > now + period) {
+        this->__deadline = now;
+
+        return;
+    }
+
+    #ifndef EMSCRIPTEN
+        auto spin = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(FramePacer::SPIN_TIME)
+        );
+
+        if(this->__deadline - now > spin) {
+            std::this_thread::sleep_for(this->__deadline - now - spin);
+        }
+
+        while(std::chrono::steady_clock::now() < this->__deadline) {
+            std::this_thread::yield();
+        }
+    #endif
+}
+
+void FramePacer::present() {
+    auto now = std::chrono::steady_clock::now();
+
+    if(!this->__has_present) {
+        this->__has_present = true;
+        this->__last_present = now;
+
+        return;
+    }
+
+    float frameTime = std::chrono::duration<float>(now - this->__last_present).count();
+
+    this->__last_present = now;
+
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__history_mutex);
+    #endif
+
+    if(this->__history.size() < FramePacer::HISTORY) {
+        this->__history.push_back(frameTime);
+    } else {
+        this->__history.at(this->__history_index) = frameTime;
+    }
+
+    this->__history_index = (this->__history_index + 1) % FramePacer::HISTORY;
+
+    float total = 0.0f;
+    float maxFrameTime = 0.0f;
+
+    for(auto time : this->__history) {
+        total += time;
+        maxFrameTime = std::max(maxFrameTime, time);
+    }
+
+    float average = total / this->__history.size();
+    float variance = 0.0f;
+
+    for(auto time : this->__history) {
+        variance += (time - average) * (time - average);
+    }
+
+    this->__frame_time = average;
+    this->__jitter = std::sqrt(variance / this->__history.size());
+    this->__max_frame_time = maxFrameTime;
+}
+
+std::vector<float> FramePacer::history() {
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__history_mutex);
+    #endif
+
+    std::vector<float> history;
+
+    if(this->__history.size() < FramePacer::HISTORY) {
+        history = this->__history;
+    } else {
+        history.insert(history.end(), this->__history.begin() + this->__history_index, this->__history.end());
+        history.insert(history.end(), this->__history.begin(), this->__history.begin() + this->__history_index);
+    }
+
+    return history;
+}
+
+#ifdef IMGUI
+void FramePacer::imgui() {
+    const char* items[] = { "Adaptive", "Off", "On", "Half" };
+
+    int item_current_idx = std::clamp(this->__swap_interval + 1, 0, 3);
+
+    if (ImGui::BeginCombo("VSync", items[item_current_idx])) {
+        for (int n = 0; n < IM_ARRAYSIZE(items); n++) {
+            const bool is_selected = (item_current_idx == n);
+
+            if (ImGui::Selectable(items[n], is_selected)) {
+                this->set_swap_interval(n - 1);
+            }
+
+            if (is_selected) {
+                ImGui::SetItemDefaultFocus();
+            }
+        }
+        ImGui::EndCombo();
+    }
+
+    if(this->__swap_interval == FramePacer::ADAPTIVE_VSYNC && !this->__adaptive_supported) {
+        ImGui::Text("Adaptive vsync is not supported (using On).");
+    }
+
+    float targetFps = this->__target_fps;
+
+    if(ImGui::InputFloat("Target FPS", &targetFps)) {
+        this->set_target_fps(targetFps);
+    }
+
+    ImGui::Text("Frame: %.2f ms (%.1f FPS)", this->__frame_time * 1000.0f, this->__frame_time > 0.0f ? 1.0f / this->__frame_time : 0.0f);
+    ImGui::Text("Jitter: %.2f ms", this->__jitter * 1000.0f);
+    ImGui::Text("Max: %.2f ms", this->__max_frame_time * 1000.0f);
+
+    auto history = this->history();
+
+    if(!history.empty()) {
+        ImGui::PlotLines("Present", history.data(), history.size(), 0, nullptr, 0.0f, this->__max_frame_time, ImVec2(0, 60));
+    }
+}
+#endif
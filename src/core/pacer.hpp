@@ -0,0 +1,163 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <chrono>
+
+#ifndef EMSCRIPTEN
+#include <mutex>
+#endif
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#ifdef IMGUI
+#include <imgui.h>
+#include "../ui/with_imgui.hpp"
+#endif
+
+/**
+ * Controls the swap interval, limits the frame rate and measures the present to present timing.
+ *
+ * The settings can be changed from any thread, they are applied by the thread that owns the context.
+ */
+class FramePacer
+    #ifdef IMGUI
+    : public WithImGui
+    #endif
+{
+    public:
+        /**
+         * Swap interval that allows late frames to tear (falls back to 1 if unsupported).
+         */
+        static constexpr int ADAPTIVE_VSYNC = -1;
+
+        /**
+         * Number of presents kept for the statistics.
+         */
+        static const size_t HISTORY = 120;
+
+        /**
+         * Shared_ptr constructor for FramePacer.
+         *
+         * @param swapInterval The number of screen updates between swaps (0 disables vsync, -1 is adaptive).
+         * @param targetFps The frame limiter rate (0 is uncapped).
+         */
+        static std::shared_ptr<FramePacer> make_frame_pacer(int swapInterval = 1, float targetFps = 0.0f);
+
+        /**
+         * Mutator for the swap interval (applied on the next FramePacer::apply).
+         */
+        void set_swap_interval(int swapInterval);
+
+        /**
+         * Accessor for the requested swap interval.
+         */
+        inline int swap_interval() { return this->__swap_interval; }
+
+        /**
+         * Mutator for the frame limiter rate (0 is uncapped).
+         */
+        void set_target_fps(float targetFps);
+
+        /**
+         * Accessor for the frame limiter rate.
+         */
+        inline float target_fps() { return this->__target_fps; }
+
+        /**
+         * Is adaptive vsync supported by the current context?
+         */
+        inline bool adaptive_supported() { return this->__adaptive_supported; }
+
+        /**
+         * Applies the swap interval if it changed (must be called from the context thread).
+         */
+        void apply();
+
+        /**
+         * Waits until the next frame is due (sleeps, then spins for the last part).
+         *
+         * Called right before the buffer swap.
+         */
+        void wait();
+
+        /**
+         * Records the present time (called right after the buffer swap).
+         */
+        void present();
+
+        /**
+         * The average present to present time in seconds.
+         */
+        inline float frame_time() { return this->__frame_time; }
+
+        /**
+         * The standard deviation of the present to present time in seconds.
+         */
+        inline float jitter() { return this->__jitter; }
+
+        /**
+         * The longest present to present time in seconds.
+         */
+        inline float max_frame_time() { return this->__max_frame_time; }
+
+        /**
+         * Copies the last present to present times in seconds (oldest first).
+         */
+        std::vector<float> history();
+
+        #ifdef IMGUI
+        virtual void imgui() override;
+        #endif
+
+    private:
+        FramePacer(int swapInterval, float targetFps);
+
+        /**
+         * Time left to the deadline that is spun instead of slept (sleep is not precise enough).
+         */
+        static constexpr double SPIN_TIME = 0.002;
+
+        std::atomic<int> __swap_interval;
+
+        std::atomic<float> __target_fps;
+
+        /**
+         * The swap interval that was last applied (-2 if none).
+         */
+        int __applied_interval;
+
+        bool __adaptive_supported;
+
+        /**
+         * When the next frame is due.
+         */
+        std::chrono::steady_clock::time_point __deadline;
+
+        std::chrono::steady_clock::time_point __last_present;
+
+        bool __has_present;
+
+        std::atomic<float> __frame_time;
+
+        std::atomic<float> __jitter;
+
+        std::atomic<float> __max_frame_time;
+
+        /**
+         * Present to present times (ring buffer).
+         */
+        std::vector<float> __history;
+
+        size_t __history_index;
+
+        #ifndef EMSCRIPTEN
+        std::mutex __history_mutex;
+        #endif
+};
+
+namespace pepng {
+    std::shared_ptr<FramePacer> make_frame_pacer(int swapInterval = 1, float targetFps = 0.0f);
+}
@@ -1,16 +1,86 @@
 #include "pepng.hpp"
 
+#include <unordered_set>
+
+#ifndef EMSCRIPTEN
+#include <mutex>
+#endif
+
 #include "../../src/component/camera.hpp"
 #include "../../src/component/light.hpp"
+#include "../../src/component/spotlight.hpp"
+#include "../../src/component/pointlight.hpp"
 #include "../../src/gl/texture.hpp"
 #include "../util/load.hpp"
+#include "snapshot.hpp"
+#include "pipeline.hpp"
 
 namespace pepng {
     static GLFWwindow *WINDOW = 0;
     static std::shared_ptr<Input> INPUT;
     static std::vector<std::shared_ptr<Object>> WORLD;
     static std::shared_ptr<Object> CURRENT_IMGUI_OBJECT;
+    /**
+     * The objects passed to pepng::destroy (removed at the end of the frame).
+     */
+    static std::vector<std::shared_ptr<Object>> DESTROYED;
+    #ifndef EMSCRIPTEN
+    static std::mutex DESTROYED_MUTEX;
+    #endif
     static glm::vec3 BACKGROUND_COLOR;
+    static std::shared_ptr<JobSystem> JOBS;
+    static std::shared_ptr<FramePacer> PACER = pepng::make_frame_pacer();
+    static std::shared_ptr<RenderStats> STATS = pepng::make_render_stats();
+    static bool PARALLEL_UPDATE = false;
+    static bool LIGHT_CULLING = true;
+    static bool CLUSTERED_LIGHTING = false;
+    /**
+     * The light clusters of the camera being rendered (created by pepng::set_clustered_lighting, the render thread reads the snapshot copy).
+     */
+    static std::shared_ptr<LightClusters> CLUSTERS;
+    /**
+     * The shadow map updates scheduler (created by pepng::set_shadow_budget).
+     */
+    static std::shared_ptr<ShadowScheduler> SHADOW_SCHEDULER;
+    /**
+     * The spotlight shadow atlas (created by pepng::set_shadow_atlas).
+     */
+    static std::shared_ptr<ShadowAtlas> SHADOW_ATLAS;
+    /**
+     * The point light and spotlight shadow arrays (created by pepng::set_shadow_arrays).
+     */
+    static std::shared_ptr<ShadowArray> POINT_SHADOW_ARRAY;
+    static std::shared_ptr<ShadowArray> SPOT_SHADOW_ARRAY;
+    static std::shared_ptr<RenderSnapshot> SNAPSHOT;
+    static unsigned long FRAME_INDEX = 0;
+    static unsigned long SNAPSHOT_FRAME_INDEX = 0;
+    static bool PIPELINED = false;
+    static int PIPELINE_LATENCY = 1;
+    static std::shared_ptr<FramePipeline> PIPELINE;
+    /**
+     * The last frame read back by the render thread, once requested by pepng::read_frame (pipelined only).
+     */
+    static bool READBACK_REQUESTED = false;
+    static std::vector<unsigned char> READBACK_PIXELS;
+    #ifndef EMSCRIPTEN
+    static std::mutex READBACK_MUTEX;
+    #endif
+    static float FIXED_TIMESTEP = 0.0f;
+    static int MAX_STEPS = 5;
+    static double ACCUMULATOR = 0.0;
+    static double LAST_TIME = -1.0;
+    static float INTERPOLATION_ALPHA = 1.0f;
+    /**
+     * Longest frame time that is simulated (longer frames are clamped, e.g. when debugging).
+     */
+    static const double MAX_FRAME_TIME = 0.25;
+    /**
+     * The number of draws recorded by a single job.
+     */
+    static const size_t RECORD_CHUNK = 256;
+
+    static bool HEADLESS_MODE = false;
+    static unsigned long FRAME_LIMIT = 0;
 
     static float WINDOW_X;
     static float WINDOW_Y;
@@ -21,6 +91,8 @@ namespace pepng {
 
     std::vector<std::shared_ptr<Object>> world() { return WORLD; }
 
+    std::shared_ptr<JobSystem> jobs() { return JOBS; }
+
     float windowX() { return WINDOW_X; }
 
     float windowY() { return WINDOW_Y; }
@@ -33,6 +105,146 @@ void windowSizeCallback(GLFWwindow *window, int width, int height) {
 
 void pepng::set_background_color(glm::vec3 color) { BACKGROUND_COLOR = color; }
 
+void pepng::set_parallel_update(bool parallelUpdate) { PARALLEL_UPDATE = parallelUpdate; }
+
+void pepng::set_light_culling(bool lightCulling) { LIGHT_CULLING = lightCulling; }
+
+void pepng::set_clustered_lighting(bool clusteredLighting) {
+    CLUSTERED_LIGHTING = clusteredLighting;
+
+    // Reserves the texture units of the clusters (the lights created before have the lower units).
+    if(CLUSTERED_LIGHTING && CLUSTERS == nullptr) {
+        CLUSTERS = pepng::make_light_clusters();
+    }
+}
+
+void pepng::set_shadow_budget(int faces) {
+    if(SHADOW_SCHEDULER == nullptr) {
+        SHADOW_SCHEDULER = pepng::make_shadow_scheduler(faces);
+    } else {
+        SHADOW_SCHEDULER->set_budget(faces);
+    }
+}
+
+namespace {
+    /**
+     * Throws if the render thread is running (it reads the shadow storage of the lights, see Spotlight::atlas).
+     */
+    void check_not_pipelined(const char* setting) {
+        if(pepng::PIPELINE == nullptr) return;
+
+        std::stringstream ss;
+
+        ss << setting << " must be called before pepng::update when pipelined.";
+
+        std::cout << ss.str() << std::endl;
+
+        throw std::runtime_error(ss.str());
+    }
+}
+
+void pepng::set_shadow_atlas(int size) {
+    if(SHADOW_ATLAS != nullptr) return;
+
+    check_not_pipelined("pepng::set_shadow_atlas");
+
+    SHADOW_ATLAS = pepng::make_shadow_atlas(size);
+
+    Spotlight::atlas = SHADOW_ATLAS;
+}
+
+void pepng::set_shadow_arrays(bool shadowArrays) {
+    #ifndef EMSCRIPTEN
+    if(!shadowArrays || POINT_SHADOW_ARRAY != nullptr) return;
+
+    check_not_pipelined("pepng::set_shadow_arrays");
+
+    if(!GLEW_VERSION_4_0 && !GLEW_ARB_texture_cube_map_array) {
+        std::stringstream ss;
+
+        ss << "Shadow arrays need cube map arrays (OpenGL 4.0 or ARB_texture_cube_map_array).";
+
+        std::cout << ss.str() << std::endl;
+
+        throw std::runtime_error(ss.str());
+    }
+
+    POINT_SHADOW_ARRAY = pepng::make_shadow_array(GL_TEXTURE_CUBE_MAP_ARRAY);
+
+    Pointlight::shadow_array = POINT_SHADOW_ARRAY;
+
+    // The atlas already shares one texture between the spotlights.
+    if(SHADOW_ATLAS == nullptr) {
+        SPOT_SHADOW_ARRAY = pepng::make_shadow_array(GL_TEXTURE_2D_ARRAY);
+
+        Spotlight::shadow_array = SPOT_SHADOW_ARRAY;
+    }
+    #endif
+}
+
+void pepng::set_pipelined(bool pipelined, int latency) {
+    #ifndef EMSCRIPTEN
+    PIPELINED = pipelined;
+    PIPELINE_LATENCY = latency;
+    #endif
+}
+
+bool pepng::pipelined() { return PIPELINE != nullptr; }
+
+bool pepng::headless() { return HEADLESS_MODE; }
+
+void pepng::set_frame_limit(unsigned long frames) { FRAME_LIMIT = frames; }
+
+unsigned long pepng::frame_index() { return FRAME_INDEX; }
+
+bool pepng::read_frame(std::vector<unsigned char>& pixels) {
+    if(RenderTarget::current_target == nullptr) return false;
+
+    // The context belongs to the render thread, which reads the frames back once requested (see pepng::extra::read_back).
+    if(PIPELINE != nullptr) {
+        #ifndef EMSCRIPTEN
+        std::lock_guard<std::mutex> lock(READBACK_MUTEX);
+        #endif
+
+        READBACK_REQUESTED = true;
+
+        if(READBACK_PIXELS.empty()) return false;
+
+        pixels = READBACK_PIXELS;
+
+        return true;
+    }
+
+    RenderTarget::current_target->read_pixels(pixels);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, RenderTarget::framebuffer());
+
+    return true;
+}
+
+void pepng::set_fixed_timestep(float hz, int maxSteps) {
+    FIXED_TIMESTEP = hz > 0.0f ? 1.0f / hz : 0.0f;
+    MAX_STEPS = maxSteps < 1 ? 1 : maxSteps;
+    ACCUMULATOR = 0.0;
+    INTERPOLATION_ALPHA = 1.0f;
+}
+
+void pepng::set_swap_interval(int swapInterval) { PACER->set_swap_interval(swapInterval); }
+
+void pepng::set_target_fps(float targetFps) { PACER->set_target_fps(targetFps); }
+
+std::shared_ptr<FramePacer> pepng::pacer() { return PACER; }
+
+void pepng::set_profiling(bool profiling) { Profiler::current_profiler->set_enabled(profiling); }
+
+std::shared_ptr<Profiler> pepng::profiler() { return Profiler::current_profiler; }
+
+std::shared_ptr<RenderStats> pepng::render_stats() { return STATS; }
+
+float pepng::delta_time() { return Component::delta_time(); }
+
+float pepng::interpolation_alpha() { return INTERPOLATION_ALPHA; }
+
 void pepng::set_object_shader(GLuint shader_program) {
     glUseProgram(shader_program);
 
@@ -73,6 +285,16 @@ void pepng::instantiate(std::shared_ptr<Object> object) {
     WORLD.push_back(object);
 }
 
+void pepng::destroy(std::shared_ptr<Object> object) {
+    if(object == nullptr) return;
+
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(DESTROYED_MUTEX);
+    #endif
+
+    DESTROYED.push_back(object);
+}
+
 #ifdef IMGUI
 namespace pepng {
     void imgui_init() {
@@ -111,8 +333,10 @@ namespace pepng {
         }
     }
 
-    void imgui_render() {
-        ImGui_ImplOpenGL3_NewFrame();
+    /**
+     * Builds the ImGui windows (needs to be on the update thread as the windows modify the world).
+     */
+    void imgui_build() {
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
@@ -132,6 +356,82 @@ namespace pepng {
         
         ImGui::End();
 
+        ImGui::Begin("Frame Pacing");
+
+        PACER->imgui();
+
+        ImGui::End();
+
+        ImGui::Begin("Profiler");
+
+        Profiler::current_profiler->imgui();
+
+        ImGui::End();
+
+        ImGui::Begin("Stats");
+
+        STATS->imgui();
+
+        ImGui::End();
+
+        ImGui::Begin("Memory");
+
+        MemoryTracker::tracker()->imgui();
+
+        ImGui::End();
+
+        for(auto camera : Camera::cameras) {
+            if(camera->deferred() == nullptr) continue;
+
+            ImGui::Begin("Deferred");
+
+            camera->deferred()->imgui();
+
+            ImGui::End();
+
+            break;
+        }
+
+        if(CLUSTERS != nullptr) {
+            ImGui::Begin("Clusters");
+
+            CLUSTERS->imgui();
+
+            ImGui::End();
+        }
+
+        if(SHADOW_SCHEDULER != nullptr) {
+            ImGui::Begin("Shadows");
+
+            SHADOW_SCHEDULER->imgui();
+
+            ImGui::End();
+        }
+
+        if(SHADOW_ATLAS != nullptr) {
+            ImGui::Begin("Shadow atlas");
+
+            SHADOW_ATLAS->imgui();
+
+            ImGui::End();
+        }
+
+        if(POINT_SHADOW_ARRAY != nullptr) {
+            ImGui::Begin("Shadow arrays");
+
+            ImGui::Text("Point lights");
+
+            POINT_SHADOW_ARRAY->imgui();
+
+            if(SPOT_SHADOW_ARRAY != nullptr) {
+                ImGui::Text("Spotlights");
+
+                SPOT_SHADOW_ARRAY->imgui();
+            }
+
+            ImGui::End();
+        }
+
         ImGui::Begin("Texture");
 
         static int index = 1;
@@ -143,17 +443,38 @@ namespace pepng {
         ImGui::End();
 
         ImGui::Render();
+    }
+
+    void imgui_render() {
+        ImGui_ImplOpenGL3_NewFrame();
+
+        imgui_build();
+
+        PEPNG_PROFILE_GPU_SCOPE("ImGui");
+
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
     }
 }
 #endif
 
+bool pepng::init_headless(float width, float height) {
+    HEADLESS_MODE = true;
+
+    return pepng::init("pepng", width, height);
+}
+
 bool pepng::init(const char *title, float width, float height) {
     srand(time(NULL));
 
+    #if defined(HEADLESS) && !defined(EMSCRIPTEN)
+    HEADLESS_MODE = true;
+    #endif
+
     pepng::WINDOW_X = width;
     pepng::WINDOW_Y = height;
 
+    PEPNG_PROFILE_THREAD("Main");
+
     /**
      * GLFW
      */
@@ -165,6 +486,10 @@ bool pepng::init(const char *title, float width, float height) {
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
 
+    if(HEADLESS_MODE) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
+
     pepng::WINDOW = glfwCreateWindow(pepng::WINDOW_X, pepng::WINDOW_Y, title, NULL, NULL);
 
     if (pepng::window == NULL) {
@@ -183,7 +508,13 @@ bool pepng::init(const char *title, float width, float height) {
         return false;
     }
 
-    glfwSwapInterval(1);
+    // Offscreen frames are never presented, so they are not synced to a display.
+    if(HEADLESS_MODE) {
+        pepng::PACER->set_swap_interval(0);
+    }
+
+    pepng::PACER->apply();
+
     glfwSetWindowSizeCallback(pepng::WINDOW, windowSizeCallback);
 
     /**
@@ -198,6 +529,11 @@ bool pepng::init(const char *title, float width, float height) {
      */
     pepng::INPUT = pepng::make_input(pepng::WINDOW);
 
+    /**
+     * Jobs
+     */
+    pepng::JOBS = pepng::make_job_system();
+
     /**
      * OpenGL
      */
@@ -206,67 +542,543 @@ bool pepng::init(const char *title, float width, float height) {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+    /**
+     * Offscreen
+     */
+    if(HEADLESS_MODE) {
+        RenderTarget::current_target = pepng::make_render_target(width, height);
+    }
+
     return true;
 }
 
 void pepng::extra::update_objects() {
+    PEPNG_PROFILE_SCOPE("Update");
+
+    double time = glfwGetTime();
+    double frameTime = LAST_TIME < 0.0 ? 0.0 : std::min(time - LAST_TIME, MAX_FRAME_TIME);
+
+    LAST_TIME = time;
+
+    if(FIXED_TIMESTEP <= 0.0f) {
+        if(frameTime > 0.0) {
+            Component::set_delta_time(frameTime);
+        }
+
+        INTERPOLATION_ALPHA = 1.0f;
+
+        pepng::extra::update_step();
+
+        return;
+    }
+
+    // The input of the frame is consumed once, whatever the number of steps.
+    if(frameTime > 0.0) {
+        Component::set_delta_time(frameTime);
+    }
+
     for(auto object : WORLD) {
-        object->update();
+        object->update_frame();
+    }
+
+    Component::set_delta_time(FIXED_TIMESTEP);
+    Component::set_fixed_step(true);
+
+    ACCUMULATOR += frameTime;
+
+    for(int step = 0; step < MAX_STEPS && ACCUMULATOR >= FIXED_TIMESTEP; step++) {
+        for(auto object : WORLD) {
+            object->for_each([](std::shared_ptr<Object> child) {
+                if(auto transform = child->get_component<Transform>()) {
+                    transform->store_previous();
+                }
+            });
+        }
+
+        pepng::extra::update_step();
+
+        ACCUMULATOR -= FIXED_TIMESTEP;
+    }
+
+    Component::set_fixed_step(false);
+
+    // Drops the time that could not be simulated (keeps the phase for the interpolation).
+    if(ACCUMULATOR >= FIXED_TIMESTEP) {
+        ACCUMULATOR = std::fmod(ACCUMULATOR, (double) FIXED_TIMESTEP);
+    }
+
+    INTERPOLATION_ALPHA = ACCUMULATOR / FIXED_TIMESTEP;
+}
+
+void pepng::extra::update_step() {
+    if(!PARALLEL_UPDATE || JOBS == nullptr) {
+        for(auto object : WORLD) {
+            object->update();
+        }
+
+        return;
+    }
+
+    Object::update_parallel(WORLD, JOBS);
+}
+
+void pepng::extra::capture_frame() {
+    PEPNG_PROFILE_SCOPE("Capture");
+
+    SNAPSHOT = RenderSnapshot::capture(WORLD, glm::vec2(WINDOW_X, WINDOW_Y), BACKGROUND_COLOR, INTERPOLATION_ALPHA, LIGHT_CULLING, CLUSTERED_LIGHTING ? CLUSTERS : nullptr);
+    SNAPSHOT->shadow_scheduler = SHADOW_SCHEDULER;
+    SNAPSHOT->shadow_atlas = SHADOW_ATLAS;
+    SNAPSHOT_FRAME_INDEX = FRAME_INDEX;
+}
+
+std::shared_ptr<RenderSnapshot> pepng::extra::snapshot() {
+    if(SNAPSHOT == nullptr || SNAPSHOT_FRAME_INDEX != FRAME_INDEX) {
+        pepng::extra::capture_frame();
     }
+
+    return SNAPSHOT;
+}
+
+std::vector<CommandBuffer> pepng::record_draws(const std::vector<DrawItem>& draws, std::function<GLuint(const DrawItem&)> shaderProgram, size_t first, size_t last) {
+    last = std::min(last, draws.size());
+    first = std::min(first, last);
+
+    size_t chunks = (last - first + RECORD_CHUNK - 1) / RECORD_CHUNK;
+
+    std::vector<CommandBuffer> commands(chunks);
+
+    auto record = [&](size_t chunk) {
+        size_t end = std::min(last, first + (chunk + 1) * RECORD_CHUNK);
+
+        for(size_t i = first + chunk * RECORD_CHUNK; i < end; i++) {
+            Renderer::record(commands.at(chunk), draws.at(i), shaderProgram(draws.at(i)));
+        }
+    };
+
+    if(JOBS == nullptr) {
+        for(size_t chunk = 0; chunk < chunks; chunk++) {
+            record(chunk);
+        }
+    } else {
+        JOBS->parallel_for(chunks, record);
+    }
+
+    return commands;
+}
+
+std::vector<CommandBuffer> pepng::record_draws(const std::vector<DrawItem>& draws, const std::vector<size_t>& indices, std::function<GLuint(const DrawItem&)> shaderProgram, std::function<void(CommandBuffer&, const DrawItem&)> uniforms) {
+    size_t chunks = (indices.size() + RECORD_CHUNK - 1) / RECORD_CHUNK;
+
+    std::vector<CommandBuffer> commands(chunks);
+
+    auto record = [&](size_t chunk) {
+        size_t end = std::min(indices.size(), (chunk + 1) * RECORD_CHUNK);
+
+        for(size_t i = chunk * RECORD_CHUNK; i < end; i++) {
+            auto& draw = draws.at(indices.at(i));
+            auto program = shaderProgram(draw);
+
+            if(uniforms) {
+                commands.at(chunk).use_program(program);
+
+                uniforms(commands.at(chunk), draw);
+            }
+
+            Renderer::record(commands.at(chunk), draw, program);
+        }
+    };
+
+    if(JOBS == nullptr) {
+        for(size_t chunk = 0; chunk < chunks; chunk++) {
+            record(chunk);
+        }
+    } else {
+        JOBS->parallel_for(chunks, record);
+    }
+
+    return commands;
 }
 
 void pepng::extra::render_shadows() {
-    for(auto light : Light::lights) {
-        if(light->active()) {
-            light->init_fbo();
+    pepng::extra::render_shadows(pepng::extra::snapshot());
+}
 
-            for(auto object : WORLD) {
-                object->render(light->shader_program());
+void pepng::extra::render_shadows(std::shared_ptr<RenderSnapshot> snapshot) {
+    PEPNG_PROFILE_SCOPE("Shadows");
+    PEPNG_PROFILE_GPU_SCOPE("Shadows");
+
+    snapshot->prepare();
+
+    STATS->begin_pass("Shadows");
+
+    // The tiles are allocated first, so the retiled lights (cache invalidated) are scheduled.
+    std::vector<bool> retiled;
+
+    if(snapshot->shadow_atlas != nullptr) retiled = snapshot->shadow_atlas->allocate(snapshot->lights, snapshot->cameras);
+
+    std::vector<bool> scheduled;
+
+    if(snapshot->shadow_scheduler != nullptr) scheduled = snapshot->shadow_scheduler->schedule(snapshot->lights, snapshot->cameras);
+
+    for(size_t i = 0; i < snapshot->lights.size(); i++) {
+        auto& light = snapshot->lights.at(i);
+
+        if(!light.is_active || !light.shadows) continue;
+
+        auto caster = light.light;
+        auto shaderProgram = caster->shader_program();
+        bool dynamic = !light.dynamic_casters.empty();
+
+        // The shadow map only holds the static casters, and neither they nor the light moved.
+        if(caster->is_shadow_cached(light)) {
+            STATS->add_cached_shadow_map();
+
+            continue;
+        }
+
+        bool tiled = light.atlas_tile.z > 0;
+
+        // Over the budget, the last shadow map is kept (unless the tile moved, it then holds another light's depth).
+        if(!scheduled.empty() && !scheduled.at(i) && !(tiled && retiled.at(i))) continue;
+
+        STATS->add_shadow_map();
+
+        auto render = [&](GLuint fbo, bool clear, const std::vector<size_t>& casters) {
+            CommandBuffer header;
+
+            caster->record_fbo(header, light, fbo, clear);
+
+            header.replay();
+
+            CommandBuffer::replay(pepng::record_draws(
+                snapshot->draws,
+                casters,
+                [shaderProgram](const DrawItem& draw) { return shaderProgram; },
+                [&caster, &light](CommandBuffer& commands, const DrawItem& draw) { caster->record_caster(commands, light, draw); }
+            ));
+        };
+
+        if(dynamic && tiled) {
+            // The tiles are not cached apart (the atlas would double), so the static casters are drawn again.
+            render(caster->fbo(), true, light.static_casters);
+            render(caster->fbo(), false, light.dynamic_casters);
+
+            caster->set_shadow_signature(0);
+        } else if(dynamic) {
+            caster->init_static_map();
+
+            if(caster->static_signature() != light.static_signature) {
+                render(caster->static_fbo(), true, light.static_casters);
+
+                caster->set_static_signature(light.static_signature);
             }
 
-            light->update_fbo();
+            // The dynamic casters are drawn over a copy of the static casters.
+            caster->copy_static_map(light);
+
+            render(caster->fbo(), false, light.dynamic_casters);
+
+            caster->set_shadow_signature(0);
+        } else {
+            // The shadow map is the cache (the static map is only needed to remove the dynamic casters).
+            render(caster->fbo(), true, light.static_casters);
+
+            caster->set_shadow_signature(light.static_signature);
         }
+
+        CommandBuffer footer;
+
+        caster->record_update_fbo(footer);
+
+        footer.replay();
     }
+
+    STATS->end_pass();
 }
 
 void pepng::extra::render_objects() {
+    pepng::extra::render_objects(pepng::extra::snapshot());
+}
+
+void pepng::extra::render_objects(std::shared_ptr<RenderSnapshot> snapshot) {
+    PEPNG_PROFILE_SCOPE("Objects");
+
+    glBindFramebuffer(GL_FRAMEBUFFER, RenderTarget::framebuffer());
+
     glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+
+    snapshot->prepare();
+
+    std::vector<GLuint> shaderPrograms;
+
+    for(auto& draw : snapshot->draws) {
+        if(std::find(shaderPrograms.begin(), shaderPrograms.end(), draw.shader_program) == shaderPrograms.end()) {
+            shaderPrograms.push_back(draw.shader_program);
+        }
+    }
+
+    auto materialProgram = [](const DrawItem& draw) { return draw.shader_program; };
+
+    // The draws only depend on the snapshot, so they are recorded once for all cameras (deferred cameras only use the transparent ones).
+    std::vector<CommandBuffer> draws;
+    std::vector<CommandBuffer> transparentDraws;
+    bool isRecorded = false;
+    bool isTransparentRecorded = false;
     
-    for(auto camera : Camera::cameras) {
-        if(camera->active()) {
-            camera->viewport->render(glm::vec2(WINDOW_X, WINDOW_Y));
+    for(auto& camera : snapshot->cameras) {
+        if(!Camera::render_viewport(camera, snapshot->window)) continue;
+
+        PEPNG_PROFILE_GPU_SCOPE("Camera");
+
+        STATS->begin_pass("Camera");
+
+        // Keeps Object::render usable from a custom frame (the render thread never reads it).
+        if(PIPELINE == nullptr) {
+            Camera::current_camera = camera.camera;
+        }
+
+        // The clusters of the capture (the live setting may have changed since).
+        auto clusters = snapshot->clusters;
+
+        if(clusters != nullptr) {
+            PEPNG_PROFILE_SCOPE("Clusters");
+
+            clusters->build(camera, snapshot->lights, JOBS);
+            clusters->upload();
+        }
+
+        // Uniforms are kept per program, so the camera and lights are bound once per shader program.
+        CommandBuffer header;
 
-            Camera::current_camera = camera;
+        for(auto shaderProgram : shaderPrograms) {
+            header.use_program(shaderProgram);
 
-            camera->projection->set_aspect(WINDOW_X / WINDOW_Y);
+            Camera::record(header, camera, shaderProgram);
 
+            for(auto& light : snapshot->lights) {
+                // Shaded by the clusters, so its slot is disabled (it was recorded active if it had shadows or clustering was off).
+                if(clusters != nullptr && LightClusters::is_clustered(light)) {
+                    header.uniform(LightClusters::slot_uniform(light), (GLint) 0);
+
+                    continue;
+                }
+
+                light.light->record(header, light, shaderProgram);
+            }
+
+            if(clusters != nullptr) {
+                clusters->record(header);
+            }
+
+            for(auto& uniform : snapshot->disabled_lights) {
+                header.uniform(uniform, (GLint) 0);
+            }
+        }
+
+        header.replay();
+
+        if(camera.deferred != nullptr) {
+            if(!isTransparentRecorded) {
+                transparentDraws = pepng::record_draws(snapshot->draws, materialProgram, snapshot->opaque_count);
+                isTransparentRecorded = true;
+            }
+
+            camera.deferred->render(snapshot, camera, transparentDraws);
+        } else {
+            if(!isRecorded) {
+                draws = pepng::record_draws(snapshot->draws, materialProgram);
+                isRecorded = true;
+            }
+
+            CommandBuffer::replay(draws);
+        }
+
+        // The custom render hooks read the live objects, so they only run on the main thread (not pipelined).
+        if(PIPELINE == nullptr) {
             for(auto object : WORLD) {
-                object->render();
+                object->render_custom();
             }
         }
+
+        STATS->end_pass(snapshot->culled);
     }
 }
 
 void pepng::extra::render_imgui() {
+    PEPNG_PROFILE_SCOPE("ImGui");
+
     #ifdef IMGUI
-    pepng::imgui_render();
+    if(PIPELINE != nullptr) {
+        pepng::imgui_build();
+
+        pepng::extra::snapshot()->capture_imgui(ImGui::GetDrawData());
+    } else {
+        pepng::imgui_render();
+    }
     #endif
 }
 
+void pepng::extra::render_frame(std::shared_ptr<RenderSnapshot> snapshot) {
+    PEPNG_PROFILE_SCOPE("Render");
+
+    glClearColor(snapshot->background_color.x, snapshot->background_color.y, snapshot->background_color.z, 1.0f);
+
+    pepng::extra::render_shadows(snapshot);
+
+    pepng::extra::render_objects(snapshot);
+
+    #ifdef IMGUI
+    {
+        PEPNG_PROFILE_GPU_SCOPE("ImGui");
+
+        snapshot->render_imgui();
+    }
+    #endif
+
+    pepng::extra::read_back();
+
+    pepng::extra::swap_buffers();
+}
+
+void pepng::extra::read_back() {
+    if(RenderTarget::current_target == nullptr) return;
+
+    {
+        #ifndef EMSCRIPTEN
+        std::lock_guard<std::mutex> lock(READBACK_MUTEX);
+        #endif
+
+        if(!READBACK_REQUESTED) return;
+    }
+
+    std::vector<unsigned char> pixels;
+
+    RenderTarget::current_target->read_pixels(pixels);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, RenderTarget::framebuffer());
+
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(READBACK_MUTEX);
+    #endif
+
+    READBACK_PIXELS.swap(pixels);
+}
+
+void pepng::extra::swap_buffers() {
+    {
+        PEPNG_PROFILE_SCOPE("Swap");
+
+        PACER->apply();
+        PACER->wait();
+
+        glfwSwapBuffers(pepng::window());
+    }
+
+    PACER->present();
+
+    Profiler::current_profiler->end_gpu_frame();
+
+    STATS->end_frame();
+}
+
+void pepng::extra::submit_frame() {
+    if(PIPELINE != nullptr) {
+        PIPELINE->submit(pepng::extra::snapshot());
+    }
+}
+
+void pepng::extra::flush_destroyed() {
+    std::vector<std::shared_ptr<Object>> pending;
+
+    {
+        #ifndef EMSCRIPTEN
+        std::lock_guard<std::mutex> lock(DESTROYED_MUTEX);
+        #endif
+
+        pending.swap(DESTROYED);
+    }
+
+    if(pending.empty()) return;
+
+    PEPNG_PROFILE_SCOPE("Destroy");
+
+    std::unordered_set<Object*> destroyed;
+    std::vector<std::shared_ptr<Object>> nodes;
+
+    for(auto object : pending) {
+        if(destroyed.count(object.get())) continue;
+
+        object->for_each([&destroyed, &nodes](std::shared_ptr<Object> child) {
+            if(destroyed.insert(child.get()).second) nodes.push_back(child);
+        });
+    }
+
+    auto isDestroyed = [&destroyed](const std::shared_ptr<Object>& object) {
+        return destroyed.count(object.get()) > 0;
+    };
+
+    // The world order is not kept (swap and pop), so removing many objects stays linear.
+    for(size_t i = 0; i < WORLD.size();) {
+        if(isDestroyed(WORLD.at(i))) {
+            WORLD.at(i) = WORLD.back();
+            WORLD.pop_back();
+        } else {
+            i++;
+        }
+    }
+
+    for(auto object : WORLD) {
+        object->for_each([&isDestroyed](std::shared_ptr<Object> child) {
+            auto& children = child->children;
+
+            children.erase(std::remove_if(children.begin(), children.end(), isDestroyed), children.end());
+        });
+    }
+
+    for(auto object : nodes) {
+        for(auto component : object->get_components()) {
+            component->destroy(object);
+        }
+    }
+
+    if(CURRENT_IMGUI_OBJECT != nullptr && isDestroyed(CURRENT_IMGUI_OBJECT)) {
+        CURRENT_IMGUI_OBJECT = nullptr;
+    }
+
+    // The objects (and their pooled components) are released with the last reference (e.g. the in-flight snapshot).
+}
+
 void pepng::extra::update_glfw() {
-    glfwSwapBuffers(pepng::window());
+    pepng::extra::flush_destroyed();
+
+    if(PIPELINE == nullptr) {
+        pepng::extra::swap_buffers();
+    }
+
     glfwPollEvents();
+
+    FRAME_INDEX++;
+
+    Profiler::current_profiler->end_frame();
 }
 
 namespace pepng {
     void do_frame() {
         pepng::extra::update_objects();
 
-        pepng::extra::render_shadows();
+        pepng::extra::capture_frame();
+
+        if(pepng::pipelined()) {
+            pepng::extra::render_imgui();
+
+            pepng::extra::submit_frame();
+        } else {
+            pepng::extra::render_shadows();
 
-        pepng::extra::render_objects();
+            pepng::extra::render_objects();
 
-        pepng::extra::render_imgui();
+            pepng::extra::render_imgui();
+        }
 
         pepng::extra::update_glfw();
     }
@@ -282,9 +1094,27 @@ int pepng::update(void (*do_frame)()) {
     #ifdef EMSCRIPTEN
         emscripten_set_main_loop(do_frame, 0, 1);
     #else
-        while(!glfwWindowShouldClose(WINDOW)) {
+        if(PIPELINED) {
+            #ifdef IMGUI
+            // Creates the ImGui device objects while the context is still current on this thread.
+            ImGui_ImplOpenGL3_NewFrame();
+            #endif
+
+            PIPELINE = pepng::make_frame_pipeline(WINDOW, PIPELINE_LATENCY, pepng::extra::render_frame);
+        }
+
+        while(!glfwWindowShouldClose(WINDOW) && (FRAME_LIMIT == 0 || FRAME_INDEX < FRAME_LIMIT)) {
             (*do_frame)();
         }
+
+        if(PIPELINE != nullptr) {
+            PIPELINE->stop();
+
+            PIPELINE = nullptr;
+
+            READBACK_REQUESTED = false;
+            READBACK_PIXELS.clear();
+        }
     #endif
 
     glfwTerminate();
@@ -9,6 +9,9 @@
 #include <stdlib.h>
 #include <time.h>
 #include <sstream>
+#include <cmath>
+#include <functional>
+#include <cstdint>
 
 #ifdef EMSCRIPTEN
     #include <emscripten.h>
@@ -25,8 +28,22 @@
     #include <imgui_impl_glfw.h>
 #endif
 
+#include "jobs.hpp"
+#include "pacer.hpp"
+#include "profiler.hpp"
+#include "stats.hpp"
+#include "../util/memory.hpp"
+#include "snapshot.hpp"
+#include "clusters.hpp"
+#include "deferred.hpp"
+#include "shadows.hpp"
+#include "atlas.hpp"
+#include "shadow_array.hpp"
+#include "../gl/command_buffer.hpp"
+#include "../gl/render_target.hpp"
 #include "../io/io.hpp"
 #include "../object/object.hpp"
+#include "../object/prefab.hpp"
 
 namespace pepng {
     /**
@@ -34,6 +51,39 @@ namespace pepng {
      */
     bool init(const char *title, float width, float height);
 
+    /**
+     * Initializes pepng without a visible window (the frames are rendered into a RenderTarget of the given size).
+     * 
+     * With the HEADLESS build option, the context is created with OSMesa so no display is needed.
+     */
+    bool init_headless(float width, float height);
+
+    /**
+     * Is pepng rendering offscreen?
+     */
+    bool headless();
+
+    /**
+     * Reads the last rendered frame as RGBA rows, top row first.
+     * 
+     * When pipelined, the update thread cannot touch the context: the first call requests the render thread to read back
+     * every frame it draws (see pepng::extra::read_back) and the calls return the last frame read, one frame or more behind the update.
+     * Otherwise it must be called from the OpenGL thread, during the update.
+     * 
+     * @return False if there is no frame to read (the window is only readable when headless, and the first pipelined call has none yet).
+     */
+    bool read_frame(std::vector<unsigned char>& pixels);
+
+    /**
+     * Stops the update after a number of frames (0 runs until the window closes).
+     */
+    void set_frame_limit(unsigned long frames);
+
+    /**
+     * Accessor for the number of frames since the update started.
+     */
+    unsigned long frame_index();
+
     /**
      * Renders and update pepng until program close/failure.
      * 
@@ -80,6 +130,143 @@ namespace pepng {
      */
     void instantiate(std::shared_ptr<Object> object);
 
+    /**
+     * Removes the object (with its children) from the world at the end of the frame.
+     * 
+     * The lights and cameras of the removed objects are unregistered (see Component::destroy).
+     * Safe to call from Component::update (the object stays valid until the end of the frame).
+     */
+    void destroy(std::shared_ptr<Object> object);
+
+    /**
+     * Enables the parallel update (the objects of a depth are updated on the job system, see Object::update_parallel).
+     * 
+     * Components that are not Component::parallel_safe are updated on the main thread, before the parallel safe ones of the same depth.
+     */
+    void set_parallel_update(bool parallelUpdate);
+
+    /**
+     * Enables the light culling (default true).
+     * 
+     * Every draw gets the list of the lights whose range reaches its bounds (see Renderer::assign_lights),
+     * so shaders iterating the lists only pay for the nearby lights. Disabled, the lists hold the MAX_DRAW_LIGHTS strongest
+     * active lights of each type (the others are dropped, whatever their range).
+     * Either way, the lights are assigned to every draw at each capture (draws x lights tests per frame).
+     */
+    void set_light_culling(bool lightCulling);
+
+    /**
+     * Enables the clustered lighting (default false, needs to be called before the lights are created).
+     * 
+     * The active point lights and spotlights without shadows are assigned to the clusters of every camera (see LightClusters)
+     * instead of their u_pointlights/u_spotlights slots and the draw light lists, so the number of these lights is not limited by the shader arrays.
+     * The lights with shadows keep their slots. Not available on EMSCRIPTEN (no texture buffers).
+     * The clusters take 3 texture units after the shadow map units of the existing lights.
+     * The setting is captured with the frame (see RenderSnapshot::clusters), so it can be switched while pipelined.
+     */
+    void set_clustered_lighting(bool clusteredLighting);
+
+    /**
+     * Limits the shadow map faces rendered per frame (a point light counts 6, a spotlight 1, default 0 renders every light).
+     *
+     * The lights over the budget keep their last shadow map (see ShadowScheduler), the budget can be tuned in the Shadows window.
+     */
+    void set_shadow_budget(int faces);
+
+    /**
+     * Renders the spotlight shadow maps into a shared atlas (default off, needs to be called before the spotlights are initialized).
+     *
+     * Each frame, the spotlights with shadows get a tile sized by their screen influence (see ShadowAtlas), so the shadow maps
+     * take a single texture and texture unit whatever the number of spotlights. Spotlights that do not fit lose their shadows for the frame.
+     *
+     * @param size The atlas width and height in texels (a power of 2).
+     * @throw If the render thread is running (pipelined, the lights initialized on it read the atlas).
+     */
+    void set_shadow_atlas(int size = 4096);
+
+    /**
+     * Puts the point light shadow maps in a cube map array, and the spotlight ones in a 2D array without atlas
+     * (default false, needs to be called after the initialization and before the lights are created).
+     *
+     * The layers are indexed by the light slot, so the shaders sample u_point_shadow_array (samplerCubeArray) and
+     * u_spot_shadow_array (sampler2DArray) with the index in u_pointlights/u_spotlights instead of u_point_shadows/u_spot_shadows:
+     * a single bind per type, and the lights take no texture unit of their own (see ShadowArray).
+     * The lights render directly into their layer, so the point shadow geometry shader must write gl_Layer = u_shadow_layer + face.
+     * The light count is still limited by the size of the u_pointlights/u_spotlights arrays in the shaders.
+     * Not available on EMSCRIPTEN (no cube map arrays).
+     *
+     * @throw If cube map arrays are not supported (OpenGL 4.0 or ARB_texture_cube_map_array).
+     * @throw If the render thread is running (pipelined, the lights initialized on it read the arrays).
+     */
+    void set_shadow_arrays(bool shadowArrays);
+
+    /**
+     * Enables the pipelined frame (needs to be called before the update).
+     * 
+     * The update produces a RenderSnapshot that a render thread (owning the OpenGL context) renders while the next update runs.
+     * Component::render is not called in this mode (only Renderer components are captured):
+     * otherwise the frame calls it for the other components after the snapshot draws of each camera (see Object::render_custom).
+     * 
+     * @param latency The number of frames that the update can be ahead of the render thread.
+     */
+    void set_pipelined(bool pipelined, int latency = 1);
+
+    /**
+     * Is the pipelined frame running?
+     */
+    bool pipelined();
+
+    /**
+     * Enables the fixed timestep update (the objects are updated at a constant rate, independent of the frame rate).
+     * 
+     * Rendering interpolates the transforms between the last two updates.
+     * The Component::per_frame components (the input driven ones) still update once per frame, before the steps.
+     * 
+     * @param hz The update rate (0 updates once per frame).
+     * @param maxSteps The maximum number of updates per frame (extra time is dropped to avoid a spiral of death).
+     */
+    void set_fixed_timestep(float hz, int maxSteps = 5);
+
+    /**
+     * Sets the number of screen updates between buffer swaps (0 disables vsync, -1 is adaptive vsync where available).
+     */
+    void set_swap_interval(int swapInterval);
+
+    /**
+     * Caps the frame rate (0 is uncapped).
+     */
+    void set_target_fps(float targetFps);
+
+    /**
+     * Accessor for the frame pacer.
+     */
+    std::shared_ptr<FramePacer> pacer();
+
+    /**
+     * Enables the profiler zones (see PEPNG_PROFILE_SCOPE).
+     */
+    void set_profiling(bool profiling);
+
+    /**
+     * Accessor for the profiler (Profiler::current_profiler).
+     */
+    std::shared_ptr<Profiler> profiler();
+
+    /**
+     * Accessor for the per-frame rendering statistics (draw calls, binds, uploads and shadow maps).
+     */
+    std::shared_ptr<RenderStats> render_stats();
+
+    /**
+     * Accessor for the update delta time in seconds (see Component::delta_time).
+     */
+    float delta_time();
+
+    /**
+     * Accessor for the interpolation factor between the last two updates (1 without a fixed timestep).
+     */
+    float interpolation_alpha();
+
     /**
      * Accessor for window.
      */
@@ -90,6 +277,30 @@ namespace pepng {
      */
     std::vector<std::shared_ptr<Object>> world();
 
+    /**
+     * Accessor for the job system.
+     */
+    std::shared_ptr<JobSystem> jobs();
+
+    /**
+     * Records the draws into CommandBuffers on the job system (in chunks, so each buffer is recorded by one job).
+     *
+     * The buffers must be replayed in order on the OpenGL thread.
+     * 
+     * @param shaderProgram The shader program used for a draw.
+     * @param first The index of the first recorded draw.
+     * @param last The index after the last recorded draw (clamped to the number of draws).
+     */
+    std::vector<CommandBuffer> record_draws(const std::vector<DrawItem>& draws, std::function<GLuint(const DrawItem&)> shaderProgram, size_t first = 0, size_t last = SIZE_MAX);
+
+    /**
+     * Records a subset of the draws (see pepng::record_draws).
+     *
+     * @param indices The indices of the recorded draws (e.g. LightState::static_casters).
+     * @param uniforms Records extra uniforms before each draw (its program is in use, e.g. Light::record_caster).
+     */
+    std::vector<CommandBuffer> record_draws(const std::vector<DrawItem>& draws, const std::vector<size_t>& indices, std::function<GLuint(const DrawItem&)> shaderProgram, std::function<void(CommandBuffer&, const DrawItem&)> uniforms = nullptr);
+
     /**
      * Accessor for input.
      */
@@ -108,24 +319,83 @@ namespace pepng {
     namespace extra {
         /**
          * Method called in frame loop for updating objects.
+         * 
+         * Runs the fixed timestep updates (see pepng::set_fixed_timestep) or a single update with the frame time.
          */
         void update_objects();
 
+        /**
+         * Updates the objects once with the current delta time.
+         * 
+         * Uses the job system if the parallel update is enabled.
+         */
+        void update_step();
+
+        /**
+         * Method called in frame loop for capturing the updated world into a RenderSnapshot.
+         */
+        void capture_frame();
+
+        /**
+         * Accessor for the current frame snapshot (captured if the frame has no snapshot yet).
+         */
+        std::shared_ptr<RenderSnapshot> snapshot();
+
         /**
          * Method called in frame loop for rendering shadows.
          */
         void render_shadows();
 
+        /**
+         * Renders the shadows of a snapshot.
+         *
+         * The static casters are cached per light (see Renderer::is_static): a light without dynamic casters in range
+         * is skipped until it or a static caster in range moves, otherwise its dynamic casters are drawn over the cached map.
+         */
+        void render_shadows(std::shared_ptr<RenderSnapshot> snapshot);
+
         /**
          * Method called in frame loop for rendering objects.
          */
         void render_objects();
 
+        /**
+         * Renders the cameras of a snapshot.
+         */
+        void render_objects(std::shared_ptr<RenderSnapshot> snapshot);
+
         /**
          * Method called in frame loop for rendering IMGUI.
+         * 
+         * When pipelined, the ImGui draw data is copied into the snapshot instead.
          */
         void render_imgui();
 
+        /**
+         * Renders a complete snapshot and swaps the buffers (on the render thread when pipelined).
+         */
+        void render_frame(std::shared_ptr<RenderSnapshot> snapshot);
+
+        /**
+         * Reads the frame back for pepng::read_frame, once requested (render thread, pipelined only).
+         */
+        void read_back();
+
+        /**
+         * Paces and swaps the window buffers (must be called from the context thread).
+         */
+        void swap_buffers();
+
+        /**
+         * Method called in frame loop for sending the snapshot to the render thread (pipelined only).
+         */
+        void submit_frame();
+
+        /**
+         * Removes the objects passed to pepng::destroy (called by update_glfw).
+         */
+        void flush_destroyed();
+
         /**
          * Method called in frame loop for updating GLFW.
          */
@@ -0,0 +1,123 @@
+#include "pipeline.hpp"
+#include "profiler.hpp"
+
+FramePipeline::FramePipeline(GLFWwindow* window, int latency, std::function<void(std::shared_ptr<RenderSnapshot>)> render) :
+    __window(window),
+    __latency(latency < 1 ? 1 : latency),
+    __render(render)
+    #ifndef EMSCRIPTEN
+    , __error(nullptr),
+    __stopping(false)
+    #endif
+{}
+
+FramePipeline::~FramePipeline() {
+    this->stop();
+}
+
+std::shared_ptr<FramePipeline> FramePipeline::make_frame_pipeline(
+    GLFWwindow* window,
+    int latency,
+    std::function<void(std::shared_ptr<RenderSnapshot>)> render
+) {
+    std::shared_ptr<FramePipeline> pipeline(new FramePipeline(window, latency, render));
+
+    #ifndef EMSCRIPTEN
+        glfwMakeContextCurrent(nullptr);
+
+        pipeline->__render_thread = std::thread(&FramePipeline::run, pipeline.get());
+    #endif
+
+    return pipeline;
+}
+
+std::shared_ptr<FramePipeline> pepng::make_frame_pipeline(
+    GLFWwindow* window,
+    int latency,
+    std::function<void(std::shared_ptr<RenderSnapshot>)> render
+) {
+    return FramePipeline::make_frame_pipeline(window, latency, render);
+}
+
+void FramePipeline::submit(std::shared_ptr<RenderSnapshot> snapshot) {
+    #ifdef EMSCRIPTEN
+        this->__render(snapshot);
+    #else
+        std::unique_lock<std::mutex> lock(this->__mutex);
+
+        this->__condition.wait(lock, [this]() {
+            return (int) this->__frames.size() < this->__latency || this->__error || this->__stopping;
+        });
+
+        if(this->__error) {
+            auto error = this->__error;
+
+            this->__error = nullptr;
+
+            std::rethrow_exception(error);
+        }
+
+        if(this->__stopping) return;
+
+        this->__frames.push_back(snapshot);
+
+        lock.unlock();
+
+        this->__condition.notify_all();
+    #endif
+}
+
+void FramePipeline::stop() {
+    #ifndef EMSCRIPTEN
+    if(!this->__render_thread.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(this->__mutex);
+
+        this->__stopping = true;
+    }
+
+    this->__condition.notify_all();
+
+    this->__render_thread.join();
+
+    glfwMakeContextCurrent(this->__window);
+    #endif
+}
+
+#ifndef EMSCRIPTEN
+void FramePipeline::run() {
+    PEPNG_PROFILE_THREAD("Render");
+
+    glfwMakeContextCurrent(this->__window);
+
+    while(true) {
+        std::shared_ptr<RenderSnapshot> snapshot;
+
+        {
+            std::unique_lock<std::mutex> lock(this->__mutex);
+
+            this->__condition.wait(lock, [this]() { return this->__stopping || !this->__frames.empty(); });
+
+            if(this->__frames.empty()) break;
+
+            snapshot = this->__frames.front();
+
+            this->__frames.pop_front();
+        }
+
+        this->__condition.notify_all();
+
+        try {
+            this->__render(snapshot);
+        } catch(...) {
+            std::lock_guard<std::mutex> lock(this->__mutex);
+
+            this->__error = std::current_exception();
+            this->__frames.clear();
+        }
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
+#endif
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <memory>
+#include <functional>
+#include <exception>
+
+#ifndef EMSCRIPTEN
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#endif
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "snapshot.hpp"
+
+/**
+ * Dedicated render thread that owns the OpenGL context and consumes RenderSnapshots.
+ *
+ * While the render thread submits frame N, the main thread is free to update frame N + 1.
+ */
+class FramePipeline {
+    public:
+        /**
+         * Shared_ptr constructor for FramePipeline.
+         *
+         * The window context is moved to the render thread (it must be current on the calling thread).
+         *
+         * @param latency The number of frames that can be queued before submit blocks.
+         * @param render Renders a snapshot (called on the render thread).
+         */
+        static std::shared_ptr<FramePipeline> make_frame_pipeline(
+            GLFWwindow* window,
+            int latency,
+            std::function<void(std::shared_ptr<RenderSnapshot>)> render
+        );
+
+        /**
+         * Stops the render thread (see FramePipeline::stop).
+         */
+        ~FramePipeline();
+
+        /**
+         * Queues a snapshot for the render thread.
+         *
+         * Blocks while `latency` frames are already queued.
+         *
+         * @throw If the render thread failed.
+         */
+        void submit(std::shared_ptr<RenderSnapshot> snapshot);
+
+        /**
+         * Renders the queued frames, joins the render thread and makes the context current on the calling thread.
+         */
+        void stop();
+
+        /**
+         * Accessor for latency.
+         */
+        inline int latency() { return this->__latency; }
+
+    private:
+        FramePipeline(GLFWwindow* window, int latency, std::function<void(std::shared_ptr<RenderSnapshot>)> render);
+
+        /**
+         * The window that owns the context.
+         */
+        GLFWwindow* __window;
+
+        /**
+         * Maximum number of queued frames.
+         */
+        int __latency;
+
+        /**
+         * Snapshot render method.
+         */
+        std::function<void(std::shared_ptr<RenderSnapshot>)> __render;
+
+        #ifndef EMSCRIPTEN
+        /**
+         * Render thread loop.
+         */
+        void run();
+
+        std::thread __render_thread;
+
+        std::mutex __mutex;
+
+        std::condition_variable __condition;
+
+        /**
+         * Frames waiting for the render thread.
+         */
+        std::deque<std::shared_ptr<RenderSnapshot>> __frames;
+
+        /**
+         * Exception thrown on the render thread.
+         */
+        std::exception_ptr __error;
+
+        bool __stopping;
+        #endif
+};
+
+namespace pepng {
+    std::shared_ptr<FramePipeline> make_frame_pipeline(
+        GLFWwindow* window,
+        int latency,
+        std::function<void(std::shared_ptr<RenderSnapshot>)> render
+    );
+}
@@ -0,0 +1,545 @@
+#include "profiler.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <algorithm>
+#include <functional>
+
+std::shared_ptr<Profiler> Profiler::current_profiler = Profiler::make_profiler();
+
+namespace {
+    /**
+     * The zones of the calling thread (and the profiler they belong to).
+     */
+    thread_local void* THREAD_ZONES = nullptr;
+    thread_local Profiler* THREAD_PROFILER = nullptr;
+
+    /**
+     * Runs a callback when the thread exits.
+     */
+    struct ThreadExit {
+        std::function<void()> callback;
+
+        ~ThreadExit() {
+            if(this->callback) this->callback();
+        }
+    };
+
+    thread_local ThreadExit THREAD_EXIT;
+
+    std::string json_escape(const std::string& value) {
+        std::stringstream ss;
+
+        for(auto c : value) {
+            if(c == '"' || c == '\\') {
+                ss << '\\' << c;
+            } else if((unsigned char) c < 0x20) {
+                ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int) c << std::dec;
+            } else {
+                ss << c;
+            }
+        }
+
+        return ss.str();
+    }
+}
+
+Profiler::Profiler() :
+    __enabled(false),
+    __capturing(false),
+    __begin(std::chrono::steady_clock::now()),
+    __thread_count(0),
+    __frame_start(0.0),
+    __gpu_frames(Profiler::GPU_LATENCY),
+    __gpu_frame(0),
+    __gpu_supported(-1),
+    __gpu_dropped(0)
+    #ifdef IMGUI
+    , __paused(false),
+    __trace_path("profile.json")
+    #endif
+{
+    for(auto& frame : this->__gpu_frames) {
+        frame.used = 0;
+        frame.issued = 0.0;
+    }
+}
+
+std::shared_ptr<Profiler> Profiler::make_profiler() {
+    std::shared_ptr<Profiler> profiler(new Profiler());
+
+    return profiler;
+}
+
+std::shared_ptr<Profiler> pepng::make_profiler() {
+    return Profiler::make_profiler();
+}
+
+const char* Profiler::intern(const std::string& name) {
+    static std::set<std::string> names;
+
+    #ifndef EMSCRIPTEN
+    static std::mutex mutex;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    #endif
+
+    // Set nodes are stable, so the pointer stays valid.
+    return names.insert(name).first->c_str();
+}
+
+void Profiler::set_thread_name(const std::string& name) {
+    if(Profiler::current_profiler == nullptr) return;
+
+    auto& zones = Profiler::current_profiler->thread_zones();
+
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(zones.mutex);
+    #endif
+
+    zones.name = name;
+}
+
+double Profiler::now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - this->__begin).count();
+}
+
+Profiler::ThreadZones& Profiler::thread_zones() {
+    if(THREAD_PROFILER != this) {
+        auto zones = std::make_shared<ThreadZones>();
+
+        #ifndef EMSCRIPTEN
+        std::lock_guard<std::mutex> lock(this->__mutex);
+        #endif
+
+        zones->id = ++this->__thread_count;
+        zones->finished = false;
+
+        std::stringstream ss;
+
+        ss << "Thread " << zones->id;
+
+        zones->name = ss.str();
+
+        this->__threads.push_back(zones);
+
+        THREAD_ZONES = zones.get();
+        THREAD_PROFILER = this;
+        THREAD_EXIT.callback = [zones]() { zones->finished = true; };
+    }
+
+    return *((ThreadZones*) THREAD_ZONES);
+}
+
+void Profiler::begin_zone(const char* name) {
+    auto& zones = this->thread_zones();
+
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(zones.mutex);
+    #endif
+
+    zones.stack.push_back(zones.zones.size());
+    zones.zones.push_back({ name, this->now(), -1.0, (unsigned int) zones.stack.size() - 1, zones.id });
+}
+
+void Profiler::end_zone() {
+    auto& zones = this->thread_zones();
+
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(zones.mutex);
+    #endif
+
+    // The profiler was enabled inside the zone.
+    if(zones.stack.empty()) return;
+
+    zones.zones.at(zones.stack.back()).end = this->now();
+    zones.stack.pop_back();
+}
+
+size_t Profiler::gpu_timestamp() {
+    auto& frame = this->__gpu_frames.at(this->__gpu_frame);
+
+    if(frame.used == frame.queries.size()) {
+        GLuint query;
+
+        glGenQueries(1, &query);
+
+        frame.queries.push_back(query);
+    }
+
+    if(frame.used == 0) {
+        frame.issued = this->now();
+    }
+
+    #ifndef EMSCRIPTEN
+    glQueryCounter(frame.queries.at(frame.used), GL_TIMESTAMP);
+    #endif
+
+    return frame.used++;
+}
+
+void Profiler::begin_gpu_zone(const char* name) {
+    if(this->__gpu_supported < 0) {
+        #ifdef EMSCRIPTEN
+            this->__gpu_supported = 0;
+        #else
+            this->__gpu_supported = GLEW_ARB_timer_query || GLEW_VERSION_3_3;
+        #endif
+    }
+
+    if(!this->__gpu_supported) return;
+
+    auto& frame = this->__gpu_frames.at(this->__gpu_frame);
+
+    this->__gpu_stack.push_back(frame.zones.size());
+
+    frame.zones.push_back({ name, (double) this->gpu_timestamp(), -1.0, (unsigned int) this->__gpu_stack.size() - 1, Profiler::GPU_THREAD });
+}
+
+void Profiler::end_gpu_zone() {
+    if(this->__gpu_supported <= 0 || this->__gpu_stack.empty()) return;
+
+    auto& frame = this->__gpu_frames.at(this->__gpu_frame);
+
+    frame.zones.at(this->__gpu_stack.back()).end = (double) this->gpu_timestamp();
+
+    this->__gpu_stack.pop_back();
+}
+
+void Profiler::resolve(GpuFrame& frame) {
+    if(frame.used == 0) return;
+
+    std::vector<ProfileZone> zones;
+
+    #ifndef EMSCRIPTEN
+    GLint available = 0;
+
+    glGetQueryObjectiv(frame.queries.at(frame.used - 1), GL_QUERY_RESULT_AVAILABLE, &available);
+
+    if(!available) {
+        this->__gpu_dropped++;
+    } else {
+        std::vector<GLuint64> timestamps(frame.used);
+
+        for(size_t i = 0; i < frame.used; i++) {
+            glGetQueryObjectui64v(frame.queries.at(i), GL_QUERY_RESULT, &timestamps.at(i));
+        }
+
+        for(auto zone : frame.zones) {
+            if(zone.end < 0.0) continue;
+
+            zone.start = frame.issued + (timestamps.at((size_t) zone.start) - timestamps.front()) / 1.0e9;
+            zone.end = frame.issued + (timestamps.at((size_t) zone.end) - timestamps.front()) / 1.0e9;
+
+            zones.push_back(zone);
+        }
+    }
+    #endif
+
+    frame.used = 0;
+    frame.zones.clear();
+
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__mutex);
+    #endif
+
+    this->__gpu_zones.insert(this->__gpu_zones.end(), zones.begin(), zones.end());
+}
+
+void Profiler::end_gpu_frame() {
+    if(this->__gpu_supported <= 0) return;
+
+    // Zones left open are dropped with the frame.
+    this->__gpu_stack.clear();
+
+    this->__gpu_frame = (this->__gpu_frame + 1) % Profiler::GPU_LATENCY;
+
+    this->resolve(this->__gpu_frames.at(this->__gpu_frame));
+}
+
+void Profiler::record(const std::vector<ProfileZone>& zones) {
+    if(!this->__capturing) return;
+
+    this->__capture.insert(this->__capture.end(), zones.begin(), zones.end());
+
+    if(this->__capture.size() >= Profiler::MAX_CAPTURE) {
+        this->__capturing = false;
+    }
+}
+
+void Profiler::end_frame() {
+    ProfileFrame frame;
+
+    frame.start = this->__frame_start;
+    frame.end = this->now();
+
+    this->__frame_start = frame.end;
+
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__mutex);
+    #endif
+
+    for(auto& thread : this->__threads) {
+        #ifndef EMSCRIPTEN
+        std::lock_guard<std::mutex> threadLock(thread->mutex);
+        #endif
+
+        // The open zones stay (they are completed in a later frame).
+        std::vector<ProfileZone> open;
+
+        for(auto& index : thread->stack) {
+            open.push_back(thread->zones.at(index));
+
+            index = open.size() - 1;
+        }
+
+        for(auto& zone : thread->zones) {
+            if(zone.end >= 0.0) {
+                frame.zones.push_back(zone);
+            }
+        }
+
+        thread->zones = open;
+    }
+
+    // Short lived threads (loaders, async tasks) would otherwise accumulate.
+    this->__threads.erase(std::remove_if(this->__threads.begin(), this->__threads.end(), [](const std::shared_ptr<ThreadZones>& thread) {
+        return thread->finished && thread->zones.empty();
+    }), this->__threads.end());
+
+    frame.zones.insert(frame.zones.end(), this->__gpu_zones.begin(), this->__gpu_zones.end());
+
+    this->__gpu_zones.clear();
+
+    if(frame.zones.empty() && !this->__enabled) return;
+
+    this->record(frame.zones);
+
+    this->__history.push_back(std::move(frame));
+
+    if(this->__history.size() > Profiler::HISTORY) {
+        this->__history.pop_front();
+    }
+}
+
+std::vector<ProfileFrame> Profiler::history() {
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__mutex);
+    #endif
+
+    return std::vector<ProfileFrame>(this->__history.begin(), this->__history.end());
+}
+
+void Profiler::start_capture() {
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__mutex);
+    #endif
+
+    this->__capture.clear();
+    this->__capturing = true;
+}
+
+void Profiler::stop_capture() {
+    this->__capturing = false;
+}
+
+void Profiler::export_trace(const std::filesystem::path& filePath) {
+    std::vector<ProfileZone> zones;
+    std::map<unsigned int, std::string> names;
+
+    {
+        #ifndef EMSCRIPTEN
+        std::lock_guard<std::mutex> lock(this->__mutex);
+        #endif
+
+        zones = this->__capture;
+
+        if(zones.empty()) {
+            for(auto& frame : this->__history) {
+                zones.insert(zones.end(), frame.zones.begin(), frame.zones.end());
+            }
+        }
+
+        for(auto& thread : this->__threads) {
+            #ifndef EMSCRIPTEN
+            std::lock_guard<std::mutex> threadLock(thread->mutex);
+            #endif
+
+            names[thread->id] = thread->name;
+        }
+    }
+
+    names[Profiler::GPU_THREAD] = "GPU";
+
+    std::ofstream file(filePath);
+
+    if(!file) {
+        std::stringstream ss;
+
+        ss << "Cannot write trace: " << filePath.string();
+
+        std::cout << ss.str() << std::endl;
+
+        throw std::runtime_error(ss.str());
+    }
+
+    file << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+
+    for(auto& [id, name] : names) {
+        file << (first ? "" : ",\n")
+             << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << id
+             << ",\"args\":{\"name\":\"" << json_escape(name) << "\"}}";
+
+        first = false;
+    }
+
+    for(auto& zone : zones) {
+        file << ",\n{\"name\":\"" << json_escape(zone.name)
+             << "\",\"cat\":\"" << (zone.thread == Profiler::GPU_THREAD ? "gpu" : "cpu")
+             << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << zone.thread
+             << ",\"ts\":" << zone.start * 1.0e6
+             << ",\"dur\":" << (zone.end - zone.start) * 1.0e6 << "}";
+    }
+
+    file << "\n]}" << std::endl;
+}
+
+#ifdef IMGUI
+void Profiler::imgui() {
+    bool enabled = this->__enabled;
+
+    if(ImGui::Checkbox("Enabled", &enabled)) {
+        this->set_enabled(enabled);
+    }
+
+    #ifndef PROFILER
+    ImGui::Text("Built without PROFILER (only manual zones are recorded).");
+    #endif
+
+    ImGui::SameLine();
+
+    if(ImGui::Checkbox("Pause", &this->__paused) && this->__paused) {
+        this->__paused_history = this->history();
+    }
+
+    if(this->__capturing) {
+        if(ImGui::Button("Stop Capture")) {
+            this->stop_capture();
+        }
+
+        size_t captured;
+
+        {
+            #ifndef EMSCRIPTEN
+            std::lock_guard<std::mutex> lock(this->__mutex);
+            #endif
+
+            captured = this->__capture.size();
+        }
+
+        ImGui::SameLine();
+
+        ImGui::Text("%zu zones", captured);
+    } else if(ImGui::Button("Start Capture")) {
+        this->start_capture();
+    }
+
+    ImGui::InputText("Trace", this->__trace_path, sizeof(this->__trace_path));
+
+    ImGui::SameLine();
+
+    if(ImGui::Button("Export")) {
+        try {
+            this->export_trace(this->__trace_path);
+
+            this->__status = std::string("Wrote ") + this->__trace_path;
+        } catch(const std::exception& e) {
+            this->__status = e.what();
+        }
+    }
+
+    if(!this->__status.empty()) {
+        ImGui::Text("%s", this->__status.c_str());
+    }
+
+    if(this->__gpu_supported == 0) {
+        ImGui::Text("GPU timestamp queries are not supported.");
+    } else if(this->__gpu_dropped > 0) {
+        ImGui::Text("GPU frames dropped (late results): %zu", this->__gpu_dropped);
+    }
+
+    auto history = this->__paused ? this->__paused_history : this->history();
+
+    if(history.empty()) return;
+
+    // Averages by thread and zone name over the history.
+    std::map<std::pair<unsigned int, std::string>, double> totals;
+
+    for(auto& frame : history) {
+        for(auto& zone : frame.zones) {
+            totals[{ zone.thread, zone.name }] += zone.end - zone.start;
+        }
+    }
+
+    auto& last = history.back();
+    auto zones = last.zones;
+
+    std::stable_sort(zones.begin(), zones.end(), [](const ProfileZone& a, const ProfileZone& b) {
+        return a.thread != b.thread ? a.thread < b.thread : a.start < b.start;
+    });
+
+    std::map<unsigned int, std::string> names;
+
+    {
+        #ifndef EMSCRIPTEN
+        std::lock_guard<std::mutex> lock(this->__mutex);
+        #endif
+
+        for(auto& thread : this->__threads) {
+            names[thread->id] = thread->name;
+        }
+    }
+
+    names[Profiler::GPU_THREAD] = "GPU";
+
+    ImGui::Text("Frame: %.2f ms", (last.end - last.start) * 1000.0);
+
+    ImGui::Separator();
+
+    ImGui::Columns(3);
+    ImGui::Text("Zone");
+    ImGui::NextColumn();
+    ImGui::Text("Last (ms)");
+    ImGui::NextColumn();
+    ImGui::Text("Average (ms)");
+    ImGui::NextColumn();
+    ImGui::Separator();
+
+    unsigned int thread = (unsigned int) -1;
+
+    for(auto& zone : zones) {
+        if(zone.thread != thread) {
+            thread = zone.thread;
+
+            ImGui::TextColored(ImVec4(0.6f, 0.8f, 1.0f, 1.0f), "%s", names[thread].c_str());
+            ImGui::NextColumn();
+            ImGui::NextColumn();
+            ImGui::NextColumn();
+        }
+
+        ImGui::Text("%*s%s", (int) (zone.depth + 1) * 2, "", zone.name);
+        ImGui::NextColumn();
+        ImGui::Text("%.3f", (zone.end - zone.start) * 1000.0);
+        ImGui::NextColumn();
+        ImGui::Text("%.3f", totals[{ zone.thread, zone.name }] / history.size() * 1000.0);
+        ImGui::NextColumn();
+    }
+
+    ImGui::Columns(1);
+}
+#endif
@@ -0,0 +1,364 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <set>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+
+#ifndef EMSCRIPTEN
+#include <mutex>
+#endif
+
+#include <GL/glew.h>
+
+#ifdef IMGUI
+#include <imgui.h>
+#include "../ui/with_imgui.hpp"
+#endif
+
+/**
+ * A timed zone (times are in seconds since the profiler was created).
+ */
+struct ProfileZone {
+    /**
+     * The zone name (string literal or Profiler::intern).
+     */
+    const char* name;
+
+    double start;
+
+    double end;
+
+    /**
+     * The number of enclosing zones on the same thread.
+     */
+    unsigned int depth;
+
+    /**
+     * The profiler thread id (Profiler::GPU_THREAD for the GPU zones).
+     */
+    unsigned int thread;
+};
+
+/**
+ * The zones that completed during a frame.
+ */
+struct ProfileFrame {
+    double start;
+
+    double end;
+
+    std::vector<ProfileZone> zones;
+};
+
+/**
+ * Hierarchical CPU and GPU zone profiler.
+ *
+ * CPU zones can be opened from any thread (each thread records into its own buffer).
+ * GPU zones use timestamp queries, so they must be opened from the thread that owns the context.
+ * The results are read a few frames later to avoid stalling, and are placed on the CPU timeline
+ * by aligning the first query of a frame with the time it was issued.
+ */
+class Profiler
+    #ifdef IMGUI
+    : public WithImGui
+    #endif
+{
+    public:
+        /**
+         * Number of frames kept for the ImGui window.
+         */
+        static const size_t HISTORY = 120;
+
+        /**
+         * Number of frames the GPU queries are kept before being read.
+         */
+        static const size_t GPU_LATENCY = 4;
+
+        /**
+         * Maximum number of zones kept by a capture (the capture stops when reached).
+         */
+        static const size_t MAX_CAPTURE = 1 << 20;
+
+        /**
+         * The thread id used for the GPU zones.
+         */
+        static constexpr unsigned int GPU_THREAD = 0;
+
+        /**
+         * The profiler used by the PEPNG_PROFILE macros.
+         */
+        static std::shared_ptr<Profiler> current_profiler;
+
+        /**
+         * Shared_ptr constructor for Profiler.
+         */
+        static std::shared_ptr<Profiler> make_profiler();
+
+        /**
+         * Returns a pointer to a copy of the name that lives as long as the program (for generated zone names).
+         */
+        static const char* intern(const std::string& name);
+
+        /**
+         * Names the calling thread in the profiler.
+         */
+        static void set_thread_name(const std::string& name);
+
+        /**
+         * Mutator for enabled (disabled zones only cost a flag check).
+         */
+        inline void set_enabled(bool enabled) { this->__enabled = enabled; }
+
+        /**
+         * Accessor for enabled.
+         */
+        inline bool enabled() { return this->__enabled; }
+
+        /**
+         * Opens a CPU zone on the calling thread.
+         */
+        void begin_zone(const char* name);
+
+        /**
+         * Closes the last CPU zone of the calling thread.
+         */
+        void end_zone();
+
+        /**
+         * Opens a GPU zone (must be called from the context thread).
+         */
+        void begin_gpu_zone(const char* name);
+
+        /**
+         * Closes the last GPU zone.
+         */
+        void end_gpu_zone();
+
+        /**
+         * Collects the completed zones of all threads into a frame (called once per update).
+         */
+        void end_frame();
+
+        /**
+         * Reads the GPU queries that are old enough (called after the buffer swap, from the context thread).
+         */
+        void end_gpu_frame();
+
+        /**
+         * Copies the last frames (oldest first).
+         */
+        std::vector<ProfileFrame> history();
+
+        /**
+         * Starts recording every zone until stop_capture (clears the previous capture).
+         */
+        void start_capture();
+
+        void stop_capture();
+
+        inline bool capturing() { return this->__capturing; }
+
+        /**
+         * Writes the capture (or the history if nothing was captured) as a Chrome trace_event JSON file.
+         *
+         * The file can be opened with chrome://tracing or Perfetto.
+         */
+        void export_trace(const std::filesystem::path& filePath);
+
+        #ifdef IMGUI
+        virtual void imgui() override;
+        #endif
+
+    private:
+        Profiler();
+
+        /**
+         * Zones of a single thread.
+         */
+        struct ThreadZones {
+            unsigned int id;
+
+            std::string name;
+
+            /**
+             * The zones (the open zones have a negative end).
+             */
+            std::vector<ProfileZone> zones;
+
+            /**
+             * The indices of the open zones.
+             */
+            std::vector<size_t> stack;
+
+            /**
+             * Set when the thread exits (the zones are removed once collected).
+             */
+            std::atomic<bool> finished;
+
+            #ifndef EMSCRIPTEN
+            std::mutex mutex;
+            #endif
+        };
+
+        /**
+         * Timestamp queries of a single GPU frame.
+         */
+        struct GpuFrame {
+            std::vector<GLuint> queries;
+
+            /**
+             * The zones (start and end are query indices until resolved).
+             */
+            std::vector<ProfileZone> zones;
+
+            size_t used;
+
+            /**
+             * When the first query was issued.
+             */
+            double issued;
+        };
+
+        /**
+         * Seconds since the profiler was created.
+         */
+        double now();
+
+        /**
+         * The zones of the calling thread (registered on first use).
+         */
+        ThreadZones& thread_zones();
+
+        /**
+         * Issues a timestamp query and returns its index in the current GPU frame.
+         */
+        size_t gpu_timestamp();
+
+        /**
+         * Reads a GPU frame into __gpu_zones (drops it if the results are not available).
+         */
+        void resolve(GpuFrame& frame);
+
+        void record(const std::vector<ProfileZone>& zones);
+
+        std::atomic<bool> __enabled;
+
+        std::atomic<bool> __capturing;
+
+        std::chrono::steady_clock::time_point __begin;
+
+        std::vector<std::shared_ptr<ThreadZones>> __threads;
+
+        unsigned int __thread_count;
+
+        std::deque<ProfileFrame> __history;
+
+        std::vector<ProfileZone> __capture;
+
+        double __frame_start;
+
+        /**
+         * Resolved GPU zones waiting for the next frame.
+         */
+        std::vector<ProfileZone> __gpu_zones;
+
+        std::vector<GpuFrame> __gpu_frames;
+
+        size_t __gpu_frame;
+
+        std::vector<size_t> __gpu_stack;
+
+        /**
+         * Are timestamp queries supported (-1 until checked)?
+         */
+        int __gpu_supported;
+
+        /**
+         * The number of GPU frames dropped because their results were late.
+         */
+        size_t __gpu_dropped;
+
+        #ifdef IMGUI
+        bool __paused;
+
+        std::vector<ProfileFrame> __paused_history;
+
+        char __trace_path[256];
+
+        std::string __status;
+        #endif
+
+        #ifndef EMSCRIPTEN
+        std::mutex __mutex;
+        #endif
+};
+
+/**
+ * Times a CPU zone until the end of the scope.
+ */
+class ProfileScope {
+    public:
+        inline ProfileScope(const char* name) :
+            __profiler(Profiler::current_profiler.get())
+        {
+            if(this->__profiler != nullptr && this->__profiler->enabled()) {
+                this->__profiler->begin_zone(name);
+            } else {
+                this->__profiler = nullptr;
+            }
+        }
+
+        inline ~ProfileScope() {
+            if(this->__profiler != nullptr) this->__profiler->end_zone();
+        }
+
+    private:
+        Profiler* __profiler;
+};
+
+/**
+ * Times a GPU zone until the end of the scope (must be on the context thread).
+ */
+class GpuProfileScope {
+    public:
+        inline GpuProfileScope(const char* name) :
+            __profiler(Profiler::current_profiler.get())
+        {
+            if(this->__profiler != nullptr && this->__profiler->enabled()) {
+                this->__profiler->begin_gpu_zone(name);
+            } else {
+                this->__profiler = nullptr;
+            }
+        }
+
+        inline ~GpuProfileScope() {
+            if(this->__profiler != nullptr) this->__profiler->end_gpu_zone();
+        }
+
+    private:
+        Profiler* __profiler;
+};
+
+/**
+ * Instrumentation macros (compiled out unless built with PROFILER).
+ */
+#ifdef PROFILER
+    #define PEPNG_PROFILE_JOIN_(a, b) a##b
+    #define PEPNG_PROFILE_JOIN(a, b) PEPNG_PROFILE_JOIN_(a, b)
+    #define PEPNG_PROFILE_SCOPE(name) ProfileScope PEPNG_PROFILE_JOIN(profile_scope_, __LINE__)(name)
+    #define PEPNG_PROFILE_GPU_SCOPE(name) GpuProfileScope PEPNG_PROFILE_JOIN(gpu_profile_scope_, __LINE__)(name)
+    #define PEPNG_PROFILE_THREAD(name) Profiler::set_thread_name(name)
+#else
+    #define PEPNG_PROFILE_SCOPE(name) ((void) 0)
+    #define PEPNG_PROFILE_GPU_SCOPE(name) ((void) 0)
+    #define PEPNG_PROFILE_THREAD(name) ((void) 0)
+#endif
+
+namespace pepng {
+    std::shared_ptr<Profiler> make_profiler();
+}
@@ -0,0 +1,173 @@
+#include "shadow_array.hpp"
+
+#include <algorithm>
+
+#include "../component/light.hpp"
+#include "../util/memory.hpp"
+
+namespace {
+    /**
+     * Makes the bound frame buffer depth only (it is incomplete with the default color buffers).
+     */
+    void depth_only() {
+        #ifdef EMSCRIPTEN
+        glDrawBuffers(0, nullptr);
+        #else
+        glDrawBuffer(GL_NONE);
+        #endif
+        glReadBuffer(GL_NONE);
+    }
+}
+
+ShadowArray::ShadowArray(GLenum target) :
+    __target(target),
+    __unit(Light::reserve_texture_unit()),
+    __texture(0),
+    __capacity(0),
+    __layered_fbo(0),
+    __copy_fbo(0),
+    __is_init(false)
+{}
+
+ShadowArray::~ShadowArray() {
+    if(!this->__is_init) return;
+
+    if(this->__layered_fbo != 0) glDeleteFramebuffers(1, &this->__layered_fbo);
+
+    glDeleteFramebuffers(1, &this->__copy_fbo);
+
+    if(!this->__face_fbos.empty()) glDeleteFramebuffers(this->__face_fbos.size(), this->__face_fbos.data());
+
+    if(this->__texture != 0) {
+        MemoryTracker::untrack(MemoryKind::SHADOW_MAP, this->__texture);
+
+        glDeleteTextures(1, &this->__texture);
+    }
+}
+
+std::shared_ptr<ShadowArray> ShadowArray::make_shadow_array(GLenum target) {
+    std::shared_ptr<ShadowArray> array(new ShadowArray(target));
+
+    return array;
+}
+
+std::shared_ptr<ShadowArray> pepng::make_shadow_array(GLenum target) {
+    return ShadowArray::make_shadow_array(target);
+}
+
+void ShadowArray::init() {
+    if(this->__is_init) return;
+
+    this->__is_init = true;
+
+    if(this->__target == GL_TEXTURE_CUBE_MAP_ARRAY) {
+        glGenFramebuffers(1, &this->__layered_fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, this->__layered_fbo);
+
+        depth_only();
+    }
+
+    glGenFramebuffers(1, &this->__copy_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->__copy_fbo);
+
+    depth_only();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+GLuint ShadowArray::make_texture(int layers) {
+    GLuint texture;
+    auto size = ShadowArray::RESOLUTION;
+
+    glGenTextures(1, &texture);
+    glBindTexture(this->__target, texture);
+
+    #ifdef EMSCRIPTEN
+    glTexImage3D(this->__target, 0, GL_DEPTH_COMPONENT24, size, size, layers * this->faces(), 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+    #else
+    glTexImage3D(this->__target, 0, GL_DEPTH_COMPONENT32, size, size, layers * this->faces(), 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    #endif
+
+    glTexParameteri(this->__target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(this->__target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(this->__target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(this->__target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(this->__target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+    MemoryTracker::track(MemoryKind::SHADOW_MAP, texture, "Shadow array", (size_t) size * size * 4 * this->faces() * layers);
+
+    return texture;
+}
+
+void ShadowArray::attach() {
+    if(this->__layered_fbo != 0) {
+        glBindFramebuffer(GL_FRAMEBUFFER, this->__layered_fbo);
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, this->__texture, 0);
+    }
+
+    size_t created = this->__face_fbos.size();
+
+    this->__face_fbos.resize(this->__capacity * this->faces());
+
+    glGenFramebuffers(this->__face_fbos.size() - created, this->__face_fbos.data() + created);
+
+    for(size_t i = 0; i < this->__face_fbos.size(); i++) {
+        glBindFramebuffer(GL_FRAMEBUFFER, this->__face_fbos.at(i));
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, this->__texture, 0, i);
+
+        if(i >= created) depth_only();
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ShadowArray::reserve(int layers) {
+    this->init();
+
+    if(layers <= this->__capacity) return;
+
+    auto previous = this->__texture;
+    auto previousCapacity = this->__capacity;
+    auto size = ShadowArray::RESOLUTION;
+
+    this->__capacity = std::max(layers, this->__capacity * 2);
+    this->__texture = this->make_texture(this->__capacity);
+
+    this->attach();
+
+    // The layers are copied, so the cached shadow maps survive the growth.
+    if(previous != 0) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, this->__copy_fbo);
+
+        for(int i = 0; i < previousCapacity * this->faces(); i++) {
+            glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, previous, 0, i);
+
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, this->__face_fbos.at(i));
+
+            glBlitFramebuffer(0, 0, size, size, 0, 0, size, size, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        MemoryTracker::untrack(MemoryKind::SHADOW_MAP, previous);
+
+        glDeleteTextures(1, &previous);
+    }
+}
+
+GLuint ShadowArray::fbo(int layer) {
+    return this->__layered_fbo != 0 ? this->__layered_fbo : this->face_fbo(layer, 0);
+}
+
+GLuint ShadowArray::face_fbo(int layer, int face) {
+    return this->__face_fbos.at(layer * this->faces() + face);
+}
+
+#ifdef IMGUI
+void ShadowArray::imgui() {
+    auto bytes = (size_t) ShadowArray::RESOLUTION * ShadowArray::RESOLUTION * 4 * this->faces() * this->__capacity;
+
+    ImGui::Text("Layers: %d", this->__capacity);
+    ImGui::Text("Memory: %.1f MB", bytes / (1024.0f * 1024.0f));
+}
+#endif
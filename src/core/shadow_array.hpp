@@ -0,0 +1,134 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "../component/light.hpp"
+
+#ifdef IMGUI
+#include <imgui.h>
+#include "../ui/with_imgui.hpp"
+#endif
+
+/**
+ * The shadow maps of a light type in the layers of a single texture (see pepng::set_shadow_arrays).
+ *
+ * A GL_TEXTURE_CUBE_MAP_ARRAY for the point lights (6 layers per light) or a GL_TEXTURE_2D_ARRAY for the spotlights,
+ * indexed by the light slot (e.g. u_pointlights[i] is the cube map i), so one texture unit and one bind serve every light of the type.
+ *
+ * The lights render directly into their layer (see ShadowArray::fbo): a spotlight through a frame buffer of its layer, a point light
+ * through the whole array attached layered, where the shadow geometry shader offsets gl_Layer by u_shadow_layer (the first layer of the light).
+ * The layers left alone keep their shadow maps, so the cached and time sliced shadow maps work the same.
+ * The array doubles (layers copied) when a light takes a higher slot.
+ */
+class ShadowArray
+    #ifdef IMGUI
+    : public WithImGui
+    #endif
+{
+    public:
+        /**
+         * The width and height of the shadow maps (same as the light shadow maps, so the static casters maps copy as they are).
+         */
+        static constexpr int RESOLUTION = Light::SHADOW_SIZE;
+
+        /**
+         * Shared_ptr constructor for ShadowArray (reserves its texture unit).
+         *
+         * @param target GL_TEXTURE_CUBE_MAP_ARRAY or GL_TEXTURE_2D_ARRAY.
+         */
+        static std::shared_ptr<ShadowArray> make_shadow_array(GLenum target);
+
+        ~ShadowArray();
+
+        /**
+         * Grows the array to hold at least the layers (must be called from the OpenGL thread).
+         *
+         * The frame buffers keep their names (they are attached to the new texture).
+         */
+        void reserve(int layers);
+
+        /**
+         * The frame buffer that the light of a layer renders into (the layer of a GL_TEXTURE_2D_ARRAY,
+         * or the whole GL_TEXTURE_CUBE_MAP_ARRAY attached layered, see ShadowArray::face_fbo to clear a single cube map).
+         */
+        GLuint fbo(int layer);
+
+        /**
+         * The frame buffer of a single face of a layer (face 0 for a GL_TEXTURE_2D_ARRAY).
+         */
+        GLuint face_fbo(int layer, int face);
+
+        /**
+         * The array texture target (GL_TEXTURE_CUBE_MAP_ARRAY or GL_TEXTURE_2D_ARRAY).
+         */
+        inline GLenum target() { return this->__target; }
+
+        /**
+         * Accessor for the array texture (0 until ShadowArray::reserve, changes when the array grows).
+         */
+        inline GLuint texture() { return this->__texture; }
+
+        inline GLint texture_unit() { return this->__unit; }
+
+        /**
+         * The number of texture layers of a light (6 faces for a cube map).
+         */
+        inline int faces() { return this->__target == GL_TEXTURE_2D_ARRAY ? 1 : 6; }
+
+        inline int capacity() { return this->__capacity; }
+
+        #ifdef IMGUI
+        virtual void imgui() override;
+        #endif
+
+    private:
+        ShadowArray(GLenum target);
+        ShadowArray(const ShadowArray& array) = delete;
+
+        /**
+         * Creates the layered and copy frame buffers.
+         */
+        void init();
+
+        /**
+         * Allocates a depth texture of the array target.
+         */
+        GLuint make_texture(int layers);
+
+        /**
+         * Attaches the array texture to the frame buffers (and creates the frame buffers of the new layers).
+         */
+        void attach();
+
+        GLenum __target;
+
+        GLint __unit;
+
+        GLuint __texture;
+
+        int __capacity;
+
+        /**
+         * The whole array attached layered (GL_TEXTURE_CUBE_MAP_ARRAY only).
+         */
+        GLuint __layered_fbo;
+
+        /**
+         * A frame buffer per layer face (layer * faces + face).
+         */
+        std::vector<GLuint> __face_fbos;
+
+        /**
+         * The read frame buffer of the copies when the array grows.
+         */
+        GLuint __copy_fbo;
+
+        bool __is_init;
+};
+
+namespace pepng {
+    std::shared_ptr<ShadowArray> make_shadow_array(GLenum target);
+}
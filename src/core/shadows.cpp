@@ -0,0 +1,123 @@
+#include "shadows.hpp"
+
+#include <cfloat>
+#include <algorithm>
+#include <unordered_set>
+
+ShadowScheduler::ShadowScheduler(int budget) :
+    __budget(budget),
+    __frame(0),
+    __requested(0),
+    __scheduled(0),
+    __faces(0),
+    __oldest(0)
+{}
+
+std::shared_ptr<ShadowScheduler> ShadowScheduler::make_shadow_scheduler(int budget) {
+    std::shared_ptr<ShadowScheduler> scheduler(new ShadowScheduler(budget));
+
+    return scheduler;
+}
+
+std::shared_ptr<ShadowScheduler> pepng::make_shadow_scheduler(int budget) {
+    return ShadowScheduler::make_shadow_scheduler(budget);
+}
+
+float ShadowScheduler::influence(const LightState& light, const std::vector<CameraState>& cameras) {
+    if(cameras.empty() || !cameras.front().has_transform) return 1.0f;
+
+    float range = std::max(light.far_plane, 0.001f);
+    float distance = glm::distance(light.position, cameras.front().position) - range;
+
+    return range / std::max(distance, range * 0.1f);
+}
+
+std::vector<bool> ShadowScheduler::schedule(const std::vector<LightState>& lights, const std::vector<CameraState>& cameras) {
+    this->__frame++;
+
+    std::vector<bool> scheduled(lights.size(), false);
+
+    this->__candidates.clear();
+
+    unsigned long oldest = 0;
+
+    for(size_t i = 0; i < lights.size(); i++) {
+        auto& light = lights.at(i);
+
+        if(!light.is_active || !light.shadows || light.light->is_shadow_cached(light)) continue;
+
+        ShadowCandidate candidate;
+
+        candidate.light = i;
+        candidate.cost = light.type == LightType::POINT ? 6 : 1;
+
+        auto history = this->__history.find(light.light.get());
+
+        if(history == this->__history.end()) {
+            candidate.priority = FLT_MAX;
+        } else {
+            auto age = this->__frame - history->second.frame;
+            bool moved = history->second.signature != light.static_signature;
+
+            candidate.priority = age * ShadowScheduler::influence(light, cameras) * (moved ? ShadowScheduler::MOVEMENT_WEIGHT : 1.0f);
+
+            oldest = std::max(oldest, age);
+        }
+
+        this->__candidates.push_back(candidate);
+    }
+
+    std::stable_sort(this->__candidates.begin(), this->__candidates.end(), [](const ShadowCandidate& a, const ShadowCandidate& b) {
+        return a.priority > b.priority;
+    });
+
+    size_t scheduledCount = 0;
+    int faces = 0;
+    int budget = this->__budget;
+
+    for(auto& candidate : this->__candidates) {
+        // The first light always fits, so a budget below the cost of a point light still makes progress.
+        if(budget > 0 && faces > 0 && faces + candidate.cost > budget) continue;
+
+        auto& light = lights.at(candidate.light);
+
+        scheduled.at(candidate.light) = true;
+
+        this->__history[light.light.get()] = { this->__frame, light.static_signature };
+
+        scheduledCount++;
+        faces += candidate.cost;
+    }
+
+    this->__requested = this->__candidates.size();
+    this->__scheduled = scheduledCount;
+    this->__faces = faces;
+    this->__oldest = oldest;
+
+    // Forgets the destroyed lights (and the lights without shadows, which start over when enabled again).
+    std::unordered_set<Light*> shadowed;
+
+    for(auto& light : lights) {
+        if(light.is_active && light.shadows) shadowed.insert(light.light.get());
+    }
+
+    for(auto it = this->__history.begin(); it != this->__history.end();) {
+        it = shadowed.count(it->first) ? std::next(it) : this->__history.erase(it);
+    }
+
+    return scheduled;
+}
+
+#ifdef IMGUI
+void ShadowScheduler::imgui() {
+    int budget = this->__budget;
+
+    if(ImGui::InputInt("Budget (faces)", &budget)) {
+        this->__budget = std::max(budget, 0);
+    }
+
+    ImGui::Text("Requested: %zu", this->__requested.load());
+    ImGui::Text("Rendered: %zu (%d faces)", this->__scheduled.load(), this->__faces.load());
+    ImGui::Text("Oldest: %lu frames", this->__oldest.load());
+}
+#endif
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <unordered_map>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#ifdef IMGUI
+#include <imgui.h>
+#include "../ui/with_imgui.hpp"
+#endif
+
+#include "../component/camera.hpp"
+#include "../component/light.hpp"
+
+/**
+ * Time slices the shadow map updates: only a budget of shadow map faces is rendered per frame
+ * (a point light costs 6 faces, a spotlight 1), the other lights keep their last shadow map.
+ *
+ * The lights that need an update (see Light::is_shadow_cached) are ordered by the frames since their last update,
+ * weighted by their screen influence (range over the distance to the first camera) and by movement
+ * (the light or a static caster in range moved, rather than only dynamic casters being in range).
+ * Lights that were never rendered come first, and at least one light is updated every frame.
+ * So far or unchanged lights refresh at reduced rates, but no light starves.
+ */
+class ShadowScheduler
+    #ifdef IMGUI
+    : public WithImGui
+    #endif
+{
+    public:
+        /**
+         * Weight of a light that moved (or whose static casters moved) over a light with only dynamic casters.
+         */
+        static constexpr float MOVEMENT_WEIGHT = 4.0f;
+
+        /**
+         * Shared_ptr constructor for ShadowScheduler.
+         *
+         * @param budget The shadow map faces rendered per frame (0 renders every light that needs an update).
+         */
+        static std::shared_ptr<ShadowScheduler> make_shadow_scheduler(int budget);
+
+        /**
+         * Selects the shadow maps rendered this frame (the selected lights are assumed rendered).
+         *
+         * @return Is the light (same index in lights) rendered?
+         */
+        std::vector<bool> schedule(const std::vector<LightState>& lights, const std::vector<CameraState>& cameras);
+
+        /**
+         * The screen influence of a light (its range over the distance to the first camera, at most 10 when the camera is inside).
+         */
+        static float influence(const LightState& light, const std::vector<CameraState>& cameras);
+
+        inline int budget() { return this->__budget; }
+
+        inline void set_budget(int budget) { this->__budget = budget; }
+
+        #ifdef IMGUI
+        virtual void imgui() override;
+        #endif
+
+    private:
+        ShadowScheduler(int budget);
+        ShadowScheduler(const ShadowScheduler& scheduler) = delete;
+
+        /**
+         * The last update of a light.
+         */
+        struct ShadowHistory {
+            unsigned long frame;
+            uint64_t signature;
+        };
+
+        /**
+         * Copy of a light that needs an update.
+         */
+        struct ShadowCandidate {
+            size_t light;
+            int cost;
+            float priority;
+        };
+
+        /**
+         * Edited from the ImGui window on the update thread while the render thread schedules.
+         */
+        std::atomic<int> __budget;
+
+        unsigned long __frame;
+
+        /**
+         * The last update of the lights (removed when the light is not in the schedule anymore).
+         */
+        std::unordered_map<Light*, ShadowHistory> __history;
+
+        std::vector<ShadowCandidate> __candidates;
+
+        /**
+         * The stats of the last schedule (published by the render thread for the ImGui window on the update thread).
+         */
+        std::atomic<size_t> __requested;
+
+        std::atomic<size_t> __scheduled;
+
+        std::atomic<int> __faces;
+
+        std::atomic<unsigned long> __oldest;
+};
+
+namespace pepng {
+    std::shared_ptr<ShadowScheduler> make_shadow_scheduler(int budget);
+}
@@ -0,0 +1,252 @@
+#include "snapshot.hpp"
+#include "clusters.hpp"
+
+#include <algorithm>
+#include <tuple>
+
+#ifdef IMGUI
+    #include <imgui_impl_opengl3.h>
+#endif
+
+namespace {
+    /**
+     * FNV-1a (64 bits) of the value bytes, continuing from the hash.
+     */
+    template<typename T>
+    uint64_t hash_value(uint64_t hash, const T& value) {
+        auto bytes = reinterpret_cast<const unsigned char*>(&value);
+
+        for(size_t i = 0; i < sizeof(T); i++) {
+            hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+        }
+
+        return hash;
+    }
+
+    /**
+     * The SplitMix64 finalizer (spreads the bits, so the caster hashes can be summed in any order).
+     */
+    uint64_t mix(uint64_t x) {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+
+        return x ^ (x >> 31);
+    }
+
+    /**
+     * The hash of what a draw writes into a shadow map.
+     */
+    uint64_t caster_hash(const DrawItem& draw) {
+        uint64_t hash = 0xcbf29ce484222325ull;
+
+        hash = hash_value(hash, draw.model.get());
+        hash = hash_value(hash, draw.render_mode);
+        hash = hash_value(hash, draw.world_matrix);
+
+        return mix(hash);
+    }
+
+    /**
+     * The hash of the light values used by the shadow pass.
+     */
+    uint64_t shadow_hash(const LightState& light) {
+        uint64_t hash = 0xcbf29ce484222325ull;
+
+        hash = hash_value(hash, light.position);
+        hash = hash_value(hash, light.near_plane);
+        hash = hash_value(hash, light.far_plane);
+        hash = hash_value(hash, light.matrix);
+
+        return mix(hash);
+    }
+}
+
+RenderSnapshot::RenderSnapshot() :
+    window(glm::vec2(1.0f)),
+    background_color(glm::vec3(0.0f)),
+    opaque_count(0),
+    culled(0)
+{}
+
+RenderSnapshot::~RenderSnapshot() {
+    // Never prepared (e.g. dropped by a failed render thread), so the next snapshot releases them.
+    if(!this->destroyed_lights.empty()) Light::return_destroyed(this->destroyed_lights);
+
+    #ifdef IMGUI
+    for(auto list : this->__imgui_lists) {
+        IM_DELETE(list);
+    }
+    #endif
+}
+
+std::shared_ptr<RenderSnapshot> RenderSnapshot::capture(const std::vector<std::shared_ptr<Object>>& world, glm::vec2 window, glm::vec3 backgroundColor, float alpha, bool cullLights, std::shared_ptr<LightClusters> clusters) {
+    std::shared_ptr<RenderSnapshot> snapshot(new RenderSnapshot());
+
+    snapshot->window = window;
+    snapshot->background_color = backgroundColor;
+    snapshot->clusters = clusters;
+
+    for(auto camera : Camera::cameras) {
+        if(!camera->active()) continue;
+
+        camera->projection->set_aspect(window.x / window.y);
+
+        auto state = camera->state(alpha);
+
+        state.camera = camera;
+
+        snapshot->cameras.push_back(state);
+    }
+
+    for(auto light : Light::lights) {
+        auto state = light->state(alpha);
+
+        state.light = light;
+
+        snapshot->lights.push_back(state);
+    }
+
+    snapshot->disabled_lights = LightSlots::disabled_uniforms();
+    snapshot->destroyed_lights = Light::take_destroyed();
+
+    for(auto object : world) {
+        snapshot->capture(object, alpha);
+    }
+
+    // The clustered lights are shaded through the clusters, so they are not listed.
+    std::vector<LightState> listedLights;
+
+    for(auto& light : snapshot->lights) {
+        if(clusters == nullptr || !LightClusters::is_clustered(light)) listedLights.push_back(light);
+    }
+
+    for(auto& draw : snapshot->draws) {
+        Renderer::assign_lights(draw, listedLights, cullLights);
+    }
+
+    auto transparent = std::stable_partition(snapshot->draws.begin(), snapshot->draws.end(), [](const DrawItem& draw) { return !draw.transparent; });
+
+    snapshot->opaque_count = transparent - snapshot->draws.begin();
+
+    // Groups the draws sharing a program, texture and model (e.g. prefab instances), so their binds are skipped.
+    std::stable_sort(snapshot->draws.begin(), transparent, [](const DrawItem& a, const DrawItem& b) {
+        return std::tie(a.shader_program, a.texture, a.model) < std::tie(b.shader_program, b.texture, b.model);
+    });
+
+    // Blended back to front (from the first camera).
+    if(!snapshot->cameras.empty() && snapshot->cameras.front().has_transform) {
+        auto eye = snapshot->cameras.front().position;
+
+        std::stable_sort(transparent, snapshot->draws.end(), [eye](const DrawItem& a, const DrawItem& b) {
+            return glm::distance(a.bounds_center, eye) > glm::distance(b.bounds_center, eye);
+        });
+    }
+
+    // The casters of each shadow map (draws beyond the range are clipped by its far plane, and a caster
+    // outside of a spotlight cone cannot be between the light and a lit receiver).
+    std::vector<uint64_t> casterHashes(snapshot->draws.size(), 0);
+
+    for(size_t i = 0; i < snapshot->draws.size(); i++) {
+        if(snapshot->draws.at(i).is_static) casterHashes.at(i) = caster_hash(snapshot->draws.at(i));
+    }
+
+    for(auto& light : snapshot->lights) {
+        if(!light.is_active || !light.shadows) continue;
+
+        uint64_t casters = 0;
+
+        for(size_t i = 0; i < snapshot->draws.size(); i++) {
+            auto& draw = snapshot->draws.at(i);
+
+            if(!Renderer::in_light(draw, light)) continue;
+
+            if(draw.is_static) {
+                light.static_casters.push_back(i);
+
+                casters += casterHashes.at(i);
+            } else {
+                light.dynamic_casters.push_back(i);
+            }
+        }
+
+        // The sum does not depend on the draw order, so only a moved, added or removed static caster changes it.
+        auto signature = mix(shadow_hash(light) ^ mix(casters + light.static_casters.size()));
+
+        light.static_signature = signature == 0 ? 1 : signature;
+    }
+
+    return snapshot;
+}
+
+void RenderSnapshot::prepare() {
+    for(auto& light : this->destroyed_lights) {
+        light->release_shadow_maps();
+    }
+
+    this->destroyed_lights.clear();
+
+    for(auto& light : this->lights) {
+        // Lights without shadows do not need their shadow map (it is created when shadows are enabled).
+        if(light.is_active && light.shadows) light.light->delayed_init();
+    }
+
+    for(auto& draw : this->draws) {
+        if(!draw.model->is_init()) draw.model->delayed_init();
+
+        draw.texture->gl_index();
+    }
+}
+
+void RenderSnapshot::capture(std::shared_ptr<Object> object, float alpha) {
+    if(object == nullptr) return;
+
+    for(auto renderer : object->get_components<Renderer>()) {
+        if(renderer->active()) {
+            this->draws.push_back(renderer->draw_item(alpha));
+        } else {
+            this->culled++;
+        }
+    }
+
+    for(auto child : object->children) {
+        this->capture(child, alpha);
+    }
+}
+
+#ifdef IMGUI
+void RenderSnapshot::capture_imgui(ImDrawData* drawData) {
+    if(drawData == nullptr || !drawData->Valid) return;
+
+    for(int i = 0; i < drawData->CmdListsCount; i++) {
+        this->__imgui_lists.push_back(drawData->CmdLists[i]->CloneOutput());
+    }
+
+    this->__imgui_display_position = drawData->DisplayPos;
+    this->__imgui_display_size = drawData->DisplaySize;
+    this->__imgui_framebuffer_scale = drawData->FramebufferScale;
+}
+
+void RenderSnapshot::render_imgui() {
+    if(this->__imgui_lists.empty()) return;
+
+    ImDrawData drawData;
+
+    drawData.Valid = true;
+    drawData.CmdLists = this->__imgui_lists.data();
+    drawData.CmdListsCount = this->__imgui_lists.size();
+    drawData.TotalVtxCount = 0;
+    drawData.TotalIdxCount = 0;
+
+    for(auto list : this->__imgui_lists) {
+        drawData.TotalVtxCount += list->VtxBuffer.Size;
+        drawData.TotalIdxCount += list->IdxBuffer.Size;
+    }
+
+    drawData.DisplayPos = this->__imgui_display_position;
+    drawData.DisplaySize = this->__imgui_display_size;
+    drawData.FramebufferScale = this->__imgui_framebuffer_scale;
+
+    ImGui_ImplOpenGL3_NewFrame();
+    ImGui_ImplOpenGL3_RenderDrawData(&drawData);
+}
+#endif
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#ifdef IMGUI
+    #include <imgui.h>
+#endif
+
+#include "../component/camera.hpp"
+#include "../component/light.hpp"
+#include "../component/renderer.hpp"
+#include "../object/object.hpp"
+
+class LightClusters;
+class ShadowScheduler;
+class ShadowAtlas;
+
+/**
+ * Immutable copy of the world that is needed to render a frame.
+ *
+ * The snapshot is captured after the update, so the frame can be rendered without touching live Objects
+ * (which allows rendering on another thread while the next update runs).
+ */
+class RenderSnapshot {
+    public:
+        /**
+         * The window dimension when captured.
+         */
+        glm::vec2 window;
+
+        /**
+         * The background (clear) color.
+         */
+        glm::vec3 background_color;
+
+        /**
+         * The active cameras.
+         */
+        std::vector<CameraState> cameras;
+
+        /**
+         * All lights (inactive lights are kept so they can disable their shader slot).
+         */
+        std::vector<LightState> lights;
+
+        /**
+         * The uniforms of the shader slots released by destroyed lights (set to 0 so they stop lighting).
+         */
+        std::vector<std::string> disabled_lights;
+
+        /**
+         * The lights destroyed before the capture (their shadow maps are released by prepare, after the earlier snapshots used them).
+         */
+        std::vector<std::shared_ptr<Light>> destroyed_lights;
+
+        /**
+         * The active renderers (the opaque draws first, then the transparent draws back to front).
+         */
+        std::vector<DrawItem> draws;
+
+        /**
+         * The number of opaque draws (the transparent draws start at this index).
+         */
+        size_t opaque_count;
+
+        /**
+         * The number of renderers that were not captured (inactive).
+         */
+        size_t culled;
+
+        /**
+         * The light clusters (nullptr when clustered lighting was off at the capture, see pepng::set_clustered_lighting).
+         */
+        std::shared_ptr<LightClusters> clusters;
+
+        /**
+         * The shadow map updates scheduler (nullptr without budget, see pepng::set_shadow_budget).
+         */
+        std::shared_ptr<ShadowScheduler> shadow_scheduler;
+
+        /**
+         * The spotlight shadow atlas (nullptr without atlas, see pepng::set_shadow_atlas).
+         */
+        std::shared_ptr<ShadowAtlas> shadow_atlas;
+
+        /**
+         * Captures the world (must be called from the update thread).
+         * 
+         * @param alpha The transform interpolation factor between the last two simulation states.
+         * @param cullLights Are the draw light lists limited to the lights reaching the draw (see Renderer::assign_lights)?
+         * @param clusters The light clusters, the clustered lights are left out of the draw light lists (see LightClusters::is_clustered).
+         */
+        static std::shared_ptr<RenderSnapshot> capture(const std::vector<std::shared_ptr<Object>>& world, glm::vec2 window, glm::vec3 backgroundColor, float alpha = 1.0f, bool cullLights = true, std::shared_ptr<LightClusters> clusters = nullptr);
+
+        ~RenderSnapshot();
+
+        /**
+         * Initializes the OpenGL objects of the models, textures and lights (must be called from the OpenGL thread).
+         *
+         * Releases the shadow maps of the destroyed lights first, so the initialized lights can reuse them.
+         * After prepare, the snapshot can be recorded into CommandBuffers on any thread.
+         */
+        void prepare();
+
+        #ifdef IMGUI
+        /**
+         * Copies the ImGui draw data so it can be rendered later.
+         */
+        void capture_imgui(ImDrawData* drawData);
+
+        /**
+         * Renders the copied ImGui draw data (must be called from the OpenGL thread).
+         */
+        void render_imgui();
+        #endif
+
+    private:
+        RenderSnapshot();
+        RenderSnapshot(const RenderSnapshot& snapshot) = delete;
+
+        /**
+         * Captures the object renderers and its children.
+         */
+        void capture(std::shared_ptr<Object> object, float alpha);
+
+        #ifdef IMGUI
+        /**
+         * Cloned ImGui draw lists (owned by the snapshot).
+         */
+        std::vector<ImDrawList*> __imgui_lists;
+
+        ImVec2 __imgui_display_position;
+
+        ImVec2 __imgui_display_size;
+
+        ImVec2 __imgui_framebuffer_scale;
+        #endif
+};
@@ -0,0 +1,384 @@
+#include "stats.hpp"
+
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+#include "../util/delayed_init.hpp"
+
+namespace {
+    /**
+     * Applies `function` to every counter of the pass pair.
+     */
+    template <typename Function>
+    void for_counters(PassStats& a, const PassStats& b, Function function) {
+        function(a.commands.gl_calls, b.commands.gl_calls);
+        function(a.commands.draw_calls, b.commands.draw_calls);
+        function(a.commands.skipped_binds, b.commands.skipped_binds);
+        function(a.commands.triangles, b.commands.triangles);
+        function(a.commands.program_binds, b.commands.program_binds);
+        function(a.commands.texture_binds, b.commands.texture_binds);
+        function(a.commands.vao_binds, b.commands.vao_binds);
+        function(a.commands.uniform_uploads, b.commands.uniform_uploads);
+        function(a.drawn, b.drawn);
+        function(a.culled, b.culled);
+    }
+
+    void add(PassStats& a, const PassStats& b) {
+        for_counters(a, b, [](unsigned long& x, unsigned long y) { x += y; });
+    }
+
+    PassStats make_pass(const char* name) {
+        PassStats pass {};
+
+        pass.name = name;
+
+        return pass;
+    }
+}
+
+RenderStats::RenderStats() :
+    __pass_start({}),
+    __frame_uploads(DelayedInit::uploaded_bytes()),
+    __frame_index(0),
+    __log_csv(false)
+    #ifdef IMGUI
+    , __log_path("stats.csv")
+    #endif
+{
+    this->__current = FrameStats {};
+    this->__current.total = make_pass("Total");
+}
+
+std::shared_ptr<RenderStats> RenderStats::make_render_stats() {
+    std::shared_ptr<RenderStats> stats(new RenderStats());
+
+    return stats;
+}
+
+std::shared_ptr<RenderStats> pepng::make_render_stats() {
+    return RenderStats::make_render_stats();
+}
+
+void RenderStats::begin_pass(const char* name) {
+    this->__current.passes.push_back(make_pass(name));
+
+    this->__pass_start = CommandBuffer::stats();
+}
+
+void RenderStats::end_pass(unsigned long culled) {
+    if(this->__current.passes.empty()) return;
+
+    auto& pass = this->__current.passes.back();
+    auto end = CommandBuffer::stats();
+
+    PassStats start {};
+    PassStats current {};
+
+    start.commands = this->__pass_start;
+    current.commands = end;
+
+    // The difference of the cumulative counters (drawn and culled are zero in both).
+    for_counters(current, start, [](unsigned long& x, unsigned long y) { x = x >= y ? x - y : 0; });
+
+    current.name = pass.name;
+    current.drawn = current.commands.draw_calls;
+    current.culled = culled;
+
+    add(pass, current);
+}
+
+void RenderStats::add_shadow_map() {
+    this->__current.shadow_maps++;
+}
+
+void RenderStats::add_cached_shadow_map() {
+    this->__current.cached_shadow_maps++;
+}
+
+void RenderStats::end_frame() {
+    auto uploads = DelayedInit::uploaded_bytes();
+
+    auto frame = std::move(this->__current);
+
+    frame.frame = this->__frame_index++;
+    frame.uploaded_bytes = uploads - this->__frame_uploads;
+
+    this->__frame_uploads = uploads;
+
+    for(auto& pass : frame.passes) {
+        add(frame.total, pass);
+    }
+
+    this->__current = FrameStats {};
+    this->__current.total = make_pass("Total");
+
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__mutex);
+    #endif
+
+    if(this->__log.is_open()) {
+        this->write_log(frame);
+    }
+
+    this->__history.push_back(std::move(frame));
+
+    if(this->__history.size() > RenderStats::HISTORY) {
+        this->__history.pop_front();
+    }
+}
+
+FrameStats RenderStats::last() {
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__mutex);
+    #endif
+
+    if(this->__history.empty()) {
+        FrameStats frame {};
+
+        frame.total = make_pass("Total");
+
+        return frame;
+    }
+
+    return this->__history.back();
+}
+
+FrameStats RenderStats::average() {
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__mutex);
+    #endif
+
+    FrameStats average {};
+
+    average.total = make_pass("Total");
+
+    if(this->__history.empty()) return average;
+
+    unsigned long long uploads = 0;
+
+    for(auto& frame : this->__history) {
+        for(auto& pass : frame.passes) {
+            auto it = std::find_if(average.passes.begin(), average.passes.end(), [&pass](const PassStats& p) {
+                return std::strcmp(p.name, pass.name) == 0;
+            });
+
+            if(it == average.passes.end()) {
+                average.passes.push_back(make_pass(pass.name));
+
+                it = average.passes.end() - 1;
+            }
+
+            add(*it, pass);
+        }
+
+        add(average.total, frame.total);
+
+        average.shadow_maps += frame.shadow_maps;
+        average.cached_shadow_maps += frame.cached_shadow_maps;
+        uploads += frame.uploaded_bytes;
+    }
+
+    auto count = this->__history.size();
+
+    // Rounded to the nearest integer.
+    auto divide = [count](unsigned long& x, unsigned long) { x = (x + count / 2) / count; };
+
+    for(auto& pass : average.passes) {
+        for_counters(pass, pass, divide);
+    }
+
+    for_counters(average.total, average.total, divide);
+
+    average.frame = this->__history.back().frame;
+    average.shadow_maps = (average.shadow_maps + count / 2) / count;
+    average.cached_shadow_maps = (average.cached_shadow_maps + count / 2) / count;
+    average.uploaded_bytes = uploads / count;
+
+    return average;
+}
+
+void RenderStats::set_log(const std::filesystem::path& filePath) {
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__mutex);
+    #endif
+
+    this->__log.close();
+    this->__log.clear();
+    this->__log.open(filePath);
+
+    if(!this->__log.is_open()) {
+        std::stringstream ss;
+
+        ss << "Cannot open stats log: " << filePath.string();
+
+        std::cout << ss.str() << std::endl;
+
+        throw std::runtime_error(ss.str());
+    }
+
+    this->__log_csv = filePath.extension() == ".csv";
+
+    if(this->__log_csv) {
+        this->__log << "frame,pass,draw_calls,triangles,program_binds,texture_binds,vao_binds,uniform_uploads,skipped_binds,gl_calls,drawn,culled,shadow_maps,cached_shadow_maps,uploaded_bytes" << std::endl;
+    }
+}
+
+void RenderStats::close_log() {
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__mutex);
+    #endif
+
+    this->__log.close();
+}
+
+void RenderStats::write_log(const FrameStats& frame) {
+    auto& log = this->__log;
+
+    auto csv = [&log, &frame](const PassStats& pass, bool total) {
+        log << frame.frame << "," << pass.name
+            << "," << pass.commands.draw_calls
+            << "," << pass.commands.triangles
+            << "," << pass.commands.program_binds
+            << "," << pass.commands.texture_binds
+            << "," << pass.commands.vao_binds
+            << "," << pass.commands.uniform_uploads
+            << "," << pass.commands.skipped_binds
+            << "," << pass.commands.gl_calls
+            << "," << pass.drawn
+            << "," << pass.culled
+            << "," << (total ? frame.shadow_maps : 0)
+            << "," << (total ? frame.cached_shadow_maps : 0)
+            << "," << (total ? frame.uploaded_bytes : 0) << "\n";
+    };
+
+    auto json = [&log](const PassStats& pass) {
+        log << "{\"name\":\"" << pass.name
+            << "\",\"draw_calls\":" << pass.commands.draw_calls
+            << ",\"triangles\":" << pass.commands.triangles
+            << ",\"program_binds\":" << pass.commands.program_binds
+            << ",\"texture_binds\":" << pass.commands.texture_binds
+            << ",\"vao_binds\":" << pass.commands.vao_binds
+            << ",\"uniform_uploads\":" << pass.commands.uniform_uploads
+            << ",\"skipped_binds\":" << pass.commands.skipped_binds
+            << ",\"gl_calls\":" << pass.commands.gl_calls
+            << ",\"drawn\":" << pass.drawn
+            << ",\"culled\":" << pass.culled << "}";
+    };
+
+    if(this->__log_csv) {
+        for(auto& pass : frame.passes) {
+            csv(pass, false);
+        }
+
+        csv(frame.total, true);
+    } else {
+        log << "{\"frame\":" << frame.frame
+            << ",\"shadow_maps\":" << frame.shadow_maps
+            << ",\"cached_shadow_maps\":" << frame.cached_shadow_maps
+            << ",\"uploaded_bytes\":" << frame.uploaded_bytes
+            << ",\"total\":";
+
+        json(frame.total);
+
+        log << ",\"passes\":[";
+
+        for(size_t i = 0; i < frame.passes.size(); i++) {
+            if(i > 0) log << ",";
+
+            json(frame.passes.at(i));
+        }
+
+        log << "]}\n";
+    }
+}
+
+#ifdef IMGUI
+void RenderStats::imgui() {
+    auto last = this->last();
+    auto average = this->average();
+
+    ImGui::Text("Frame %lu", last.frame);
+    ImGui::Text("Shadow maps: %lu (avg %lu)", last.shadow_maps, average.shadow_maps);
+    ImGui::Text("Cached shadow maps: %lu (avg %lu)", last.cached_shadow_maps, average.cached_shadow_maps);
+    ImGui::Text("Uploaded: %llu bytes (avg %llu)", last.uploaded_bytes, average.uploaded_bytes);
+
+    ImGui::Separator();
+
+    auto row = [](const char* label, unsigned long value, unsigned long averageValue) {
+        ImGui::Text("%s", label);
+        ImGui::NextColumn();
+        ImGui::Text("%lu", value);
+        ImGui::NextColumn();
+        ImGui::Text("%lu", averageValue);
+        ImGui::NextColumn();
+    };
+
+    auto passes = last.passes;
+
+    passes.push_back(last.total);
+
+    for(auto& pass : passes) {
+        auto it = std::find_if(average.passes.begin(), average.passes.end(), [&pass](const PassStats& p) {
+            return std::strcmp(p.name, pass.name) == 0;
+        });
+
+        auto averagePass = std::strcmp(pass.name, "Total") == 0 ? average.total : it != average.passes.end() ? *it : make_pass(pass.name);
+
+        ImGui::PushID(&pass);
+
+        if(ImGui::CollapsingHeader(pass.name)) {
+            ImGui::Columns(3);
+
+            ImGui::Text("Counter");
+            ImGui::NextColumn();
+            ImGui::Text("Last");
+            ImGui::NextColumn();
+            ImGui::Text("Average");
+            ImGui::NextColumn();
+
+            row("Draw calls", pass.commands.draw_calls, averagePass.commands.draw_calls);
+            row("Triangles", pass.commands.triangles, averagePass.commands.triangles);
+            row("Program binds", pass.commands.program_binds, averagePass.commands.program_binds);
+            row("Texture binds", pass.commands.texture_binds, averagePass.commands.texture_binds);
+            row("VAO binds", pass.commands.vao_binds, averagePass.commands.vao_binds);
+            row("Uniform uploads", pass.commands.uniform_uploads, averagePass.commands.uniform_uploads);
+            row("Skipped binds", pass.commands.skipped_binds, averagePass.commands.skipped_binds);
+            row("GL calls", pass.commands.gl_calls, averagePass.commands.gl_calls);
+            row("Drawn", pass.drawn, averagePass.drawn);
+            row("Culled", pass.culled, averagePass.culled);
+
+            ImGui::Columns(1);
+        }
+
+        ImGui::PopID();
+    }
+
+    ImGui::Separator();
+
+    ImGui::InputText("Log", this->__log_path, sizeof(this->__log_path));
+
+    ImGui::SameLine();
+
+    bool logging;
+
+    {
+        #ifndef EMSCRIPTEN
+        std::lock_guard<std::mutex> lock(this->__mutex);
+        #endif
+
+        logging = this->__log.is_open();
+    }
+
+    if(logging) {
+        if(ImGui::Button("Stop")) {
+            this->close_log();
+        }
+    } else if(ImGui::Button("Start")) {
+        try {
+            this->set_log(this->__log_path);
+        } catch(const std::exception& e) {}
+    }
+}
+#endif
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <string>
+#include <fstream>
+#include <filesystem>
+
+#ifndef EMSCRIPTEN
+#include <mutex>
+#endif
+
+#ifdef IMGUI
+#include <imgui.h>
+#include "../ui/with_imgui.hpp"
+#endif
+
+#include "../gl/command_buffer.hpp"
+
+/**
+ * The counters of a single render pass.
+ */
+struct PassStats {
+    /**
+     * The pass name (string literal).
+     */
+    const char* name;
+
+    /**
+     * The replayed commands (draw calls, triangles, binds and uniform uploads).
+     */
+    CommandStats commands;
+
+    /**
+     * The number of objects drawn.
+     */
+    unsigned long drawn;
+
+    /**
+     * The number of objects skipped (inactive or culled).
+     */
+    unsigned long culled;
+};
+
+/**
+ * The counters of a rendered frame.
+ */
+struct FrameStats {
+    unsigned long frame;
+
+    std::vector<PassStats> passes;
+
+    /**
+     * The sum of the passes.
+     */
+    PassStats total;
+
+    /**
+     * The number of shadow maps rendered.
+     */
+    unsigned long shadow_maps;
+
+    /**
+     * The number of shadow maps reused from the static casters cache (see pepng::extra::render_shadows).
+     */
+    unsigned long cached_shadow_maps;
+
+    /**
+     * The number of bytes uploaded by DelayedInit (buffers and textures).
+     */
+    unsigned long long uploaded_bytes;
+};
+
+/**
+ * Collects the rendering counters per frame and per pass.
+ *
+ * The passes and frames are recorded on the OpenGL thread, the ImGui panel can be drawn from any thread.
+ */
+class RenderStats
+    #ifdef IMGUI
+    : public WithImGui
+    #endif
+{
+    public:
+        /**
+         * Number of frames averaged.
+         */
+        static const size_t HISTORY = 120;
+
+        /**
+         * Shared_ptr constructor for RenderStats.
+         */
+        static std::shared_ptr<RenderStats> make_render_stats();
+
+        /**
+         * Starts counting a pass (the replayed CommandBuffers are counted until RenderStats::end_pass).
+         */
+        void begin_pass(const char* name);
+
+        /**
+         * Ends the current pass.
+         *
+         * @param culled The number of objects the pass skipped.
+         */
+        void end_pass(unsigned long culled = 0);
+
+        /**
+         * Counts a rendered shadow map.
+         */
+        void add_shadow_map();
+
+        /**
+         * Counts a shadow map that was not rendered (cached).
+         */
+        void add_cached_shadow_map();
+
+        /**
+         * Completes the frame (called after the buffer swap).
+         */
+        void end_frame();
+
+        /**
+         * Accessor for the last completed frame.
+         */
+        FrameStats last();
+
+        /**
+         * The average of the last RenderStats::HISTORY frames (passes are matched by name).
+         */
+        FrameStats average();
+
+        /**
+         * Logs every frame to the file (.csv writes a row per pass, other extensions write a JSON object per line).
+         */
+        void set_log(const std::filesystem::path& filePath);
+
+        /**
+         * Stops logging.
+         */
+        void close_log();
+
+        #ifdef IMGUI
+        virtual void imgui() override;
+        #endif
+
+    private:
+        RenderStats();
+
+        void write_log(const FrameStats& frame);
+
+        FrameStats __current;
+
+        /**
+         * The counters when the current pass started.
+         */
+        CommandStats __pass_start;
+
+        unsigned long long __frame_uploads;
+
+        unsigned long __frame_index;
+
+        std::deque<FrameStats> __history;
+
+        std::ofstream __log;
+
+        bool __log_csv;
+
+        #ifdef IMGUI
+        char __log_path[256];
+        #endif
+
+        #ifndef EMSCRIPTEN
+        std::mutex __mutex;
+        #endif
+};
+
+namespace pepng {
+    std::shared_ptr<RenderStats> make_render_stats();
+}
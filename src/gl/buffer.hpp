@@ -1,58 +1,168 @@
 #pragma once
 
 #include <memory>
+#include <vector>
+#include <atomic>
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
 #include "../util/delayed_init.hpp"
+#include "../util/memory.hpp"
+
+/**
+ * What a Buffer keeps on the CPU once uploaded.
+ */
+enum class Residency {
+    /**
+     * Releases the vectors after the upload (the default).
+     */
+    DISCARD,
+    /**
+     * Keeps the vectors for CPU-side uses (picking, physics...).
+     */
+    KEEP,
+    /**
+     * Keeps the vectors trimmed to their size (loaders grow them by pushing back).
+     */
+    COMPACT
+};
+
+/**
+ * The residency of an OpenGL buffer (independent of its element type).
+ */
+class BufferBase : public DelayedInit {
+    public:
+        /**
+         * Mutator for the residency of the buffers created afterwards.
+         */
+        static void set_default_residency(Residency residency) { BufferBase::__default_residency = residency; }
+
+        /**
+         * Accessor for the default residency.
+         */
+        static Residency default_residency() { return BufferBase::__default_residency; }
+
+        /**
+         * Mutator for residency (applied immediately if already uploaded).
+         */
+        void set_residency(Residency residency) {
+            this->_residency = residency;
+
+            if(this->_is_init) this->apply_residency();
+        }
+
+        /**
+         * Accessor for residency.
+         */
+        inline Residency residency() { return this->_residency; }
+
+    protected:
+        Residency _residency;
+
+        /**
+         * Releases or trims the CPU copy according to the residency.
+         */
+        virtual void apply_residency() = 0;
+
+        BufferBase() : _residency(BufferBase::__default_residency) {}
+        BufferBase(const BufferBase& buffer) : DelayedInit(buffer), _residency(buffer._residency) {}
+
+    private:
+        inline static std::atomic<Residency> __default_residency = Residency::DISCARD;
+};
 
 /**
  * Generic OpenGL buffer.
+ *
+ * The vectors and the OpenGL buffer are shared between clones (they are never modified),
+ * so cloning a model neither copies nor re-uploads its geometry.
  */
 template <typename T>
-class Buffer : public DelayedInit {
+class Buffer : public BufferBase {
     public:
         /**
-         * Shared_ptr constructor of Buffer.
+         * Shared_ptr constructor of Buffer (move the vectors in to avoid copying them).
          */
         static std::shared_ptr<Buffer<T>> make_buffer(std::vector<T> vectors, GLenum type, int index = -1, int size = -1) {
-            std::shared_ptr<Buffer<T>> buffer(new Buffer<T>(vectors, type, index, size));
+            std::shared_ptr<Buffer<T>> buffer(new Buffer<T>(std::move(vectors), type, index, size));
 
             return buffer;
         }
 
+        /**
+         * Accessor for the CPU copy of the vectors (nullptr once discarded).
+         */
+        inline std::shared_ptr<const std::vector<T>> vectors() { return this->__vectors; }
+
         /**
          * Generates the OpenGL buffer (this is delayed to run when back on parent thread).
          */
         virtual void delayed_init() override {
+            if(this->_is_init) return;
+
             DelayedInit::delayed_init();
 
-            GLuint buffer;
+            if(*this->__buffer == 0) {
+                if(this->__vectors == nullptr) return;
+
+                glGenBuffers(1, this->__buffer.get());
+                glBindBuffer(this->__type, *this->__buffer);
+                glBufferData(this->__type, this->__vectors->size() * sizeof(T), this->__vectors->data(), GL_STATIC_DRAW);
+
+                DelayedInit::count_upload(this->__vectors->size() * sizeof(T));
 
-            glGenBuffers(1, &buffer);
-            glBindBuffer(this->__type, buffer);
-            glBufferData(this->__type, this->__vectors.size() * sizeof(T), &this->__vectors[0], GL_STATIC_DRAW);
+                // Named after the model being initialized (see MemoryScope).
+                auto name = MemoryTracker::scope_name("Buffer");
+
+                MemoryTracker::track(MemoryKind::BUFFER, *this->__buffer, name, this->__vectors->size() * sizeof(T));
+                MemoryTracker::track(MemoryKind::CPU_COPY, this->__vectors.get(), name, this->__vectors->capacity() * sizeof(T));
+            } else {
+                // Already uploaded by a clone, only the vertex array of this model needs it.
+                glBindBuffer(this->__type, *this->__buffer);
+            }
 
             if(this->__index >= 0) {
                 glVertexAttribPointer(
-                    this->__index, 
-                    this->__size, 
-                    GL_FLOAT, 
-                    GL_FALSE, 
-                    0, 
+                    this->__index,
+                    this->__size,
+                    GL_FLOAT,
+                    GL_FALSE,
+                    0,
                     0
                 );
 
                 glEnableVertexAttribArray(this->__index);
             }
+
+            this->apply_residency();
         }
-    
+
     protected:
         virtual Buffer* clone_implementation() override {
             return new Buffer(*this);
         }
 
+        virtual void apply_residency() override {
+            if(this->__vectors == nullptr) return;
+
+            switch(this->_residency) {
+                case Residency::DISCARD:
+                    this->__vectors = nullptr;
+                    break;
+                case Residency::COMPACT:
+                    // Clones still reading the vectors keep them as they are.
+                    if(this->__vectors.use_count() == 1 && this->__vectors->capacity() > this->__vectors->size()) {
+                        this->__vectors->shrink_to_fit();
+
+                        MemoryTracker::track(MemoryKind::CPU_COPY, this->__vectors.get(), MemoryTracker::scope_name("Buffer"), this->__vectors->capacity() * sizeof(T));
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
     private:
         /**
          * The OpenGL buffer type.
@@ -67,32 +177,48 @@ class Buffer : public DelayedInit {
          */
         int __size;
         /**
-         * The raw vector of points for the buffer.
+         * The raw vector of points for the buffer (shared with clones, untracked when the last one releases it).
          */
-        std::vector<T> __vectors;
+        std::shared_ptr<std::vector<T>> __vectors;
+        /**
+         * The OpenGL buffer (shared with clones, 0 until one of them uploads it).
+         */
+        std::shared_ptr<GLuint> __buffer;
+
+        Buffer(std::vector<T>&& vectors, GLenum type, int index = -1, int size = -1) :
+            __type(type),
+            __index(index),
+            __size(size),
+            __buffer(std::make_shared<GLuint>(0))
+        {
+            this->__vectors = std::shared_ptr<std::vector<T>>(
+                new std::vector<T>(std::move(vectors)),
+                [](std::vector<T>* vectors) {
+                    MemoryTracker::untrack(MemoryKind::CPU_COPY, vectors);
 
-        Buffer(std::vector<T> vectors, GLenum type, int index = -1, int size = -1) : 
-            __vectors(vectors), 
-            __type(type), 
-            __index(index), 
-            __size(size) 
-        {}
+                    delete vectors;
+                }
+            );
+
+            MemoryTracker::track(MemoryKind::CPU_COPY, this->__vectors.get(), MemoryTracker::scope_name("Buffer"), this->__vectors->capacity() * sizeof(T));
+        }
 
         Buffer(const Buffer& buffer) :
-            DelayedInit(buffer),
+            BufferBase(buffer),
             __type(buffer.__type),
             __index(buffer.__index),
-            __size(buffer.__size)
+            __size(buffer.__size),
+            __vectors(buffer.__vectors),
+            __buffer(buffer.__buffer)
         {
-            for(auto e : buffer.__vectors) {
-                this->__vectors.push_back(e);
-            }
+            // The clone binds the shared buffer to its own vertex array.
+            this->_is_init = false;
         }
 };
 
 namespace pepng {
     template <typename T>
     std::shared_ptr<Buffer<T>> make_buffer(std::vector<T> vectors, GLenum type, int index = -1, int size = -1) {
-        return Buffer<T>::make_buffer(vectors, type, index, size);
+        return Buffer<T>::make_buffer(std::move(vectors), type, index, size);
     }
 }
\ No newline at end of file
@@ -0,0 +1,442 @@
+#include "command_buffer.hpp"
+
+#include <cstring>
+
+namespace {
+    /**
+     * Hash that allows string_view lookups in string keyed maps.
+     */
+    struct UniformNameHash {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>()(name); }
+    };
+
+    /**
+     * Uniform locations per program (only accessed from the OpenGL thread, cleared by CommandBuffer::forget_program).
+     */
+    std::unordered_map<GLuint, std::unordered_map<std::string, GLint, UniformNameHash, std::equal_to<>>> UNIFORM_LOCATIONS;
+
+    /**
+     * The number of triangles drawn by `count` vertices.
+     */
+    unsigned long triangle_count(GLenum mode, GLsizei count) {
+        switch(mode) {
+            case GL_TRIANGLES:
+                return count / 3;
+            case GL_TRIANGLE_STRIP:
+            case GL_TRIANGLE_FAN:
+                return count > 2 ? count - 2 : 0;
+            default:
+                return 0;
+        }
+    }
+}
+
+std::atomic<unsigned long> CommandBuffer::__gl_calls(0);
+std::atomic<unsigned long> CommandBuffer::__draw_calls(0);
+std::atomic<unsigned long> CommandBuffer::__skipped_binds(0);
+std::atomic<unsigned long> CommandBuffer::__triangles(0);
+std::atomic<unsigned long> CommandBuffer::__program_binds(0);
+std::atomic<unsigned long> CommandBuffer::__texture_binds(0);
+std::atomic<unsigned long> CommandBuffer::__vao_binds(0);
+std::atomic<unsigned long> CommandBuffer::__uniform_uploads(0);
+
+CommandBuffer::CommandBuffer() {}
+
+std::shared_ptr<CommandBuffer> CommandBuffer::make_command_buffer() {
+    std::shared_ptr<CommandBuffer> commandBuffer(new CommandBuffer());
+
+    return commandBuffer;
+}
+
+std::shared_ptr<CommandBuffer> pepng::make_command_buffer() {
+    return CommandBuffer::make_command_buffer();
+}
+
+void CommandBuffer::bind_framebuffer(GLuint framebuffer) {
+    Command command {};
+
+    command.type = CommandType::BIND_FRAMEBUFFER;
+    command.object = framebuffer;
+
+    this->__commands.push_back(command);
+}
+
+void CommandBuffer::disable_color_buffers() {
+    Command command {};
+
+    command.type = CommandType::DISABLE_COLOR_BUFFERS;
+
+    this->__commands.push_back(command);
+}
+
+void CommandBuffer::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    Command command {};
+
+    command.type = CommandType::VIEWPORT;
+    command.params[0] = x;
+    command.params[1] = y;
+    command.params[2] = width;
+    command.params[3] = height;
+
+    this->__commands.push_back(command);
+}
+
+void CommandBuffer::scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+    Command command {};
+
+    command.type = CommandType::SCISSOR;
+    command.params[0] = x;
+    command.params[1] = y;
+    command.params[2] = width;
+    command.params[3] = height;
+
+    this->__commands.push_back(command);
+}
+
+void CommandBuffer::clear(GLbitfield mask) {
+    Command command {};
+
+    command.type = CommandType::CLEAR;
+    command.object = mask;
+
+    this->__commands.push_back(command);
+}
+
+void CommandBuffer::use_program(GLuint program) {
+    Command command {};
+
+    command.type = CommandType::USE_PROGRAM;
+    command.object = program;
+
+    this->__commands.push_back(command);
+}
+
+void CommandBuffer::bind_texture(GLint unit, GLenum target, GLuint texture) {
+    Command command {};
+
+    command.type = CommandType::BIND_TEXTURE;
+    command.target = target;
+    command.object = texture;
+    command.params[0] = unit;
+
+    this->__commands.push_back(command);
+}
+
+void CommandBuffer::bind_vao(GLuint vao) {
+    Command command {};
+
+    command.type = CommandType::BIND_VAO;
+    command.object = vao;
+
+    this->__commands.push_back(command);
+}
+
+Command& CommandBuffer::push_uniform(CommandType type, const char* name) {
+    Command command {};
+
+    command.type = type;
+    command.name = this->__names.size();
+
+    this->__names.insert(this->__names.end(), name, name + std::strlen(name) + 1);
+
+    this->__commands.push_back(command);
+
+    return this->__commands.back();
+}
+
+unsigned int CommandBuffer::push_data(const float* values, size_t count) {
+    unsigned int offset = this->__data.size();
+
+    this->__data.insert(this->__data.end(), values, values + count);
+
+    return offset;
+}
+
+void CommandBuffer::uniform(const char* name, GLint value) {
+    this->push_uniform(CommandType::UNIFORM_INT, name).params[0] = value;
+}
+
+void CommandBuffer::uniform(const char* name, GLfloat value) {
+    auto offset = this->push_data(&value, 1);
+
+    this->push_uniform(CommandType::UNIFORM_FLOAT, name).data = offset;
+}
+
+void CommandBuffer::uniform(const char* name, const glm::vec3& value) {
+    auto offset = this->push_data(glm::value_ptr(value), 3);
+
+    auto& command = this->push_uniform(CommandType::UNIFORM_VEC3, name);
+
+    command.data = offset;
+    command.params[0] = 1;
+}
+
+void CommandBuffer::uniform(const char* name, const glm::mat4* values, GLsizei count) {
+    auto offset = this->push_data(glm::value_ptr(values[0]), 16 * count);
+
+    auto& command = this->push_uniform(CommandType::UNIFORM_MAT4, name);
+
+    command.data = offset;
+    command.params[0] = count;
+}
+
+void CommandBuffer::uniform(const std::string& name, GLint value) {
+    this->uniform(name.c_str(), value);
+}
+
+void CommandBuffer::uniform(const std::string& name, GLfloat value) {
+    this->uniform(name.c_str(), value);
+}
+
+void CommandBuffer::uniform(const std::string& name, const glm::vec3& value) {
+    this->uniform(name.c_str(), value);
+}
+
+void CommandBuffer::uniform(const std::string& name, const glm::mat4* values, GLsizei count) {
+    this->uniform(name.c_str(), values, count);
+}
+
+void CommandBuffer::draw_arrays(GLenum mode, GLint first, GLsizei count) {
+    Command command {};
+
+    command.type = CommandType::DRAW_ARRAYS;
+    command.target = mode;
+    command.params[0] = first;
+    command.params[1] = count;
+
+    this->__commands.push_back(command);
+}
+
+void CommandBuffer::draw_elements(GLenum mode, GLsizei count) {
+    Command command {};
+
+    command.type = CommandType::DRAW_ELEMENTS;
+    command.target = mode;
+    command.params[1] = count;
+
+    this->__commands.push_back(command);
+}
+
+void CommandBuffer::append(const CommandBuffer& commands) {
+    unsigned int nameOffset = this->__names.size();
+    unsigned int dataOffset = this->__data.size();
+
+    this->__names.insert(this->__names.end(), commands.__names.begin(), commands.__names.end());
+    this->__data.insert(this->__data.end(), commands.__data.begin(), commands.__data.end());
+
+    for(auto command : commands.__commands) {
+        command.name += nameOffset;
+        command.data += dataOffset;
+
+        this->__commands.push_back(command);
+    }
+}
+
+void CommandBuffer::reset() {
+    this->__commands.clear();
+    this->__names.clear();
+    this->__data.clear();
+}
+
+void CommandBuffer::forget_program(GLuint program) {
+    UNIFORM_LOCATIONS.erase(program);
+}
+
+GLint CommandBuffer::uniform_location(GLuint program, std::string_view name) {
+    auto& locations = UNIFORM_LOCATIONS[program];
+
+    auto it = locations.find(name);
+
+    if(it != locations.end()) {
+        return it->second;
+    }
+
+    std::string key(name);
+
+    GLint location = glGetUniformLocation(program, key.c_str());
+
+    locations[key] = location;
+
+    return location;
+}
+
+void CommandBuffer::replay() const {
+    GLuint program = 0;
+    bool hasProgram = false;
+    GLuint vao = 0;
+    bool hasVao = false;
+    std::unordered_map<GLint, GLuint> textures;
+    unsigned long glCalls = 0;
+    unsigned long drawCalls = 0;
+    unsigned long skippedBinds = 0;
+    unsigned long triangles = 0;
+    unsigned long programBinds = 0;
+    unsigned long textureBinds = 0;
+    unsigned long vaoBinds = 0;
+    unsigned long uniformUploads = 0;
+
+    for(auto& command : this->__commands) {
+        switch(command.type) {
+            case CommandType::BIND_FRAMEBUFFER:
+                glBindFramebuffer(GL_FRAMEBUFFER, command.object);
+                glCalls++;
+                break;
+            case CommandType::DISABLE_COLOR_BUFFERS:
+                #ifdef EMSCRIPTEN
+                glDrawBuffers(0, nullptr);
+                #else
+                glDrawBuffer(GL_NONE);
+                #endif
+                glReadBuffer(GL_NONE);
+                glCalls += 2;
+                break;
+            case CommandType::VIEWPORT:
+                glViewport(command.params[0], command.params[1], command.params[2], command.params[3]);
+                glCalls++;
+                break;
+            case CommandType::SCISSOR:
+                if(command.params[2] > 0) {
+                    glEnable(GL_SCISSOR_TEST);
+                    glScissor(command.params[0], command.params[1], command.params[2], command.params[3]);
+                    glCalls += 2;
+                } else {
+                    glDisable(GL_SCISSOR_TEST);
+                    glCalls++;
+                }
+                break;
+            case CommandType::CLEAR:
+                glClear(command.object);
+                glCalls++;
+                break;
+            case CommandType::USE_PROGRAM:
+                if(hasProgram && program == command.object) {
+                    skippedBinds++;
+                    break;
+                }
+
+                glUseProgram(command.object);
+                glCalls++;
+                programBinds++;
+
+                program = command.object;
+                hasProgram = true;
+                break;
+            case CommandType::BIND_TEXTURE: {
+                auto bound = textures.find(command.params[0]);
+
+                if(bound != textures.end() && bound->second == command.object) {
+                    skippedBinds++;
+                    break;
+                }
+
+                glActiveTexture(GL_TEXTURE0 + command.params[0]);
+                glBindTexture(command.target, command.object);
+                glCalls += 2;
+                textureBinds++;
+
+                textures[command.params[0]] = command.object;
+                break;
+            }
+            case CommandType::BIND_VAO:
+                if(hasVao && vao == command.object) {
+                    skippedBinds++;
+                    break;
+                }
+
+                glBindVertexArray(command.object);
+                glCalls++;
+                vaoBinds++;
+
+                vao = command.object;
+                hasVao = true;
+                break;
+            case CommandType::UNIFORM_INT:
+            case CommandType::UNIFORM_FLOAT:
+            case CommandType::UNIFORM_VEC3:
+            case CommandType::UNIFORM_MAT4: {
+                if(!hasProgram) {
+                    GLint current = 0;
+
+                    glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+                    glCalls++;
+
+                    program = current;
+                    hasProgram = true;
+                }
+
+                GLint location = CommandBuffer::uniform_location(program, std::string_view(&this->__names[command.name]));
+
+                if(location < 0) break;
+
+                if(command.type == CommandType::UNIFORM_INT) {
+                    glUniform1i(location, command.params[0]);
+                } else if(command.type == CommandType::UNIFORM_FLOAT) {
+                    glUniform1f(location, this->__data[command.data]);
+                } else if(command.type == CommandType::UNIFORM_VEC3) {
+                    glUniform3fv(location, command.params[0], &this->__data[command.data]);
+                } else {
+                    glUniformMatrix4fv(location, command.params[0], GL_FALSE, &this->__data[command.data]);
+                }
+
+                glCalls++;
+                uniformUploads++;
+                break;
+            }
+            case CommandType::DRAW_ARRAYS:
+                glDrawArrays(command.target, command.params[0], command.params[1]);
+                glCalls++;
+                drawCalls++;
+                triangles += triangle_count(command.target, command.params[1]);
+                break;
+            case CommandType::DRAW_ELEMENTS:
+                glDrawElements(command.target, command.params[1], GL_UNSIGNED_INT, 0);
+                glCalls++;
+                drawCalls++;
+                triangles += triangle_count(command.target, command.params[1]);
+                break;
+        }
+    }
+
+    CommandBuffer::__gl_calls += glCalls;
+    CommandBuffer::__draw_calls += drawCalls;
+    CommandBuffer::__skipped_binds += skippedBinds;
+    CommandBuffer::__triangles += triangles;
+    CommandBuffer::__program_binds += programBinds;
+    CommandBuffer::__texture_binds += textureBinds;
+    CommandBuffer::__vao_binds += vaoBinds;
+    CommandBuffer::__uniform_uploads += uniformUploads;
+}
+
+void CommandBuffer::replay(const std::vector<CommandBuffer>& commandBuffers) {
+    for(auto& commandBuffer : commandBuffers) {
+        commandBuffer.replay();
+    }
+}
+
+CommandStats CommandBuffer::stats() {
+    CommandStats stats;
+
+    stats.gl_calls = CommandBuffer::__gl_calls;
+    stats.draw_calls = CommandBuffer::__draw_calls;
+    stats.skipped_binds = CommandBuffer::__skipped_binds;
+    stats.triangles = CommandBuffer::__triangles;
+    stats.program_binds = CommandBuffer::__program_binds;
+    stats.texture_binds = CommandBuffer::__texture_binds;
+    stats.vao_binds = CommandBuffer::__vao_binds;
+    stats.uniform_uploads = CommandBuffer::__uniform_uploads;
+
+    return stats;
+}
+
+void CommandBuffer::reset_stats() {
+    CommandBuffer::__gl_calls = 0;
+    CommandBuffer::__draw_calls = 0;
+    CommandBuffer::__skipped_binds = 0;
+    CommandBuffer::__triangles = 0;
+    CommandBuffer::__program_binds = 0;
+    CommandBuffer::__texture_binds = 0;
+    CommandBuffer::__vao_binds = 0;
+    CommandBuffer::__uniform_uploads = 0;
+}
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <atomic>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+/**
+ * The type of a recorded Command.
+ */
+enum class CommandType {
+    BIND_FRAMEBUFFER,
+    DISABLE_COLOR_BUFFERS,
+    VIEWPORT,
+    SCISSOR,
+    CLEAR,
+    USE_PROGRAM,
+    BIND_TEXTURE,
+    BIND_VAO,
+    UNIFORM_INT,
+    UNIFORM_FLOAT,
+    UNIFORM_VEC3,
+    UNIFORM_MAT4,
+    DRAW_ARRAYS,
+    DRAW_ELEMENTS
+};
+
+/**
+ * A single recorded OpenGL operation (see CommandBuffer).
+ */
+struct Command {
+    CommandType type;
+    /**
+     * The texture target or the draw mode.
+     */
+    GLenum target;
+    /**
+     * The OpenGL object (program, framebuffer, texture, VAO).
+     */
+    GLuint object;
+    /**
+     * Integer parameters (viewport, scissor, texture unit, uniform value/count, draw count).
+     */
+    GLint params[4];
+    /**
+     * Offset of the uniform name in the name block.
+     */
+    unsigned int name;
+    /**
+     * Offset of the uniform values in the data block.
+     */
+    unsigned int data;
+};
+
+/**
+ * Counters of the replayed commands (see CommandBuffer::stats).
+ */
+struct CommandStats {
+    /**
+     * The number of OpenGL calls issued.
+     */
+    unsigned long gl_calls;
+    /**
+     * The number of draw calls issued.
+     */
+    unsigned long draw_calls;
+    /**
+     * The number of binds that were skipped as redundant.
+     */
+    unsigned long skipped_binds;
+    /**
+     * The number of triangles drawn (points and lines are not counted).
+     */
+    unsigned long triangles;
+    unsigned long program_binds;
+    unsigned long texture_binds;
+    unsigned long vao_binds;
+    /**
+     * The number of glUniform calls.
+     */
+    unsigned long uniform_uploads;
+};
+
+/**
+ * Backend agnostic list of rendering commands.
+ *
+ * Recording does not call OpenGL (so it can be done on worker threads),
+ * only CommandBuffer::replay needs to run on the OpenGL thread.
+ * Uniforms are recorded by name and resolved when replayed
+ * (against the program in use if the buffer does not bind one).
+ */
+class CommandBuffer {
+    public:
+        /**
+         * Shared_ptr constructor for CommandBuffer.
+         */
+        static std::shared_ptr<CommandBuffer> make_command_buffer();
+
+        CommandBuffer();
+
+        void bind_framebuffer(GLuint framebuffer);
+
+        /**
+         * Disables the color draw/read buffers of the bound framebuffer (used for depth only passes).
+         */
+        void disable_color_buffers();
+
+        void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+        /**
+         * Restricts the clears and draws to the rectangle (a width of 0 disables the scissor test).
+         */
+        void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+
+        void clear(GLbitfield mask);
+
+        void use_program(GLuint program);
+
+        /**
+         * Binds texture to the texture unit (index from GL_TEXTURE0).
+         */
+        void bind_texture(GLint unit, GLenum target, GLuint texture);
+
+        void bind_vao(GLuint vao);
+
+        void uniform(const char* name, GLint value);
+
+        void uniform(const char* name, GLfloat value);
+
+        void uniform(const char* name, const glm::vec3& value);
+
+        void uniform(const char* name, const glm::mat4* values, GLsizei count = 1);
+
+        void uniform(const std::string& name, GLint value);
+
+        void uniform(const std::string& name, GLfloat value);
+
+        void uniform(const std::string& name, const glm::vec3& value);
+
+        void uniform(const std::string& name, const glm::mat4* values, GLsizei count = 1);
+
+        void draw_arrays(GLenum mode, GLint first, GLsizei count);
+
+        void draw_elements(GLenum mode, GLsizei count);
+
+        /**
+         * Appends the commands of another buffer.
+         */
+        void append(const CommandBuffer& commands);
+
+        /**
+         * Removes all recorded commands.
+         */
+        void reset();
+
+        /**
+         * Accessor for the recorded commands.
+         */
+        inline const std::vector<Command>& commands() const { return this->__commands; }
+
+        /**
+         * Executes the commands (must be called on the OpenGL thread).
+         *
+         * Redundant program, VAO and texture binds are skipped.
+         */
+        void replay() const;
+
+        /**
+         * Executes a list of buffers in order.
+         */
+        static void replay(const std::vector<CommandBuffer>& commandBuffers);
+
+        /**
+         * Accessor for the counters of all replays since the last CommandBuffer::reset_stats.
+         */
+        static CommandStats stats();
+
+        /**
+         * Resets the replay counters.
+         */
+        static void reset_stats();
+
+        /**
+         * Drops the cached uniform locations of a program (its name is reused by the next program once deleted, see pepng::delete_shader_program).
+         */
+        static void forget_program(GLuint program);
+
+    private:
+        /**
+         * Adds a uniform command.
+         */
+        Command& push_uniform(CommandType type, const char* name);
+
+        /**
+         * Appends values to the data block.
+         *
+         * @return The offset of the values.
+         */
+        unsigned int push_data(const float* values, size_t count);
+
+        /**
+         * Resolves a uniform location (cached per program).
+         */
+        static GLint uniform_location(GLuint program, std::string_view name);
+
+        /**
+         * The recorded commands.
+         */
+        std::vector<Command> __commands;
+
+        /**
+         * Null terminated uniform names.
+         */
+        std::vector<char> __names;
+
+        /**
+         * Uniform values.
+         */
+        std::vector<float> __data;
+
+        static std::atomic<unsigned long> __gl_calls;
+
+        static std::atomic<unsigned long> __draw_calls;
+
+        static std::atomic<unsigned long> __skipped_binds;
+
+        static std::atomic<unsigned long> __triangles;
+
+        static std::atomic<unsigned long> __program_binds;
+
+        static std::atomic<unsigned long> __texture_binds;
+
+        static std::atomic<unsigned long> __vao_binds;
+
+        static std::atomic<unsigned long> __uniform_uploads;
+};
+
+namespace pepng {
+    std::shared_ptr<CommandBuffer> make_command_buffer();
+}
@@ -0,0 +1,123 @@
+#include "gbuffer.hpp"
+
+#include "../util/memory.hpp"
+
+GBuffer::GBuffer(int width, int height) :
+    __width(width),
+    __height(height),
+    __fbo(0),
+    __albedo(0),
+    __normal(0),
+    __depth(0),
+    __light_fbo(0),
+    __light(0),
+    __light_depth(0)
+{}
+
+GBuffer::~GBuffer() {
+    MemoryTracker::untrack(MemoryKind::RENDER_TARGET, this->__albedo);
+    MemoryTracker::untrack(MemoryKind::RENDER_TARGET, this->__normal);
+    MemoryTracker::untrack(MemoryKind::RENDER_TARGET, this->__depth);
+    MemoryTracker::untrack(MemoryKind::RENDER_TARGET, this->__light);
+    MemoryTracker::untrack(MemoryKind::RENDER_TARGET, ~(std::uintptr_t) this->__light_depth);
+
+    GLuint fbos[] = { this->__fbo, this->__light_fbo };
+    GLuint textures[] = { this->__albedo, this->__normal, this->__depth, this->__light };
+
+    glDeleteFramebuffers(2, fbos);
+    glDeleteTextures(4, textures);
+    glDeleteRenderbuffers(1, &this->__light_depth);
+}
+
+GLuint GBuffer::make_texture(GLint internalFormat, int width, int height, GLenum format, GLenum type) {
+    GLuint texture;
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+
+    return texture;
+}
+
+void GBuffer::check(const char* name) {
+    auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+    if(status == GL_FRAMEBUFFER_COMPLETE) return;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    std::stringstream ss;
+
+    ss << "G-buffer " << name << " " << this->__width << "x" << this->__height << " is incomplete (" << status << ").";
+
+    std::cout << ss.str() << std::endl;
+
+    throw std::runtime_error(ss.str());
+}
+
+std::shared_ptr<GBuffer> GBuffer::make_gbuffer(int width, int height) {
+    std::shared_ptr<GBuffer> gbuffer(new GBuffer(width, height));
+
+    /**
+     * Geometry
+     */
+    gbuffer->__albedo = GBuffer::make_texture(GL_RGBA8, width, height, GL_RGBA, GL_UNSIGNED_BYTE);
+    gbuffer->__normal = GBuffer::make_texture(GL_RG16F, width, height, GL_RG, GL_FLOAT);
+    gbuffer->__depth = GBuffer::make_texture(GL_DEPTH_COMPONENT24, width, height, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT);
+
+    glGenFramebuffers(1, &gbuffer->__fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, gbuffer->__fbo);
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gbuffer->__albedo, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gbuffer->__normal, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, gbuffer->__depth, 0);
+
+    GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+
+    glDrawBuffers(2, drawBuffers);
+
+    gbuffer->check("geometry");
+
+    /**
+     * Lighting (the depth is a copy, as the depth texture is sampled while the volumes are depth tested)
+     */
+    gbuffer->__light = GBuffer::make_texture(GL_RGBA8, width, height, GL_RGBA, GL_UNSIGNED_BYTE);
+
+    glGenRenderbuffers(1, &gbuffer->__light_depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, gbuffer->__light_depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+    glGenFramebuffers(1, &gbuffer->__light_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, gbuffer->__light_fbo);
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gbuffer->__light, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, gbuffer->__light_depth);
+
+    gbuffer->check("lighting");
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    std::stringstream name;
+
+    name << "G-buffer " << width << "x" << height;
+
+    auto pixels = (unsigned long long) width * height;
+
+    // The depth renderbuffer is keyed by its complement so it cannot collide with a texture name (see RenderTarget).
+    MemoryTracker::track(MemoryKind::RENDER_TARGET, gbuffer->__albedo, name.str(), pixels * 4);
+    MemoryTracker::track(MemoryKind::RENDER_TARGET, gbuffer->__normal, name.str(), pixels * 4);
+    MemoryTracker::track(MemoryKind::RENDER_TARGET, gbuffer->__depth, name.str(), pixels * 4);
+    MemoryTracker::track(MemoryKind::RENDER_TARGET, gbuffer->__light, name.str(), pixels * 4);
+    MemoryTracker::track(MemoryKind::RENDER_TARGET, ~(std::uintptr_t) gbuffer->__light_depth, name.str(), pixels * 4);
+
+    return gbuffer;
+}
+
+std::shared_ptr<GBuffer> pepng::make_gbuffer(int width, int height) {
+    return GBuffer::make_gbuffer(width, height);
+}
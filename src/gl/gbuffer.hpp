@@ -0,0 +1,85 @@
+#pragma once
+
+#include <memory>
+#include <iostream>
+#include <sstream>
+
+#include <GL/glew.h>
+
+/**
+ * Offscreen frame buffers of the deferred shading (see DeferredShading).
+ *
+ * The geometry frame buffer holds the albedo (RGBA8), the octahedral encoded normal (RG16F) and the depth (sampled by the lighting pass).
+ * The lighting frame buffer holds the lit color (RGBA8) and a copy of the depth (tested by the light volumes and the transparent draws).
+ */
+class GBuffer {
+    public:
+        /**
+         * Shared_ptr constructor for GBuffer (must be called from the OpenGL thread).
+         *
+         * @throw If a frame buffer is incomplete.
+         */
+        static std::shared_ptr<GBuffer> make_gbuffer(int width, int height);
+
+        ~GBuffer();
+
+        /**
+         * Accessor for the geometry frame buffer (albedo, normal and depth).
+         */
+        inline GLuint fbo() { return this->__fbo; }
+
+        /**
+         * Accessor for the lighting frame buffer (lit color and depth copy).
+         */
+        inline GLuint light_fbo() { return this->__light_fbo; }
+
+        inline GLuint albedo_texture() { return this->__albedo; }
+
+        inline GLuint normal_texture() { return this->__normal; }
+
+        inline GLuint depth_texture() { return this->__depth; }
+
+        inline GLuint light_texture() { return this->__light; }
+
+        inline int width() { return this->__width; }
+
+        inline int height() { return this->__height; }
+
+    private:
+        GBuffer(int width, int height);
+        GBuffer(const GBuffer& gbuffer) = delete;
+
+        /**
+         * Creates a nearest filtered texture for an attachment.
+         */
+        static GLuint make_texture(GLint internalFormat, int width, int height, GLenum format, GLenum type);
+
+        /**
+         * Checks the bound frame buffer.
+         *
+         * @throw If the frame buffer is incomplete.
+         */
+        void check(const char* name);
+
+        int __width;
+
+        int __height;
+
+        GLuint __fbo;
+
+        GLuint __albedo;
+
+        GLuint __normal;
+
+        GLuint __depth;
+
+        GLuint __light_fbo;
+
+        GLuint __light;
+
+        GLuint __light_depth;
+};
+
+namespace pepng {
+    std::shared_ptr<GBuffer> make_gbuffer(int width, int height);
+}
@@ -4,6 +4,8 @@
  * The module hpp for OpenGL components.
  */
 #include "buffer.hpp"
+#include "command_buffer.hpp"
 #include "model.hpp"
+#include "render_target.hpp"
 #include "shader.hpp"
 #include "texture.hpp"
\ No newline at end of file
@@ -2,15 +2,19 @@
 
 Material::Material(GLuint shaderProgram, std::shared_ptr<Texture> texture) : 
     __shader_program(shaderProgram),
-    texture(texture)
+    texture(texture),
+    __transparent(false)
 {}
 
 Material::Material(const Material& material) : 
     __shader_program(material.__shader_program),
-    texture(material.texture)
+    texture(material.texture),
+    __transparent(material.__transparent)
 {}
 
 std::shared_ptr<Material> Material::make_material(GLuint shaderProgram, std::shared_ptr<Texture> texture) {
+    if(Pool::enabled()) return pepng::make_pooled<Material>(shaderProgram, texture);
+
     std::shared_ptr<Material> material(new Material(shaderProgram, texture));
 
     return material;
@@ -6,6 +6,7 @@
 
 #include "texture.hpp"
 #include "../util/cloneable.hpp"
+#include "../util/pool.hpp"
 
 /**
  * The component that hold rendering properties.
@@ -27,7 +28,19 @@ class Material : public Cloneable<Material> {
          */
         inline GLuint shader_program() { return this->__shader_program; }
 
+        /**
+         * Accessor for transparent.
+         */
+        inline bool transparent() { return this->__transparent; }
+
+        /**
+         * Mutator for transparent (transparent draws are rendered after the opaque ones, forward with deferred cameras).
+         */
+        inline void set_transparent(bool transparent) { this->__transparent = transparent; }
+
     protected:
+        friend class PoolAllocator<Material>;
+
         virtual Material* clone_implementation() override;
 
         Material(GLuint shaderProgram, std::shared_ptr<Texture> texture);
@@ -39,6 +52,8 @@ class Material : public Cloneable<Material> {
          * The OpenGL shaderProgram used.
          */
         GLuint __shader_program;
+
+        bool __transparent;
 };
 
 namespace pepng {
@@ -1,10 +1,14 @@
 #include "model.hpp"
 #include "../object/objects.hpp"
+#include "../util/memory.hpp"
 
 Model::Model() : 
     __count(-1), 
     __vao(-1), 
     __offset(glm::vec3(0.0f, 0.0f, 0.0f)), 
+    __bounds_min(glm::vec3(0.0f)),
+    __bounds_max(glm::vec3(0.0f)),
+    __has_bounds(false),
     __has_element_array(false), 
     __name("Model")
 {}
@@ -12,11 +16,17 @@ Model::Model() :
 Model::Model(const Model& model) : 
     DelayedInit(model),
     __count(model.__count),
-    __vao(model.__vao),
     __offset(model.__offset),
+    __bounds_min(model.__bounds_min),
+    __bounds_max(model.__bounds_max),
+    __has_bounds(model.__has_bounds),
     __has_element_array(model.__has_element_array),
-    __name(model.__name)
-{}
+    __name(model.__name),
+    __vao(-1)
+{
+    // The clone gets its own vertex array (over the shared buffers), so its geometry can be modified.
+    this->_is_init = false;
+}
 
 std::shared_ptr<Model> Model::make_model() {
     std::shared_ptr<Model> model(new Model());
@@ -29,10 +39,18 @@ std::shared_ptr<Model> pepng::make_model() {
 }
 
 Model* Model::clone_implementation() {
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__init_mutex);
+    #endif
+
     return new Model(*this);
 }
 
 void Model::delayed_init() {
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__init_mutex);
+    #endif
+
     if(this->_is_init) {
         return;
     }
@@ -46,14 +64,35 @@ void Model::delayed_init() {
 
     this->__vao = vao;
 
+    MemoryTracker::track(MemoryKind::VERTEX_ARRAY, vao, this->__name, 0);
+
+    // Names the buffers after the model.
+    MemoryScope scope(this->__name);
+
     for(auto child : this->_delayed_children) {
         child->delayed_init();
     }
 }
 
-std::shared_ptr<Model> Model::calculate_offset(std::vector<glm::vec3> vertexArray, std::vector<unsigned int> faceArray) {
+std::shared_ptr<Model> Model::set_residency(Residency residency) {
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__init_mutex);
+    #endif
+
+    for(auto child : this->_delayed_children) {
+        if(auto buffer = std::dynamic_pointer_cast<BufferBase>(child)) {
+            buffer->set_residency(residency);
+        }
+    }
+
+    return shared_from_this();
+}
+
+std::shared_ptr<Model> Model::calculate_offset(const std::vector<glm::vec3>& vertexArray, const std::vector<unsigned int>& faceArray) {
     int count = 0;
     glm::vec3 offset = glm::vec3(0.0f, 0.0f, 0.0f);
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
     std::unordered_set<unsigned int> seenPoints;
 
     for(auto faceIndex : faceArray) {
@@ -62,15 +101,41 @@ std::shared_ptr<Model> Model::calculate_offset(std::vector<glm::vec3> vertexArra
         }
 
         seenPoints.insert(faceIndex);
-        offset += vertexArray[faceIndex];
+
+        auto vertex = vertexArray[faceIndex];
+
+        boundsMin = count == 0 ? vertex : glm::min(boundsMin, vertex);
+        boundsMax = count == 0 ? vertex : glm::max(boundsMax, vertex);
+
+        offset += vertex;
         count++;
     }
 
     if(count > 0) {
         offset /= count;
+
+        this->__bounds_min = boundsMin;
+        this->__bounds_max = boundsMax;
+        this->__has_bounds = true;
     }
 
     this->__offset = offset;
 
+    return shared_from_this();
+}
+
+std::shared_ptr<Model> Model::calculate_bounds(const std::vector<glm::vec3>& vertexArray) {
+    if(vertexArray.empty()) return shared_from_this();
+
+    this->__bounds_min = vertexArray.front();
+    this->__bounds_max = vertexArray.front();
+
+    for(auto& vertex : vertexArray) {
+        this->__bounds_min = glm::min(this->__bounds_min, vertex);
+        this->__bounds_max = glm::max(this->__bounds_max, vertex);
+    }
+
+    this->__has_bounds = true;
+
     return shared_from_this();
 }
\ No newline at end of file
@@ -9,6 +9,10 @@
 #include <sstream>
 #include <string>
 
+#ifndef EMSCRIPTEN
+#include <mutex>
+#endif
+
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -54,6 +58,21 @@ class Model : public std::enable_shared_from_this<Model>, public DelayedInit, pu
          */
         glm::vec3 offset() { return this->__offset; }
 
+        /**
+         * Accessor for has bounds (models without bounds are lit by every light, see Renderer::assign_lights).
+         */
+        inline bool has_bounds() { return this->__has_bounds; }
+
+        /**
+         * Accessor for the minimum corner of the local bounding box.
+         */
+        inline glm::vec3 bounds_min() { return this->__bounds_min; }
+
+        /**
+         * Accessor for the maximum corner of the local bounding box.
+         */
+        inline glm::vec3 bounds_max() { return this->__bounds_max; }
+
         /**
          * Accessor for has element array.
          */
@@ -89,8 +108,21 @@ class Model : public std::enable_shared_from_this<Model>, public DelayedInit, pu
         /**
          * Calculates the geometry average position as an offset to the object.
          */
-        std::shared_ptr<Model> calculate_offset(std::vector<glm::vec3> vertexArray, std::vector<unsigned int> faceArray);
+        std::shared_ptr<Model> calculate_offset(const std::vector<glm::vec3>& vertexArray, const std::vector<unsigned int>& faceArray);
+
+        /**
+         * Calculates the local bounding box of the vertices (also done by Model::calculate_offset).
+         */
+        std::shared_ptr<Model> calculate_bounds(const std::vector<glm::vec3>& vertexArray);
 
+        /**
+         * Sets the residency of the attached buffers (see Residency, waits for a delayed init running on the render thread).
+         */
+        std::shared_ptr<Model> set_residency(Residency residency);
+
+        /**
+         * Initializes the vertex array and the buffers (holds the model lock, see Model::clone_implementation).
+         */
         virtual void delayed_init() override;
 
         /**
@@ -104,6 +136,9 @@ class Model : public std::enable_shared_from_this<Model>, public DelayedInit, pu
         }
 
     protected:
+        /**
+         * Clones the model and its buffers (waits for a delayed init running on the render thread, which writes them).
+         */
         virtual Model* clone_implementation() override;
 
         Model();
@@ -122,6 +157,12 @@ class Model : public std::enable_shared_from_this<Model>, public DelayedInit, pu
          */
         glm::vec3 __offset;
 
+        glm::vec3 __bounds_min;
+
+        glm::vec3 __bounds_max;
+
+        bool __has_bounds;
+
         /**
          * The model name.
          */
@@ -131,6 +172,13 @@ class Model : public std::enable_shared_from_this<Model>, public DelayedInit, pu
          * Variable to check if using element array.
          */
         bool __has_element_array;
+
+        #ifndef EMSCRIPTEN
+        /**
+         * Guards the initialization state and the buffers (initialized on the render thread, cloned on the update thread).
+         */
+        std::mutex __init_mutex;
+        #endif
 };
 
 namespace pepng {
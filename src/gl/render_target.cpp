@@ -0,0 +1,101 @@
+#include "render_target.hpp"
+
+#include <cstring>
+
+#include "../util/memory.hpp"
+
+std::shared_ptr<RenderTarget> RenderTarget::current_target = nullptr;
+
+RenderTarget::RenderTarget(int width, int height) :
+    __width(width),
+    __height(height),
+    __fbo(0),
+    __color(0),
+    __depth(0)
+{}
+
+RenderTarget::~RenderTarget() {
+    MemoryTracker::untrack(MemoryKind::RENDER_TARGET, this->__color);
+    MemoryTracker::untrack(MemoryKind::RENDER_TARGET, ~(std::uintptr_t) this->__depth);
+
+    glDeleteFramebuffers(1, &this->__fbo);
+    glDeleteTextures(1, &this->__color);
+    glDeleteRenderbuffers(1, &this->__depth);
+}
+
+std::shared_ptr<RenderTarget> RenderTarget::make_render_target(int width, int height) {
+    std::shared_ptr<RenderTarget> target(new RenderTarget(width, height));
+
+    glGenTextures(1, &target->__color);
+    glBindTexture(GL_TEXTURE_2D, target->__color);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    glGenRenderbuffers(1, &target->__depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, target->__depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+    glGenFramebuffers(1, &target->__fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, target->__fbo);
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target->__color, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target->__depth);
+
+    auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if(status != GL_FRAMEBUFFER_COMPLETE) {
+        std::stringstream ss;
+
+        ss << "Render target " << width << "x" << height << " is incomplete (" << status << ").";
+
+        std::cout << ss.str() << std::endl;
+
+        throw std::runtime_error(ss.str());
+    }
+
+    std::stringstream name;
+
+    name << "Render target " << width << "x" << height;
+
+    // The depth renderbuffer is keyed by its complement so it cannot collide with a color texture name.
+    MemoryTracker::track(MemoryKind::RENDER_TARGET, target->__color, name.str(), (unsigned long long) width * height * 4);
+    MemoryTracker::track(MemoryKind::RENDER_TARGET, ~(std::uintptr_t) target->__depth, name.str(), (unsigned long long) width * height * 4);
+
+    return target;
+}
+
+std::shared_ptr<RenderTarget> pepng::make_render_target(int width, int height) {
+    return RenderTarget::make_render_target(width, height);
+}
+
+GLuint RenderTarget::framebuffer() {
+    return RenderTarget::current_target == nullptr ? 0 : RenderTarget::current_target->__fbo;
+}
+
+void RenderTarget::read_pixels(std::vector<unsigned char>& pixels) {
+    size_t rowSize = this->__width * 4;
+
+    pixels.resize(rowSize * this->__height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, this->__fbo);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    glReadPixels(0, 0, this->__width, this->__height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    // OpenGL reads the bottom row first.
+    std::vector<unsigned char> row(rowSize);
+
+    for(int y = 0; y < this->__height / 2; y++) {
+        auto top = pixels.data() + y * rowSize;
+        auto bottom = pixels.data() + (this->__height - 1 - y) * rowSize;
+
+        std::memcpy(row.data(), top, rowSize);
+        std::memcpy(top, bottom, rowSize);
+        std::memcpy(bottom, row.data(), rowSize);
+    }
+}
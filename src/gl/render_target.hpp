@@ -0,0 +1,70 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <iostream>
+#include <sstream>
+
+#include <GL/glew.h>
+
+/**
+ * Offscreen color/depth frame buffer that the frame is rendered into (instead of the window).
+ */
+class RenderTarget {
+    public:
+        /**
+         * The target that the frame is rendered into (nullptr renders to the window).
+         */
+        static std::shared_ptr<RenderTarget> current_target;
+
+        /**
+         * Shared_ptr constructor for RenderTarget (must be called from the OpenGL thread).
+         *
+         * @throw If the frame buffer is incomplete.
+         */
+        static std::shared_ptr<RenderTarget> make_render_target(int width, int height);
+
+        ~RenderTarget();
+
+        /**
+         * The frame buffer of the current target (0 for the window).
+         */
+        static GLuint framebuffer();
+
+        /**
+         * Accessor for the OpenGL frame buffer.
+         */
+        inline GLuint fbo() { return this->__fbo; }
+
+        /**
+         * Accessor for the color texture (usable as a Texture index).
+         */
+        inline GLuint color_texture() { return this->__color; }
+
+        inline int width() { return this->__width; }
+
+        inline int height() { return this->__height; }
+
+        /**
+         * Reads the color buffer as RGBA rows (top row first).
+         */
+        void read_pixels(std::vector<unsigned char>& pixels);
+
+    private:
+        RenderTarget(int width, int height);
+        RenderTarget(const RenderTarget& renderTarget) = delete;
+
+        int __width;
+
+        int __height;
+
+        GLuint __fbo;
+
+        GLuint __color;
+
+        GLuint __depth;
+};
+
+namespace pepng {
+    std::shared_ptr<RenderTarget> make_render_target(int width, int height);
+}
@@ -45,4 +45,9 @@ GLuint pepng::compile_shader(const std::string shaderSource, GLenum shaderType)
 
 GLuint pepng::make_shader(std::filesystem::path filepath, GLenum shaderType) {
     return pepng::compile_shader(pepng::load_shader_file(filepath), shaderType);
-}
\ No newline at end of file
+}
+void pepng::delete_shader_program(GLuint shaderProgram) {
+    CommandBuffer::forget_program(shaderProgram);
+
+    glDeleteProgram(shaderProgram);
+}
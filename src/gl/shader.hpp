@@ -11,6 +11,8 @@
 #include <stdarg.h>
 #include <GL/glew.h>
 
+#include "command_buffer.hpp"
+
 namespace pepng {
     /**
      * Reads GLSL file during runtime.
@@ -31,8 +33,15 @@ namespace pepng {
      */
     GLuint make_shader(std::filesystem::path filepath, GLenum shaderType);
 
+    /**
+     * Deletes a shader program and its cached uniform locations (see CommandBuffer::forget_program).
+     */
+    void delete_shader_program(GLuint shaderProgram);
+
     /**
      * Creates a shader program from a list of shaders.
+     *
+     * The uniform locations cached under the program name are dropped (the name may belong to a deleted program).
      */
     template<typename... Args>
     GLuint make_shader_program(Args... shaders) {
@@ -60,6 +69,8 @@ namespace pepng {
             throw std::runtime_error(ss.str());
         }
 
+        CommandBuffer::forget_program(shaderProgram);
+
         return shaderProgram;
     }
 }
\ No newline at end of file
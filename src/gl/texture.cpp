@@ -5,7 +5,8 @@ Texture::Texture() :
     __texture_index(0),
     __width(0),
     __height(0),
-    __image(nullptr)
+    __image(nullptr),
+    __name("Texture")
 {}
 
 // TODO: Make a deep clone of the image?
@@ -14,7 +15,8 @@ Texture::Texture(const Texture& texture) :
     __texture_index(texture.__texture_index),
     __width(texture.__width),
     __height(texture.__height),
-    __image(texture.__image)
+    __image(texture.__image),
+    __name(texture.__name)
 {}
 
 void Texture::delayed_init() {
@@ -30,9 +32,13 @@ void Texture::delayed_init() {
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, this->__width, this->__height, 0, GL_RGBA, GL_UNSIGNED_BYTE, this->__image);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, this->__width, this->__height, 0, GL_RGBA, GL_UNSIGNED_BYTE, this->__image.get());
 
-    stbi_image_free(this->__image);
+    DelayedInit::count_upload((unsigned long long) this->__width * this->__height * 4);
+
+    MemoryTracker::track(MemoryKind::TEXTURE, this->__texture_index, this->__name, (unsigned long long) this->__width * this->__height * 4);
+
+    this->__image = nullptr;
 }
 
 std::shared_ptr<Texture> Texture::make_texture(const std::filesystem::path& filePath) {
@@ -47,7 +53,14 @@ std::shared_ptr<Texture> Texture::make_texture(const std::filesystem::path& file
     stbi_set_flip_vertically_on_load_thread(true);
 
     int numComponents;
-    texture->__image = stbi_load(filePathString.c_str(), &texture->__width, &texture->__height, &numComponents, STBI_rgb_alpha);
+    texture->__image = std::shared_ptr<stbi_uc>(
+        stbi_load(filePathString.c_str(), &texture->__width, &texture->__height, &numComponents, STBI_rgb_alpha),
+        [](stbi_uc* image) {
+            MemoryTracker::untrack(MemoryKind::CPU_COPY, image);
+
+            stbi_image_free(image);
+        }
+    );
 
     if (texture->__image == nullptr){
         std::cout << "Cannot load texture: " << filePath.string() << std::endl;
@@ -55,6 +68,10 @@ std::shared_ptr<Texture> Texture::make_texture(const std::filesystem::path& file
         throw std::runtime_error("Cannot load texture: " + filePath.string());
     }
 
+    texture->__name = filePath.filename().string();
+
+    MemoryTracker::track(MemoryKind::CPU_COPY, texture->__image.get(), texture->__name, (unsigned long long) texture->__width * texture->__height * 4);
+
     return texture;
 }
 
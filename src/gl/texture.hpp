@@ -9,6 +9,7 @@
 #include <GL/glew.h>
 
 #include "../util/delayed_init.hpp"
+#include "../util/memory.hpp"
 
 /**
  * Handler to read/generate textures.
@@ -55,9 +56,14 @@ class Texture : public DelayedInit {
         GLuint __texture_index;
 
         /**
-         * Pointer to STB image array.
+         * Pointer to STB image array (shared with clones, freed once uploaded or when the last Texture is destroyed).
          */
-        stbi_uc* __image;
+        std::shared_ptr<stbi_uc> __image;
+
+        /**
+         * The file name (used to tag the memory).
+         */
+        std::string __name;
 
         /**
          * Width of image.
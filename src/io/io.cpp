@@ -2,7 +2,7 @@
 
 #include <iostream>
 
-DeviceUnit::DeviceUnit(std::string name, float strength) : __name(name), _value(0.0f), _device(nullptr), _strength(strength) {}
+DeviceUnit::DeviceUnit(std::string name, float strength) : __name(name), _value(0.0f), _device(), _strength(strength) {}
 
 float DeviceUnit::value() {
     return this->_value * this->_strength;
@@ -41,9 +41,9 @@ class DeviceUnit : public std::enable_shared_from_this<DeviceUnit> {
          */
         float _strength;
         /**
-         * Parent device.
+         * Parent device (weak, as the device owns its units).
          */
-        std::shared_ptr<Device> _device;
+        std::weak_ptr<Device> _device;
 
         DeviceUnit(std::string name, float strength); 
 
@@ -1,5 +1,10 @@
 #include "object.hpp"
+
+#include <algorithm>
+#include <typeinfo>
+
 #include "../component/renderer.hpp"
+#include "../core/jobs.hpp"
 
 Object::Object(std::string name) : 
     WithComponents(),
@@ -16,6 +21,8 @@ Object::Object(const Object& object) :
 }
 
 std::shared_ptr<Object> Object::make_object(std::string name) {
+    if(Pool::enabled()) return pepng::make_pooled<Object>(name);
+
     std::shared_ptr<Object> object(new Object(name));
 
     return object;
@@ -31,9 +38,7 @@ std::shared_ptr<Object> Object::attach_child(std::shared_ptr<Object> object) {
     return std::dynamic_pointer_cast<Object>(shared_from_this());
 }
 
-void Object::update() {
-    WithComponents::update_components();
-
+glm::mat4 Object::children_matrix() {
     auto transform = this->get_component<Transform>();
 
     if(transform == nullptr) {
@@ -46,7 +51,11 @@ void Object::update() {
         throw std::runtime_error(ss.str());
     }
 
-    auto parent_matrix = transform->parent_matrix * transform->world_matrix();
+    return transform->parent_matrix * transform->world_matrix();
+}
+
+void Object::propagate_parent_matrix() {
+    auto parent_matrix = this->children_matrix();
 
     for(auto child : this->children) {
         if(child == nullptr) {
@@ -56,20 +65,107 @@ void Object::update() {
         if(auto childTransform = child->get_component<Transform>()) {
             childTransform->parent_matrix = glm::mat4(parent_matrix);
         }
+    }
+}
+
+void Object::update() {
+    WithComponents::update_components();
+
+    this->propagate_parent_matrix();
+
+    for(auto child : this->children) {
+        if(child == nullptr) {
+            continue;
+        }
 
         child->update();
     }
 }
 
+void Object::update_frame() {
+    WithComponents::update_frame_components();
+
+    this->propagate_parent_matrix();
+
+    for(auto child : this->children) {
+        if(child == nullptr) {
+            continue;
+        }
+
+        child->update_frame();
+    }
+}
+
+void Object::update_parallel(const std::vector<std::shared_ptr<Object>>& objects, std::shared_ptr<JobSystem> jobs) {
+    std::vector<std::shared_ptr<Object>> level;
+    std::vector<std::shared_ptr<Object>> next;
+
+    for(auto object : objects) {
+        if(object != nullptr) {
+            level.push_back(object);
+        }
+    }
+
+    while(!level.empty()) {
+        // Derived objects may override Object::update (their subtree is updated by it).
+        auto derived = std::stable_partition(level.begin(), level.end(), [](const std::shared_ptr<Object>& object) {
+            return typeid(*object) == typeid(Object);
+        });
+
+        for(auto it = derived; it != level.end(); it++) {
+            (*it)->update();
+        }
+
+        level.erase(derived, level.end());
+
+        for(auto object : level) {
+            object->update_components(false);
+        }
+
+        auto update_object = [&level](size_t i) {
+            auto object = level.at(i);
+
+            object->update_components(true);
+            object->propagate_parent_matrix();
+        };
+
+        size_t count = level.size();
+
+        if(jobs != nullptr && count >= Object::PARALLEL_CHILDREN) {
+            jobs->parallel_for(count, update_object, Object::PARALLEL_CHILDREN / 4);
+        } else {
+            for(size_t i = 0; i < count; i++) {
+                update_object(i);
+            }
+        }
+
+        next.clear();
+
+        for(auto object : level) {
+            for(auto child : object->children) {
+                if(child != nullptr) {
+                    next.push_back(child);
+                }
+            }
+        }
+
+        level.swap(next);
+    }
+}
+
 void Object::render(GLuint shaderProgram) {
+    this->render(shaderProgram, Light::states());
+}
+
+void Object::render(GLuint shaderProgram, const std::vector<LightState>& lights) {
     for(auto component : this->get_components()) {
         if(auto renderer = std::dynamic_pointer_cast<Renderer>(component)) {
-            renderer->render(shared_from_this(), shaderProgram);
+            renderer->render(shared_from_this(), shaderProgram, lights);
         }
     }
 
     for(auto child : this->children) {
-        child->render(shaderProgram);
+        child->render(shaderProgram, lights);
     }
 }
 
@@ -81,6 +177,18 @@ void Object::render() {
     }
 }
 
+void Object::render_custom() {
+    for(auto component : this->get_components()) {
+        if(std::dynamic_pointer_cast<Renderer>(component)) continue;
+
+        component->render(shared_from_this());
+    }
+
+    for(auto child : this->children) {
+        child->render_custom();
+    }
+}
+
 std::ostream& Object::operator_ostream(std::ostream& os) const {
     os  << "Object { " 
         << this->name
@@ -13,6 +13,9 @@
 #include "../component/transform.hpp"
 #include "../component/renderer.hpp"
 #include "../util/cloneable.hpp"
+#include "../util/pool.hpp"
+
+class JobSystem;
 
 /**
  * A generic hold of components with child/parent relationship.
@@ -44,12 +47,44 @@ class Object : public WithComponents, public Cloneable<Object> {
          */
         void for_each(std::function<void (std::shared_ptr<Object>)> callback);
 
+        /**
+         * Number of objects of a level before the parallel update splits them across workers.
+         */
+        static const size_t PARALLEL_CHILDREN = 64;
+
         virtual void update();
 
+        /**
+         * Updates the Component::per_frame components of this object and all children (once per frame with a fixed timestep).
+         */
+        void update_frame();
+
+        /**
+         * Updates the objects and their children level by level (must be called from the main thread).
+         * 
+         * For each depth, the components that are not parallel safe run on the calling thread, then the parallel safe ones
+         * run on the job system and the transforms are propagated to the next depth, so children always see their updated
+         * parent matrix (as in Object::update).
+         * Objects of a derived type are updated through their Object::update (with their children) to keep the overrides.
+         */
+        static void update_parallel(const std::vector<std::shared_ptr<Object>>& objects, std::shared_ptr<JobSystem> jobs);
+
         virtual void render();
 
         void render(GLuint shaderProgram);
 
+        /**
+         * Draws the Renderers of the object and its children with the light states of the pass (see Light::states).
+         */
+        void render(GLuint shaderProgram, const std::vector<LightState>& lights);
+
+        /**
+         * Calls Component::render of the components that are not Renderers, then of the children.
+         *
+         * The Renderers are drawn from the RenderSnapshot, so the frame only calls the render hook of the custom components.
+         */
+        void render_custom();
+
         virtual std::ostream& operator_ostream(std::ostream& os) const override;
 
         friend std::ostream& operator<<(std::ostream& os, const Object& object);
@@ -59,6 +94,20 @@ class Object : public WithComponents, public Cloneable<Object> {
         #endif
 
     protected:
+        friend class PoolAllocator<Object>;
+
+        /**
+         * Matrix that is passed down as the children parent matrix.
+         * 
+         * @throw If the object has no transform.
+         */
+        glm::mat4 children_matrix();
+
+        /**
+         * Sets the parent matrix of the children transforms.
+         */
+        void propagate_parent_matrix();
+
         Object(std::string name);
         Object(const Object& object);
 
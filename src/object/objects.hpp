@@ -1,4 +1,5 @@
 #pragma once
 
 #include "object.hpp"
-#include "camera.hpp"
\ No newline at end of file
+#include "camera.hpp"
+#include "prefab.hpp"
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "prefab.hpp"
+
+#include <typeinfo>
+
+Prefab::Prefab() {}
+
+std::shared_ptr<Prefab> Prefab::make_prefab(std::shared_ptr<Object> object) {
+    if(object == nullptr) {
+        std::cout << "Cannot make a prefab from a null object." << std::endl;
+
+        throw std::runtime_error("Cannot make a prefab from a null object.");
+    }
+
+    std::shared_ptr<Prefab> prefab(new Prefab());
+
+    prefab->add(object, -1);
+
+    return prefab;
+}
+
+std::shared_ptr<Prefab> pepng::make_prefab(std::shared_ptr<Object> object) {
+    return Prefab::make_prefab(object);
+}
+
+void Prefab::add(std::shared_ptr<Object> object, int parent) {
+    if(object == nullptr) return;
+
+    int index = this->__nodes.size();
+
+    Node node;
+
+    node.name = object->name;
+    node.parent = parent;
+    node.children = 0;
+
+    for(auto component : object->get_components()) {
+        node.components.push_back(component->instance_shared() ? component : component->clone());
+    }
+
+    this->__nodes.push_back(std::move(node));
+
+    if(parent >= 0) this->__nodes.at(parent).children++;
+
+    for(auto child : object->children) {
+        this->add(child, index);
+    }
+}
+
+std::shared_ptr<Object> Prefab::instantiate() {
+    std::vector<std::shared_ptr<Object>> objects;
+
+    objects.reserve(this->__nodes.size());
+
+    for(auto& node : this->__nodes) {
+        auto object = Object::make_object(node.name);
+
+        object->children.reserve(node.children);
+
+        for(auto& component : node.components) {
+            if(component->instance_shared()) {
+                object->attach_component(component);
+            } else if(auto renderer = std::dynamic_pointer_cast<Renderer>(component)) {
+                object->attach_component(renderer->instance());
+            } else if(Pool::enabled() && typeid(*component) == typeid(Transform)) {
+                object->attach_component(pepng::make_pooled<Transform>(*std::static_pointer_cast<Transform>(component)));
+            } else {
+                object->attach_component(component->clone());
+            }
+        }
+
+        if(node.parent >= 0) {
+            objects.at(node.parent)->attach_child(object);
+        }
+
+        objects.push_back(object);
+    }
+
+    return objects.empty() ? nullptr : objects.front();
+}
+
+std::shared_ptr<Object> Prefab::instantiate(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale) {
+    auto object = this->instantiate();
+
+    if(object == nullptr) return object;
+
+    if(auto transform = object->get_component<Transform>()) {
+        transform->position = position;
+        transform->scale = scale;
+        transform->set_rotation(rotation);
+    }
+
+    return object;
+}
+
+int Prefab::find(const std::string& name) {
+    for(size_t i = 0; i < this->__nodes.size(); i++) {
+        if(this->__nodes.at(i).name == name) return i;
+    }
+
+    return -1;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <string>
+
+#include <glm/glm.hpp>
+
+#include "object.hpp"
+
+/**
+ * A reusable Object hierarchy (e.g. a loaded asset) that spawns lightweight instances.
+ *
+ * Instances only own their per-object state (objects, transforms and stateful components).
+ * The models and materials are shared with the prefab (see Renderer::instance) and so are the
+ * components that allow it (see Component::instance_shared), so spawning costs O(nodes)
+ * whatever the mesh size, and the instances batch together when rendered.
+ */
+class Prefab {
+    public:
+        /**
+         * Shared_ptr constructor for Prefab (copies the hierarchy, so the object can be modified or discarded afterwards).
+         */
+        static std::shared_ptr<Prefab> make_prefab(std::shared_ptr<Object> object);
+
+        /**
+         * Creates an instance of the hierarchy.
+         */
+        std::shared_ptr<Object> instantiate();
+
+        /**
+         * Creates an instance of the hierarchy with the root transform overridden.
+         *
+         * @param rotation Euler rotation in degrees.
+         */
+        std::shared_ptr<Object> instantiate(glm::vec3 position, glm::vec3 rotation = glm::vec3(0.0f), glm::vec3 scale = glm::vec3(1.0f));
+
+        /**
+         * The index of the first node with the name (-1 if not found).
+         *
+         * Nodes are instantiated depth first, so the index also matches Object::for_each on an instance.
+         */
+        int find(const std::string& name);
+
+        /**
+         * Accessor for the number of nodes.
+         */
+        inline size_t size() { return this->__nodes.size(); }
+
+        /**
+         * Accessor for the root name.
+         */
+        inline std::string name() { return this->__nodes.empty() ? "" : this->__nodes.front().name; }
+
+    private:
+        /**
+         * An object of the hierarchy (parents are stored before their children).
+         */
+        struct Node {
+            std::string name;
+
+            /**
+             * The parent index (-1 for the root).
+             */
+            int parent;
+
+            size_t children;
+
+            /**
+             * The template components (not attached to any object).
+             */
+            std::vector<std::shared_ptr<Component>> components;
+        };
+
+        Prefab();
+
+        /**
+         * Copies the object and its children into the nodes.
+         */
+        void add(std::shared_ptr<Object> object, int parent);
+
+        std::vector<Node> __nodes;
+};
+
+namespace pepng {
+    std::shared_ptr<Prefab> make_prefab(std::shared_ptr<Object> object);
+}
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <memory>
+#include <atomic>
 
 #include "cloneable.hpp"
 
@@ -10,6 +11,11 @@
  */
 class DelayedInit : public Cloneable<DelayedInit> {
     public:
+        /**
+         * Virtual so clones (owned through DelayedInit) release their resources.
+         */
+        virtual ~DelayedInit() {}
+
         /**
          * Delayed the initialization to the main thread.
          */
@@ -39,6 +45,20 @@ class DelayedInit : public Cloneable<DelayedInit> {
             return this->_is_init;
         }
 
+        /**
+         * Accessor for the number of bytes uploaded to OpenGL by delayed inits since the program started.
+         */
+        static unsigned long long uploaded_bytes() {
+            return DelayedInit::__uploaded_bytes;
+        }
+
+        /**
+         * Counts bytes uploaded to OpenGL (see DelayedInit::uploaded_bytes).
+         */
+        static void count_upload(unsigned long long bytes) {
+            DelayedInit::__uploaded_bytes += bytes;
+        }
+
     protected:
         /**
          * Variable to check if the component is init.
@@ -56,4 +76,7 @@ class DelayedInit : public Cloneable<DelayedInit> {
                 this->_delayed_children.push_back(child->clone());
             }
         }
+
+    private:
+        inline static std::atomic<unsigned long long> __uploaded_bytes = 0;
 };  
\ No newline at end of file
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+
+#ifndef EMSCRIPTEN
+#include <mutex>
+#endif
+
+template <typename T>
+class SlotMap;
+
+/**
+ * Non owning reference to a value of a SlotMap (the slot index with the generation of the value).
+ *
+ * Resolving is a bounds check and a generation compare (no reference counting), and a handle to an erased value resolves to nullptr.
+ * T must provide a static `slots()` returning the SlotMap of T or of a base class of T.
+ */
+template <typename T>
+class Handle {
+    public:
+        Handle() : __index(0), __generation(0) {}
+
+        Handle(uint32_t index, uint32_t generation) : __index(index), __generation(generation) {}
+
+        /**
+         * Converts a handle of a derived class.
+         */
+        template <typename U, typename = std::enable_if_t<std::is_base_of_v<T, U>>>
+        Handle(const Handle<U>& handle) : __index(handle.index()), __generation(handle.generation()) {}
+
+        inline uint32_t index() const { return this->__index; }
+
+        inline uint32_t generation() const { return this->__generation; }
+
+        /**
+         * Was the handle never set (a set handle can still be stale, see Handle::get)?
+         */
+        inline bool is_null() const { return this->__generation == 0; }
+
+        /**
+         * Resolves the handle.
+         *
+         * @return nullptr if the value was erased (or the handle is null).
+         */
+        inline T* get() const {
+            return static_cast<T*>(T::slots().get(this->__index, this->__generation));
+        }
+
+        inline T* operator->() const { return this->get(); }
+
+        explicit operator bool() const { return this->get() != nullptr; }
+
+        bool operator==(const Handle<T>& handle) const { return this->__index == handle.__index && this->__generation == handle.__generation; }
+
+        bool operator!=(const Handle<T>& handle) const { return !(*this == handle); }
+
+    private:
+        uint32_t __index;
+        uint32_t __generation;
+};
+
+/**
+ * Stable slots of raw pointers addressed by Handle (erased slots are reused with a new generation).
+ *
+ * The slots are allocated in chunks that never move, so SlotMap::get does not lock and can run on the workers.
+ * Inserting and erasing lock (values should only be erased once nothing resolves them, e.g. after pepng::destroy).
+ */
+template <typename T>
+class SlotMap {
+    public:
+        /**
+         * Number of slots allocated at once.
+         */
+        static const size_t CHUNK_SLOTS = 4096;
+
+        /**
+         * Maximum number of chunks (CHUNK_SLOTS * MAX_CHUNKS values alive at once).
+         */
+        static const size_t MAX_CHUNKS = 4096;
+
+        SlotMap() : __size(0), __count(0) {
+            for(auto& chunk : this->__chunks) {
+                chunk.store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        SlotMap(const SlotMap& slotMap) = delete;
+
+        ~SlotMap() {
+            for(auto& chunk : this->__chunks) {
+                delete[] chunk.load(std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * Stores the value in a free slot.
+         *
+         * @throw If every slot is used.
+         */
+        Handle<T> insert(T* value) {
+            #ifndef EMSCRIPTEN
+            std::lock_guard<std::mutex> lock(this->__mutex);
+            #endif
+
+            uint32_t index;
+
+            if(!this->__free.empty()) {
+                index = this->__free.back();
+
+                this->__free.pop_back();
+            } else {
+                index = this->__size.load(std::memory_order_relaxed);
+
+                if(index % SlotMap::CHUNK_SLOTS == 0) {
+                    if(index / SlotMap::CHUNK_SLOTS >= SlotMap::MAX_CHUNKS) {
+                        std::cout << "SlotMap has no free slot." << std::endl;
+
+                        throw std::runtime_error("SlotMap has no free slot.");
+                    }
+
+                    this->__chunks[index / SlotMap::CHUNK_SLOTS].store(new Slot[SlotMap::CHUNK_SLOTS], std::memory_order_release);
+                }
+
+                this->__size.store(index + 1, std::memory_order_release);
+            }
+
+            auto& slot = this->slot(index);
+
+            slot.value.store(value, std::memory_order_release);
+
+            this->__count++;
+
+            return Handle<T>(index, slot.generation.load(std::memory_order_relaxed));
+        }
+
+        /**
+         * Clears the slot (every handle to it becomes stale).
+         */
+        void erase(Handle<T> handle) {
+            #ifndef EMSCRIPTEN
+            std::lock_guard<std::mutex> lock(this->__mutex);
+            #endif
+
+            if(handle.is_null() || handle.index() >= this->__size.load(std::memory_order_relaxed)) return;
+
+            auto& slot = this->slot(handle.index());
+
+            if(slot.generation.load(std::memory_order_relaxed) != handle.generation()) return;
+
+            slot.value.store(nullptr, std::memory_order_relaxed);
+
+            auto generation = handle.generation() + 1;
+
+            // Generation 0 is the null handle.
+            slot.generation.store(generation == 0 ? 1 : generation, std::memory_order_release);
+
+            this->__free.push_back(handle.index());
+
+            this->__count--;
+        }
+
+        /**
+         * Resolves a slot.
+         *
+         * @return nullptr if the slot was erased since the generation.
+         */
+        inline T* get(uint32_t index, uint32_t generation) const {
+            if(generation == 0 || index >= this->__size.load(std::memory_order_acquire)) return nullptr;
+
+            auto& slot = this->slot(index);
+
+            auto value = slot.value.load(std::memory_order_acquire);
+
+            // Checked after the load, so a value erased in between is not returned.
+            if(slot.generation.load(std::memory_order_acquire) != generation) return nullptr;
+
+            return value;
+        }
+
+        inline T* get(Handle<T> handle) const { return this->get(handle.index(), handle.generation()); }
+
+        /**
+         * Accessor for the number of values.
+         */
+        inline size_t size() const { return this->__count; }
+
+        /**
+         * Accessor for the number of slots (used or free).
+         */
+        inline size_t capacity() const { return this->__size; }
+
+    private:
+        struct Slot {
+            std::atomic<T*> value;
+            std::atomic<uint32_t> generation;
+
+            Slot() : value(nullptr), generation(1) {}
+        };
+
+        inline Slot& slot(uint32_t index) const {
+            return this->__chunks[index / SlotMap::CHUNK_SLOTS].load(std::memory_order_acquire)[index % SlotMap::CHUNK_SLOTS];
+        }
+
+        std::array<std::atomic<Slot*>, MAX_CHUNKS> __chunks;
+
+        std::vector<uint32_t> __free;
+
+        std::atomic<uint32_t> __size;
+
+        std::atomic<size_t> __count;
+
+        #ifndef EMSCRIPTEN
+        std::mutex __mutex;
+        #endif
+};
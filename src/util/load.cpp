@@ -9,6 +9,8 @@ void pepng::load_set_object_shader(GLuint shader) { pepng::OBJECT_SHADER = shade
 void pepng::load_set_shadow_shader(GLuint shader) { pepng::SHADOW_SHADER = shader; }
 
 void pepng::extra::obj_load_model(std::filesystem::path path, std::function<void(std::shared_ptr<Model>)> function) {
+    PEPNG_PROFILE_SCOPE("OBJ");
+
     std::ifstream in(path);
 
     if(!in.is_open()) {
@@ -60,9 +62,9 @@ void pepng::extra::obj_load_model(std::filesystem::path path, std::function<void
                     ->set_name(name)
                     ->set_count(mapVertex.size())
                     ->calculate_offset(verticies, vertexIndex)
-                    ->attach_buffer(pepng::make_buffer<glm::vec3>(mapVertex, GL_ARRAY_BUFFER, 0, 3))
-                    ->attach_buffer(pepng::make_buffer<glm::vec3>(mapNormal, GL_ARRAY_BUFFER, 1, 3))
-                    ->attach_buffer(pepng::make_buffer<glm::vec2>(mapTexture, GL_ARRAY_BUFFER, 2, 2))
+                    ->attach_buffer(pepng::make_buffer<glm::vec3>(std::move(mapVertex), GL_ARRAY_BUFFER, 0, 3))
+                    ->attach_buffer(pepng::make_buffer<glm::vec3>(std::move(mapNormal), GL_ARRAY_BUFFER, 1, 3))
+                    ->attach_buffer(pepng::make_buffer<glm::vec2>(std::move(mapTexture), GL_ARRAY_BUFFER, 2, 2))
             );
 
             vertexIndex.clear();
@@ -148,6 +150,8 @@ void pepng::extra::obj_load(
 }
 
 std::shared_ptr<Texture> loadTexture(std::filesystem::path path) {
+    PEPNG_PROFILE_SCOPE("Texture");
+
     return pepng::make_texture(path);
 }
 
@@ -155,6 +159,8 @@ std::map<std::string, std::shared_ptr<Texture>> pepng::extra::collada_load_textu
     tinyxml2::XMLElement* libraryImages, 
     std::filesystem::path path
 ) {
+    PEPNG_PROFILE_SCOPE("COLLADA textures");
+
     #ifdef EMSCRIPTEN
         std::map<std::string, std::shared_ptr<Texture>> textures;
     #else
@@ -200,6 +206,8 @@ std::map<std::string, std::shared_ptr<Texture>> pepng::extra::collada_load_effec
     tinyxml2::XMLElement* libraryEffects, 
     std::map<std::string, std::shared_ptr<Texture>>& textures
 ) {
+    PEPNG_PROFILE_SCOPE("COLLADA effects");
+
     std::map<std::string, std::shared_ptr<Texture>> effects;
 
     if(libraryEffects == nullptr) return effects;
@@ -260,6 +268,8 @@ std::map<std::string, std::shared_ptr<Material>> pepng::extra::collada_load_mate
     tinyxml2::XMLElement* libraryMaterials, 
     std::map<std::string, std::shared_ptr<Texture>>& effects
 ) {
+    PEPNG_PROFILE_SCOPE("COLLADA materials");
+
     std::map<std::string, std::shared_ptr<Material>> materials;
 
     if(libraryMaterials == nullptr) return materials;
@@ -297,6 +307,8 @@ std::map<std::string, std::shared_ptr<Material>> pepng::extra::collada_load_mate
 std::map<std::string, std::shared_ptr<Camera>> pepng::extra::collada_load_cameras(
     tinyxml2::XMLElement* libraryCameras
 ) {
+    PEPNG_PROFILE_SCOPE("COLLADA cameras");
+
     std::map<std::string, std::shared_ptr<Camera>> cameras;
 
     if(libraryCameras == nullptr) return cameras;
@@ -339,6 +351,8 @@ std::map<std::string, std::shared_ptr<Camera>> pepng::extra::collada_load_camera
 std::map<std::string, std::shared_ptr<Model>> pepng::extra::collada_load_geometries(
     tinyxml2::XMLElement* libraryGeometries
 ) {
+    PEPNG_PROFILE_SCOPE("COLLADA geometries");
+
     std::map<std::string, std::shared_ptr<Model>> geometries;
 
     if(libraryGeometries == nullptr) return geometries;
@@ -438,7 +452,7 @@ std::map<std::string, std::shared_ptr<Model>> pepng::extra::collada_load_geometr
                 }
             }
 
-            auto buffer = pepng::make_buffer<float>(sourceBuffer, GL_ARRAY_BUFFER, offset, sourceSize);
+            auto buffer = pepng::make_buffer<float>(std::move(sourceBuffer), GL_ARRAY_BUFFER, offset, sourceSize);
 
             model->attach_buffer(buffer);
 
@@ -619,6 +633,8 @@ std::map<std::string, std::shared_ptr<Object>> pepng::extra::collada_load_scenes
     std::map<std::string, std::shared_ptr<Camera>>& cameras,
     std::map<std::string, std::shared_ptr<Material>>& materials
 ) {
+    PEPNG_PROFILE_SCOPE("COLLADA scenes");
+
     std::map<std::string, std::shared_ptr<Object>> scenes;
 
     auto scene = libraryScenes->FirstChildElement("visual_scene");
@@ -649,10 +665,38 @@ void pepng::extra::collada_load(
     std::function<void(std::shared_ptr<Object>)> function, 
     std::shared_ptr<Transform> transform
 ) {
+    ColladaTimings timings;
+
+    pepng::extra::collada_load(path, function, transform, timings);
+}
+
+void pepng::extra::collada_load(
+    std::filesystem::path path, 
+    std::function<void(std::shared_ptr<Object>)> function, 
+    std::shared_ptr<Transform> transform,
+    ColladaTimings& timings
+) {
+    PEPNG_PROFILE_SCOPE("COLLADA");
+
     #ifdef DEBUG_MODEL
         std::cout << "Loading COLLADA: " << path << std::endl;
     #endif
 
+    timings = ColladaTimings {};
+
+    auto beginTime = std::chrono::steady_clock::now();
+    auto phaseTime = beginTime;
+
+    // Returns the seconds since the previous call (or since `start`).
+    auto elapsed = [](std::chrono::steady_clock::time_point& start) {
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - start).count();
+
+        start = now;
+
+        return seconds;
+    };
+
     tinyxml2::XMLDocument doc;
 
     auto state = doc.LoadFile(path.string().c_str());
@@ -667,36 +711,69 @@ void pepng::extra::collada_load(
         throw new std::runtime_error(ss.str());
     }
 
-    const clock_t beginTime = clock();
+    timings.parse = elapsed(phaseTime);
 
     auto root = doc.RootElement();
 
+    // Times the phases that run on other threads.
+    auto timed = [elapsed](auto load, double& seconds) {
+        return [load, &seconds, elapsed](tinyxml2::XMLElement* element) {
+            auto start = std::chrono::steady_clock::now();
+            auto result = load(element);
+
+            seconds = elapsed(start);
+
+            return result;
+        };
+    };
+
     #ifndef EMSCRIPTEN
-        auto futureCameras = std::async(collada_load_cameras, root->FirstChildElement("library_cameras"));
-        auto futureGeometries = std::async(collada_load_geometries, root->FirstChildElement("library_geometries"));
+        auto futureCameras = std::async(timed(collada_load_cameras, timings.cameras), root->FirstChildElement("library_cameras"));
+        auto futureGeometries = std::async(timed(collada_load_geometries, timings.geometries), root->FirstChildElement("library_geometries"));
     #endif
 
     auto textures = collada_load_textures(root->FirstChildElement("library_images"), path);
 
+    timings.textures = elapsed(phaseTime);
+
     auto effects = collada_load_effects(root->FirstChildElement("library_effects"), textures);
 
+    timings.effects = elapsed(phaseTime);
+
     auto materials = collada_load_materials(root->FirstChildElement("library_materials"), effects);
 
+    timings.materials = elapsed(phaseTime);
+
     #ifdef EMSCRIPTEN
-        auto cameras = collada_load_cameras(root->FirstChildElement("library_cameras"));
-        auto geometries = collada_load_geometries(root->FirstChildElement("library_geometries"));
+        auto cameras = timed(collada_load_cameras, timings.cameras)(root->FirstChildElement("library_cameras"));
+        auto geometries = timed(collada_load_geometries, timings.geometries)(root->FirstChildElement("library_geometries"));
     #else
         auto cameras = futureCameras.get();
         auto geometries = futureGeometries.get();
     #endif
 
+    // The wait for the other threads is not a phase.
+    elapsed(phaseTime);
+
     auto scenes = collada_load_scenes(root->FirstChildElement("library_visual_scenes"), geometries, cameras, materials);
 
+    timings.scenes = elapsed(phaseTime);
+
     for(auto scene : scenes) {
         function(scene.second);
     }
 
+    timings.total = elapsed(beginTime);
+
     #ifdef DEBUG_MODEL
-        std::cout << "Loaded COLLADA: " << path << std::endl;
+        std::cout 
+            << "Loaded COLLADA: " << path << " in " << timings.total << "s"
+            << " (parse " << timings.parse
+            << "s, textures " << timings.textures
+            << "s, effects " << timings.effects
+            << "s, materials " << timings.materials
+            << "s, cameras " << timings.cameras
+            << "s, geometries " << timings.geometries
+            << "s, scenes " << timings.scenes << "s)" << std::endl;
     #endif
-}
\ No newline at end of file
+}
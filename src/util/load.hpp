@@ -10,6 +10,7 @@
 #include <string>
 #include <map>
 #include <functional>
+#include <chrono>
 
 #ifndef EMSCRIPTEN
 #include <thread>
@@ -23,6 +24,7 @@
 #include <tinyxml2.h>
 
 #include "utils.hpp"
+#include "../core/profiler.hpp"
 #include "../component/camera.hpp"
 #include "../gl/model.hpp"
 #include "../component/pointlight.hpp"
@@ -115,6 +117,23 @@ namespace pepng::extra {
         std::map<std::string, std::shared_ptr<Material>>& materials
     );
 
+    /**
+     * Time (in seconds) spent in each phase of collada_load.
+     * 
+     * The cameras and geometries are loaded on other threads while the textures, effects and materials load,
+     * so the phases can add up to more than the total.
+     */
+    struct ColladaTimings {
+        double parse;
+        double textures;
+        double effects;
+        double materials;
+        double cameras;
+        double geometries;
+        double scenes;
+        double total;
+    };
+
     /**
      * Loads a complete COLLADA file (calling the callbase `function` whenever an Object is loaded).
      */
@@ -124,6 +143,16 @@ namespace pepng::extra {
         std::shared_ptr<Transform> transform
     );
 
+    /**
+     * Loads a complete COLLADA file and records the time spent in each phase.
+     */
+    void collada_load(
+        std::filesystem::path path, 
+        std::function<void(std::shared_ptr<Object>)> function, 
+        std::shared_ptr<Transform> transform,
+        ColladaTimings& timings
+    );
+
     /**
      * Thread loader for Model.
      */
@@ -215,7 +244,11 @@ namespace pepng {
                 throw std::runtime_error(ss.str());
             }
 
-            std::thread thread(pepng::extra::load_file_thread<T, Args...>, path, function, args...);
+            std::thread thread([path, function, args...]() {
+                PEPNG_PROFILE_THREAD("Loader");
+
+                pepng::extra::load_file_thread<T, Args...>(path, function, args...);
+            });
 
             thread.detach();
         #endif
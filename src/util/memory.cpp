@@ -0,0 +1,219 @@
+#include "memory.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+    thread_local std::string SCOPE_NAME;
+
+    /**
+     * Formats bytes with a binary unit.
+     */
+    std::string format_bytes(unsigned long long bytes) {
+        const char* units[] = { "B", "KiB", "MiB", "GiB" };
+
+        double value = (double) bytes;
+        int unit = 0;
+
+        while(value >= 1024.0 && unit < 3) {
+            value /= 1024.0;
+            unit++;
+        }
+
+        char text[32];
+
+        std::snprintf(text, sizeof(text), unit == 0 ? "%.0f %s" : "%.2f %s", value, units[unit]);
+
+        return text;
+    }
+}
+
+MemoryTracker::MemoryTracker() {}
+
+std::shared_ptr<MemoryTracker> MemoryTracker::tracker() {
+    static auto tracker = new std::shared_ptr<MemoryTracker>(new MemoryTracker());
+
+    return *tracker;
+}
+
+std::shared_ptr<MemoryTracker> pepng::memory_tracker() {
+    return MemoryTracker::tracker();
+}
+
+void MemoryTracker::track(MemoryKind kind, std::uintptr_t id, const std::string& name, unsigned long long bytes) {
+    auto tracker = MemoryTracker::tracker();
+
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(tracker->__mutex);
+    #endif
+
+    tracker->__allocations[{ kind, id }] = MemoryAllocation { kind, name, bytes };
+}
+
+void MemoryTracker::untrack(MemoryKind kind, std::uintptr_t id) {
+    auto tracker = MemoryTracker::tracker();
+
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(tracker->__mutex);
+    #endif
+
+    tracker->__allocations.erase({ kind, id });
+}
+
+std::string MemoryTracker::scope_name(const std::string& fallback) {
+    return SCOPE_NAME.empty() ? fallback : SCOPE_NAME;
+}
+
+bool MemoryTracker::is_gpu(MemoryKind kind) {
+    return kind != MemoryKind::CPU_COPY;
+}
+
+const char* MemoryTracker::kind_name(MemoryKind kind) {
+    switch(kind) {
+        case MemoryKind::BUFFER: return "Buffers";
+        case MemoryKind::TEXTURE: return "Textures";
+        case MemoryKind::VERTEX_ARRAY: return "Vertex arrays";
+        case MemoryKind::SHADOW_MAP: return "Shadow maps";
+        case MemoryKind::RENDER_TARGET: return "Render targets";
+        case MemoryKind::CPU_COPY: return "CPU copies";
+        default: return "Unknown";
+    }
+}
+
+unsigned long long MemoryTracker::total(MemoryKind kind) {
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__mutex);
+    #endif
+
+    unsigned long long bytes = 0;
+
+    for(auto& [key, allocation] : this->__allocations) {
+        if(allocation.kind == kind) bytes += allocation.bytes;
+    }
+
+    return bytes;
+}
+
+size_t MemoryTracker::count(MemoryKind kind) {
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__mutex);
+    #endif
+
+    size_t count = 0;
+
+    for(auto& [key, allocation] : this->__allocations) {
+        if(allocation.kind == kind) count++;
+    }
+
+    return count;
+}
+
+unsigned long long MemoryTracker::gpu_total() {
+    unsigned long long bytes = 0;
+
+    for(int kind = 0; kind < (int) MemoryKind::COUNT; kind++) {
+        if(MemoryTracker::is_gpu((MemoryKind) kind)) bytes += this->total((MemoryKind) kind);
+    }
+
+    return bytes;
+}
+
+unsigned long long MemoryTracker::cpu_total() {
+    return this->total(MemoryKind::CPU_COPY);
+}
+
+std::vector<MemoryAllocation> MemoryTracker::top(size_t count) {
+    std::map<std::pair<MemoryKind, std::string>, unsigned long long> assets;
+
+    {
+        #ifndef EMSCRIPTEN
+        std::lock_guard<std::mutex> lock(this->__mutex);
+        #endif
+
+        for(auto& [key, allocation] : this->__allocations) {
+            assets[{ allocation.kind, allocation.name }] += allocation.bytes;
+        }
+    }
+
+    std::vector<MemoryAllocation> top;
+
+    for(auto& [key, bytes] : assets) {
+        top.push_back(MemoryAllocation { key.first, key.second, bytes });
+    }
+
+    std::sort(top.begin(), top.end(), [](const MemoryAllocation& a, const MemoryAllocation& b) {
+        return a.bytes > b.bytes;
+    });
+
+    if(top.size() > count) top.resize(count);
+
+    return top;
+}
+
+std::vector<MemoryAllocation> MemoryTracker::allocations() {
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__mutex);
+    #endif
+
+    std::vector<MemoryAllocation> allocations;
+
+    for(auto& [key, allocation] : this->__allocations) {
+        allocations.push_back(allocation);
+    }
+
+    return allocations;
+}
+
+#ifdef IMGUI
+void MemoryTracker::imgui() {
+    ImGui::Text("GPU: %s", format_bytes(this->gpu_total()).c_str());
+    ImGui::Text("CPU copies: %s", format_bytes(this->cpu_total()).c_str());
+
+    ImGui::Separator();
+
+    ImGui::Columns(3);
+
+    ImGui::Text("Kind");
+    ImGui::NextColumn();
+    ImGui::Text("Count");
+    ImGui::NextColumn();
+    ImGui::Text("Size");
+    ImGui::NextColumn();
+
+    for(int kind = 0; kind < (int) MemoryKind::COUNT; kind++) {
+        ImGui::Text("%s", MemoryTracker::kind_name((MemoryKind) kind));
+        ImGui::NextColumn();
+        ImGui::Text("%zu", this->count((MemoryKind) kind));
+        ImGui::NextColumn();
+        ImGui::Text("%s", format_bytes(this->total((MemoryKind) kind)).c_str());
+        ImGui::NextColumn();
+    }
+
+    ImGui::Columns(1);
+
+    if(ImGui::CollapsingHeader("Top offenders")) {
+        ImGui::Columns(3);
+
+        for(auto& allocation : this->top()) {
+            ImGui::Text("%s", allocation.name.c_str());
+            ImGui::NextColumn();
+            ImGui::Text("%s", MemoryTracker::kind_name(allocation.kind));
+            ImGui::NextColumn();
+            ImGui::Text("%s", format_bytes(allocation.bytes).c_str());
+            ImGui::NextColumn();
+        }
+
+        ImGui::Columns(1);
+    }
+}
+#endif
+
+MemoryScope::MemoryScope(const std::string& name) :
+    __previous(SCOPE_NAME)
+{
+    SCOPE_NAME = name;
+}
+
+MemoryScope::~MemoryScope() {
+    SCOPE_NAME = this->__previous;
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <map>
+#include <string>
+#include <cstdint>
+
+#ifndef EMSCRIPTEN
+#include <mutex>
+#endif
+
+#ifdef IMGUI
+#include <imgui.h>
+#include "../ui/with_imgui.hpp"
+#endif
+
+/**
+ * The kind of a tracked allocation.
+ */
+enum class MemoryKind {
+    BUFFER,
+    TEXTURE,
+    VERTEX_ARRAY,
+    SHADOW_MAP,
+    RENDER_TARGET,
+    /**
+     * CPU copies of uploaded data (buffer vectors and decoded images).
+     */
+    CPU_COPY,
+    COUNT
+};
+
+/**
+ * A tracked allocation.
+ */
+struct MemoryAllocation {
+    MemoryKind kind;
+
+    /**
+     * The asset the allocation belongs to.
+     */
+    std::string name;
+
+    unsigned long long bytes;
+};
+
+/**
+ * Records the OpenGL allocations and the CPU copies of the assets.
+ *
+ * The OpenGL allocations are keyed by their OpenGL name and the CPU copies by their address,
+ * so an allocation is counted once however many clones share it.
+ */
+class MemoryTracker
+    #ifdef IMGUI
+    : public WithImGui
+    #endif
+{
+    public:
+        /**
+         * Number of allocations listed as top offenders.
+         */
+        static const size_t TOP = 16;
+
+        /**
+         * The tracker used by the OpenGL wrappers (never destroyed, so assets released during exit can still be untracked).
+         */
+        static std::shared_ptr<MemoryTracker> tracker();
+
+        /**
+         * Records an allocation (replaces the previous one with the same kind and id).
+         */
+        static void track(MemoryKind kind, std::uintptr_t id, const std::string& name, unsigned long long bytes);
+
+        static inline void track(MemoryKind kind, const void* id, const std::string& name, unsigned long long bytes) {
+            MemoryTracker::track(kind, reinterpret_cast<std::uintptr_t>(id), name, bytes);
+        }
+
+        /**
+         * Removes an allocation.
+         */
+        static void untrack(MemoryKind kind, std::uintptr_t id);
+
+        static inline void untrack(MemoryKind kind, const void* id) {
+            MemoryTracker::untrack(kind, reinterpret_cast<std::uintptr_t>(id));
+        }
+
+        /**
+         * The name of the asset being initialized on the calling thread (see MemoryScope), or the fallback.
+         */
+        static std::string scope_name(const std::string& fallback);
+
+        /**
+         * Is the kind an OpenGL allocation?
+         */
+        static bool is_gpu(MemoryKind kind);
+
+        static const char* kind_name(MemoryKind kind);
+
+        /**
+         * The number of bytes of a kind.
+         */
+        unsigned long long total(MemoryKind kind);
+
+        /**
+         * The number of allocations of a kind.
+         */
+        size_t count(MemoryKind kind);
+
+        /**
+         * The number of bytes allocated by OpenGL.
+         */
+        unsigned long long gpu_total();
+
+        /**
+         * The number of bytes of CPU copies.
+         */
+        unsigned long long cpu_total();
+
+        /**
+         * The largest allocations per asset (sorted by size).
+         */
+        std::vector<MemoryAllocation> top(size_t count = MemoryTracker::TOP);
+
+        /**
+         * Copies every allocation.
+         */
+        std::vector<MemoryAllocation> allocations();
+
+        #ifdef IMGUI
+        virtual void imgui() override;
+        #endif
+
+    private:
+        MemoryTracker();
+
+        std::map<std::pair<MemoryKind, std::uintptr_t>, MemoryAllocation> __allocations;
+
+        #ifndef EMSCRIPTEN
+        std::mutex __mutex;
+        #endif
+};
+
+/**
+ * Names the allocations made on the calling thread until the end of the scope (e.g. the buffers of a model).
+ */
+class MemoryScope {
+    public:
+        MemoryScope(const std::string& name);
+
+        ~MemoryScope();
+
+    private:
+        std::string __previous;
+};
+
+namespace pepng {
+    /**
+     * Accessor for the memory tracker (MemoryTracker::tracker).
+     */
+    std::shared_ptr<MemoryTracker> memory_tracker();
+}
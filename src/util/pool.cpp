@@ -0,0 +1,68 @@
+#include "pool.hpp"
+
+#include <algorithm>
+
+PoolStorage::PoolStorage(size_t blockSize, size_t alignment) :
+    __alignment(std::max(alignment, alignof(FreeBlock))),
+    __free(nullptr),
+    __used(0),
+    __capacity(0)
+{
+    // Every block of a chunk must stay aligned and be able to hold the free link.
+    blockSize = std::max(blockSize, sizeof(FreeBlock));
+
+    this->__block_size = (blockSize + this->__alignment - 1) / this->__alignment * this->__alignment;
+}
+
+void* PoolStorage::allocate() {
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__mutex);
+    #endif
+
+    if(this->__free == nullptr) {
+        auto chunk = static_cast<unsigned char*>(::operator new(this->__block_size * PoolStorage::CHUNK_BLOCKS, std::align_val_t(this->__alignment)));
+
+        this->__chunks.push_back(chunk);
+
+        // Links the blocks in address order.
+        for(size_t i = PoolStorage::CHUNK_BLOCKS; i > 0; i--) {
+            auto block = reinterpret_cast<FreeBlock*>(chunk + (i - 1) * this->__block_size);
+
+            block->next = this->__free;
+
+            this->__free = block;
+        }
+
+        this->__capacity += PoolStorage::CHUNK_BLOCKS;
+
+        Pool::__reserved_bytes += this->__block_size * PoolStorage::CHUNK_BLOCKS;
+    }
+
+    auto block = this->__free;
+
+    this->__free = block->next;
+
+    this->__used++;
+
+    Pool::__used_bytes += this->__block_size;
+
+    return block;
+}
+
+void PoolStorage::deallocate(void* pointer) {
+    if(pointer == nullptr) return;
+
+    #ifndef EMSCRIPTEN
+    std::lock_guard<std::mutex> lock(this->__mutex);
+    #endif
+
+    auto block = static_cast<FreeBlock*>(pointer);
+
+    block->next = this->__free;
+
+    this->__free = block;
+
+    this->__used--;
+
+    Pool::__used_bytes -= this->__block_size;
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+#ifndef EMSCRIPTEN
+#include <mutex>
+#endif
+
+/**
+ * Fixed size blocks carved from large chunks (freed blocks are reused, chunks are never released).
+ */
+class PoolStorage {
+    public:
+        /**
+         * Number of blocks allocated at once.
+         */
+        static const size_t CHUNK_BLOCKS = 256;
+
+        PoolStorage(size_t blockSize, size_t alignment);
+
+        PoolStorage(const PoolStorage& storage) = delete;
+
+        void* allocate();
+
+        void deallocate(void* block);
+
+        /**
+         * Accessor for the number of blocks in use.
+         */
+        inline size_t used() { return this->__used; }
+
+        /**
+         * Accessor for the number of blocks allocated (used or free).
+         */
+        inline size_t capacity() { return this->__capacity; }
+
+        inline size_t block_size() { return this->__block_size; }
+
+    private:
+        /**
+         * A free block (the link is stored in the block itself).
+         */
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        size_t __block_size;
+
+        size_t __alignment;
+
+        FreeBlock* __free;
+
+        std::vector<void*> __chunks;
+
+        std::atomic<size_t> __used;
+
+        std::atomic<size_t> __capacity;
+
+        #ifndef EMSCRIPTEN
+        std::mutex __mutex;
+        #endif
+};
+
+/**
+ * Controls the pooled allocation of the factories (see PoolAllocator).
+ */
+class Pool {
+    public:
+        /**
+         * Mutator for enabled (disabled factories allocate the object and its control block separately).
+         */
+        static void set_enabled(bool enabled) { Pool::__enabled = enabled; }
+
+        /**
+         * Accessor for enabled.
+         */
+        static bool enabled() { return Pool::__enabled; }
+
+        /**
+         * The number of bytes of the blocks in use (all types).
+         */
+        static size_t used_bytes() { return Pool::__used_bytes; }
+
+        /**
+         * The number of bytes of the chunks (all types).
+         */
+        static size_t reserved_bytes() { return Pool::__reserved_bytes; }
+
+        /**
+         * The storage of the blocks of type T (one per type, never destroyed so objects released during exit can still be freed).
+         */
+        template <typename T>
+        static PoolStorage& storage() {
+            static auto storage = new PoolStorage(sizeof(T), alignof(T));
+
+            return *storage;
+        }
+
+    private:
+        friend class PoolStorage;
+
+        inline static std::atomic<bool> __enabled = true;
+
+        inline static std::atomic<size_t> __used_bytes = 0;
+
+        inline static std::atomic<size_t> __reserved_bytes = 0;
+};
+
+/**
+ * Allocator that takes single objects from the pool of their type.
+ *
+ * With std::allocate_shared, the object and its control block share one pooled block.
+ * Classes with protected constructors must befriend PoolAllocator<T> (it constructs them).
+ */
+template <typename T>
+class PoolAllocator {
+    public:
+        using value_type = T;
+
+        PoolAllocator() noexcept {}
+
+        template <typename U>
+        PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+        T* allocate(size_t count) {
+            if(count != 1) {
+                return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+            }
+
+            return static_cast<T*>(Pool::storage<T>().allocate());
+        }
+
+        void deallocate(T* pointer, size_t count) noexcept {
+            if(count != 1) {
+                ::operator delete(pointer, std::align_val_t(alignof(T)));
+
+                return;
+            }
+
+            Pool::storage<T>().deallocate(pointer);
+        }
+
+        template <typename U, typename... Args>
+        void construct(U* pointer, Args&&... args) {
+            ::new((void*) pointer) U(std::forward<Args>(args)...);
+        }
+
+        template <typename U>
+        void destroy(U* pointer) {
+            pointer->~U();
+        }
+
+        template <typename U>
+        bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+
+        template <typename U>
+        bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+};
+
+namespace pepng {
+    /**
+     * Constructs T in one pooled block with its control block (T must befriend PoolAllocator<T>).
+     */
+    template <typename T, typename... Args>
+    std::shared_ptr<T> make_pooled(Args&&... args) {
+        return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+    }
+}